@@ -0,0 +1,319 @@
+// Output composer benchmark
+// Cycles per composed report: specialized composers vs. the previous
+// runtime-branching composer (kept below as the reference).
+//
+// Build: make bench (GNU make) / nmake bench (NMAKE)
+
+#include "protocol/output_composer.h"
+#include "../include/dualsense.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define BENCH_HAS_TSC 1
+#endif
+
+using namespace dualsense;
+using namespace dualsense::protocol;
+
+namespace legacy {
+
+// Previous composer: one function per model, transport checked at runtime
+void SetTriggerEffects(unsigned char* trigger, const HapticTriggers& effect) {
+    trigger[0x0] = effect.mode;
+
+    if (effect.mode == 0x01) { // Continuous Resistance
+        trigger[0x1] = static_cast<unsigned char>((effect.strengths.active_zones >> 0) & 0xFF);
+        trigger[0x2] = static_cast<unsigned char>((effect.strengths.strength_zones >> 0) & 0xFF);
+    }
+
+    if (effect.mode == 0x21) { // Resistance
+        trigger[0x1] = 0xf0;
+        trigger[0x2] = 0x03;
+        trigger[0x3] = 0x00;
+        trigger[0x5] = effect.strengths.compose[2];
+        trigger[0x6] = effect.strengths.compose[3];
+        trigger[0x7] = 0x0;
+        trigger[0x8] = 0x0;
+        trigger[0x9] = 0x0;
+    }
+
+    if (effect.mode == 0x22 || effect.mode == 0x02) { // Bow
+        trigger[0x1] = effect.strengths.compose[0];
+        trigger[0x2] = effect.strengths.compose[1];
+        trigger[0x3] = effect.strengths.compose[2];
+        trigger[0x4] = 0x0;
+        trigger[0x5] = 0x0;
+        trigger[0x6] = 0x0;
+        trigger[0x7] = 0x0;
+        trigger[0x8] = 0x0;
+        trigger[0x9] = 0x0;
+    }
+
+    if (effect.mode == 0x23) { // Galloping
+        trigger[0x1] = effect.strengths.compose[0];
+        trigger[0x2] = effect.strengths.compose[1];
+        trigger[0x3] = effect.strengths.compose[2];
+        trigger[0x4] = effect.strengths.compose[3];
+        trigger[0x5] = 0x00;
+        trigger[0x6] = 0x00;
+        trigger[0x7] = 0x00;
+        trigger[0x8] = 0x00;
+        trigger[0x9] = 0x00;
+    }
+
+    if (effect.mode == 0x25) { // Weapon
+        trigger[0x1] = static_cast<unsigned char>((effect.strengths.active_zones >> 0) & 0xFF);
+        trigger[0x2] = static_cast<unsigned char>((effect.strengths.active_zones >> 8) & 0xFF);
+        for (int i = 0; i < 8; ++i) {
+            trigger[0x3 + i] = static_cast<unsigned char>((effect.strengths.strength_zones >> (8 * i)) & 0xFF);
+        }
+    }
+
+    if (effect.mode == 0x26) { // Automatic Gun
+        trigger[0x1] = effect.strengths.compose[0];
+        trigger[0x2] = effect.strengths.compose[1];
+        trigger[0x3] = effect.strengths.compose[2];
+        trigger[0x4] = effect.strengths.compose[3];
+        trigger[0x5] = effect.strengths.compose[4];
+        trigger[0x6] = effect.strengths.compose[5];
+        trigger[0x7] = 0x0;
+        trigger[0x8] = 0x0;
+        trigger[0x9] = effect.strengths.compose[9];
+    }
+
+    if (effect.mode == 0x27) { // Machine Advanced
+        trigger[0x1] = effect.strengths.compose[0]; // Start_Zone
+        trigger[0x2] = effect.strengths.compose[1]; // Behavior_Flag
+        trigger[0x3] = effect.strengths.compose[2]; // Force_Amplitude
+        trigger[0x4] = effect.strengths.compose[3]; // Period
+        trigger[0x5] = effect.strengths.compose[4]; // Frequency
+        trigger[0x6] = 0x00;
+        trigger[0x7] = 0x00;
+        trigger[0x8] = 0x00;
+        trigger[0x9] = 0x00;
+    }
+
+    if (effect.mode == 0xFF) { // Custom Mode effect
+        trigger[0x0] = effect.strengths.compose[0];
+        trigger[0x1] = effect.strengths.compose[1];
+        trigger[0x2] = effect.strengths.compose[2];
+        trigger[0x3] = effect.strengths.compose[3];
+        trigger[0x4] = effect.strengths.compose[4];
+        trigger[0x5] = effect.strengths.compose[5];
+        trigger[0x6] = effect.strengths.compose[6];
+        trigger[0x7] = effect.strengths.compose[7];
+        trigger[0x8] = effect.strengths.compose[8];
+        trigger[0x9] = effect.strengths.compose[9];
+    }
+
+    if (effect.mode == 0x0) { // Reset
+        trigger[0x1] = 0x0;
+        trigger[0x2] = 0x0;
+        trigger[0x3] = 0x0;
+        trigger[0x4] = 0x0;
+        trigger[0x5] = 0x0;
+        trigger[0x6] = 0x0;
+        trigger[0x7] = 0x0;
+        trigger[0x8] = 0x0;
+        trigger[0x9] = 0x0;
+    }
+}
+
+size_t ComposeDualShock(const OutputContext& hid_out, int connection_type, unsigned char* buffer) {
+    size_t padding = (connection_type == DS_CONNECTION_BLUETOOTH) ? 2 : 1;
+    buffer[0] = (connection_type == DS_CONNECTION_BLUETOOTH) ? 0x11 : 0x05;
+
+    if (connection_type == DS_CONNECTION_BLUETOOTH) {
+        buffer[1] = 0xc0;
+    }
+
+    unsigned char* output = &buffer[padding];
+
+    if (connection_type == DS_CONNECTION_BLUETOOTH) {
+        output[0] = 0x20;
+        output[1] = 0x07;
+    }
+    else {
+        output[0] = 0xff;
+    }
+
+    output[3 + (padding - 1)] = hid_out.rumbles.left;
+    output[4 + (padding - 1)] = hid_out.rumbles.right;
+    output[5 + (padding - 1)] = hid_out.lightbar.r;
+    output[6 + (padding - 1)] = hid_out.lightbar.g;
+    output[7 + (padding - 1)] = hid_out.lightbar.b;
+    output[8 + (padding - 1)] = hid_out.flash_lightbar.bright_time;
+    output[9 + (padding - 1)] = hid_out.flash_lightbar.toggle_time;
+
+    return (connection_type == DS_CONNECTION_BLUETOOTH) ? 78 : 32;
+}
+
+size_t ComposeDualSense(const OutputContext& hid_out, int connection_type, unsigned char* buffer) {
+    const size_t padding = (connection_type == DS_CONNECTION_BLUETOOTH) ? 2 : 1;
+    buffer[0] = (connection_type == DS_CONNECTION_BLUETOOTH) ? 0x31 : 0x02;
+
+    if (connection_type == DS_CONNECTION_BLUETOOTH) {
+        buffer[1] = 0x02;
+    }
+
+    unsigned char* output = &buffer[padding];
+
+    output[0] = hid_out.feature.vibration_mode;
+    output[1] = hid_out.feature.feature_mode;
+    output[2] = hid_out.rumbles.left;
+    output[3] = hid_out.rumbles.right;
+    output[4] = hid_out.audio.headset_volume;
+    output[5] = hid_out.audio.speaker_volume;
+    output[6] = hid_out.audio.mic_volume;
+    output[7] = hid_out.audio.mode;
+    output[9] = hid_out.audio.mic_status;
+    output[8] = hid_out.mic_light.mode;
+    output[36] = (hid_out.feature.trigger_softness_level << 4) | (hid_out.feature.soft_rumble_reduce & 0x0F);
+    output[38] = 0x07;
+    output[41] = 0x02;
+    output[42] = hid_out.player_led.brightness;
+    output[43] = hid_out.player_led.led;
+    output[44] = hid_out.lightbar.r;
+    output[45] = hid_out.lightbar.g;
+    output[46] = hid_out.lightbar.b;
+
+    if (hid_out.override_trigger_bytes) {
+        memcpy(&output[10], hid_out.override_trigger_right, 10);
+        memcpy(&output[21], hid_out.override_trigger_left, 10);
+    }
+    else {
+        SetTriggerEffects(&output[10], hid_out.right_trigger);
+        SetTriggerEffects(&output[21], hid_out.left_trigger);
+    }
+
+    return (connection_type == DS_CONNECTION_BLUETOOTH) ? 78 : 74;
+}
+
+} // namespace legacy
+
+namespace {
+
+constexpr int ITERATIONS = 2000000;
+constexpr int CONTEXT_COUNT = 8;
+
+// Output states covering every trigger encoding
+void MakeContexts(OutputContext* contexts) {
+    const uint8_t modes[CONTEXT_COUNT] = { 0x00, 0x01, 0x02, 0x21, 0x23, 0x26, 0x27, 0xFF };
+    for (int i = 0; i < CONTEXT_COUNT; i++) {
+        OutputContext& context = contexts[i];
+        context = OutputContext();
+        context.lightbar.r = static_cast<uint8_t>(i * 31);
+        context.lightbar.g = static_cast<uint8_t>(i * 17);
+        context.lightbar.b = static_cast<uint8_t>(i * 7);
+        context.rumbles.left = static_cast<uint8_t>(i * 29);
+        context.rumbles.right = static_cast<uint8_t>(255 - i * 29);
+        context.player_led.led = static_cast<uint8_t>(i);
+        context.player_led.brightness = static_cast<uint8_t>(i % 3);
+        context.left_trigger.mode = modes[i];
+        context.right_trigger.mode = modes[(i + 3) % CONTEXT_COUNT];
+        for (int j = 0; j < 10; j++) {
+            context.left_trigger.strengths.compose[j] = static_cast<uint8_t>(i * 10 + j + 1);
+            context.right_trigger.strengths.compose[j] = static_cast<uint8_t>(200 - i * 10 - j);
+        }
+    }
+}
+
+uint64_t ReadClock() {
+#ifdef BENCH_HAS_TSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+template <typename Compose>
+void Run(const char* name, const OutputContext* contexts, Compose compose) {
+    unsigned char buffer[78] = {};
+    unsigned sink = 0;
+
+    const auto start_time = std::chrono::steady_clock::now();
+    const uint64_t start = ReadClock();
+    for (int i = 0; i < ITERATIONS; i++) {
+        compose(contexts[i & (CONTEXT_COUNT - 1)], buffer);
+        sink += buffer[i % 74];
+    }
+    const uint64_t ticks = ReadClock() - start;
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+
+    printf("  %-28s %7.1f %s/report %7.2f ns/report (sink %u)\n", name,
+           static_cast<double>(ticks) / ITERATIONS,
+#ifdef BENCH_HAS_TSC
+           "cycles",
+#else
+           "ticks",
+#endif
+           ns / ITERATIONS, sink & 0xFF);
+}
+
+// Compare specialized and legacy output on zeroed buffers
+bool Verify(const OutputContext* contexts, const OutputFormat& format, int device_type, int connection_type) {
+    for (int i = 0; i < CONTEXT_COUNT; i++) {
+        unsigned char expected[78] = {};
+        unsigned char actual[78] = {};
+        const size_t expected_size = (device_type == DS_DEVICE_DUALSHOCK4)
+            ? legacy::ComposeDualShock(contexts[i], connection_type, expected)
+            : legacy::ComposeDualSense(contexts[i], connection_type, expected);
+        const size_t actual_size = format.compose(contexts[i], actual);
+        if (expected_size != actual_size || memcmp(expected, actual, actual_size) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int main() {
+    OutputContext contexts[CONTEXT_COUNT];
+    MakeContexts(contexts);
+
+    struct Variant {
+        const char* name;
+        int device_type;
+        int connection_type;
+    };
+    const Variant variants[] = {
+        { "DualSense USB", DS_DEVICE_DUALSENSE, DS_CONNECTION_USB },
+        { "DualSense BT", DS_DEVICE_DUALSENSE, DS_CONNECTION_BLUETOOTH },
+        { "DualShock 4 USB", DS_DEVICE_DUALSHOCK4, DS_CONNECTION_USB },
+        { "DualShock 4 BT", DS_DEVICE_DUALSHOCK4, DS_CONNECTION_BLUETOOTH },
+    };
+
+    bool all_match = true;
+    for (const Variant& variant : variants) {
+        const OutputFormat& format = *GetOutputFormat(variant.device_type, variant.connection_type);
+        const bool match = Verify(contexts, format, variant.device_type, variant.connection_type);
+        all_match = all_match && match;
+
+        printf("%s (%s)\n", variant.name, match ? "output matches legacy" : "OUTPUT MISMATCH");
+
+        const int connection_type = variant.connection_type;
+        if (variant.device_type == DS_DEVICE_DUALSHOCK4) {
+            Run("legacy", contexts, [&](const OutputContext& context, unsigned char* buffer) {
+                legacy::ComposeDualShock(context, connection_type, buffer);
+            });
+        }
+        else {
+            Run("legacy", contexts, [&](const OutputContext& context, unsigned char* buffer) {
+                legacy::ComposeDualSense(context, connection_type, buffer);
+            });
+        }
+        Run("specialized", contexts, [&](const OutputContext& context, unsigned char* buffer) {
+            format.compose(context, buffer);
+        });
+    }
+
+    return all_match ? 0 : 1;
+}
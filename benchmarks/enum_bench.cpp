@@ -0,0 +1,180 @@
+// Enumeration startup benchmark (Linux)
+// Cold and warm DetectDevices on a synthetic host with many HID nodes, against
+// the previous scan that opened every node and queried it with an ioctl.
+// The synthetic tree is a sysfs-like directory of hidraw links plus plain
+// files standing in for /dev nodes, so open() costs are a lower bound.
+//
+// Build: make bench (GNU make)
+
+#include "hid/linux_hidraw.h"
+#include "hid/hid_constants.h"
+#include "../include/dualsense.h"
+#include <linux/hidraw.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace dualsense;
+
+namespace {
+
+constexpr int NODES = 256;
+constexpr int ITERATIONS = 200;
+
+// Controllers among the synthetic nodes: USB DualSense and Bluetooth DualShock 4
+constexpr int DUALSENSE_NODE = 40;
+constexpr int DUALSHOCK4_NODE = 200;
+
+std::string MakeTree(const std::string& root) {
+    const std::string sysfs_dir = root + "/sys";
+    const std::string dev_dir = root + "/dev";
+    mkdir(sysfs_dir.c_str(), 0700);
+    mkdir(dev_dir.c_str(), 0700);
+
+    for (int i = 0; i < NODES; i++) {
+        unsigned int bus = 0x0003;
+        unsigned int vendor = 0x046D;
+        unsigned int product = 0xC52B;
+        if (i == DUALSENSE_NODE) {
+            vendor = SONY_VENDOR_ID;
+            product = DUALSENSE_PRODUCT_ID;
+        }
+        else if (i == DUALSHOCK4_NODE) {
+            bus = 0x0005;
+            vendor = SONY_VENDOR_ID;
+            product = DUALSHOCK4_V2_PRODUCT_ID;
+        }
+
+        char target[256];
+        snprintf(target, sizeof(target),
+                 "../../devices/pci0000:00/0000:00:14.0/usb1/1-%d/1-%d:1.0/%04X:%04X:%04X.%04X/hidraw/hidraw%d",
+                 i, i, bus, vendor, product, i + 1, i);
+        const std::string name = "hidraw" + std::to_string(i);
+        if (symlink(target, (sysfs_dir + "/" + name).c_str()) != 0) {
+            perror("symlink");
+        }
+        const int fd = open((dev_dir + "/" + name).c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0600);
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    return sysfs_dir;
+}
+
+void RemoveTree(const std::string& path) {
+    if (DIR* directory = opendir(path.c_str())) {
+        while (const dirent* entry = readdir(directory)) {
+            if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0) {
+                RemoveTree(path + "/" + entry->d_name);
+            }
+        }
+        closedir(directory);
+        rmdir(path.c_str());
+    }
+    else {
+        unlink(path.c_str());
+    }
+}
+
+// Previous enumeration: open and query every hidraw node
+size_t LegacyScan(const std::string& dev_dir) {
+    std::vector<std::string> candidates;
+    DIR* directory = opendir(dev_dir.c_str());
+    while (const dirent* entry = readdir(directory)) {
+        if (strncmp(entry->d_name, "hidraw", 6) == 0) {
+            candidates.push_back(dev_dir + "/" + entry->d_name);
+        }
+    }
+    closedir(directory);
+    std::sort(candidates.begin(), candidates.end());
+
+    size_t found = 0;
+    for (const auto& path : candidates) {
+        const int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        hidraw_devinfo info = {};
+        if (ioctl(fd, HIDIOCGRAWINFO, &info) == 0 && static_cast<uint16_t>(info.vendor) == SONY_VENDOR_ID) {
+            found++;
+        }
+        close(fd);
+    }
+    return found;
+}
+
+template <typename Fn>
+double MeasureUs(Fn fn) {
+    double best = 1e30;
+    double total = 0.0;
+    for (int i = 0; i < ITERATIONS; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, us);
+        total += us;
+    }
+    printf("mean %8.1f us  best %8.1f us\n", total / ITERATIONS, best);
+    return total / ITERATIONS;
+}
+
+} // anonymous namespace
+
+int main() {
+    char root_template[] = "/tmp/ds_enum_bench.XXXXXX";
+    const char* root = mkdtemp(root_template);
+    if (!root) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    const std::string sysfs_dir = MakeTree(root);
+    const std::string dev_dir = std::string(root) + "/dev";
+    std::vector<DeviceInfo> devices;
+    bool ok = true;
+
+    printf("Synthetic host: %d hidraw nodes, 2 controllers\n", NODES);
+
+    printf("  previous (open + ioctl every node)   ");
+    MeasureUs([&] { LegacyScan(dev_dir); });
+
+    printf("  cold (sysfs filter, parallel open)   ");
+    MeasureUs([&] {
+        hid::ResetEnumerationCache();
+        hid::DetectHidrawDevices(sysfs_dir, dev_dir, devices);
+    });
+    ok = ok && devices.size() == 2;
+
+    printf("  warm (enumeration cache)             ");
+    MeasureUs([&] { hid::DetectHidrawDevices(sysfs_dir, dev_dir, devices); });
+    ok = ok && devices.size() == 2 &&
+         devices[0].device_type == DS_DEVICE_DUALSENSE && devices[0].connection_type == DS_CONNECTION_USB &&
+         devices[1].device_type == DS_DEVICE_DUALSHOCK4 && devices[1].connection_type == DS_CONNECTION_BLUETOOTH;
+
+    printf("This host (/sys/class/hidraw)\n");
+    printf("  cold                                 ");
+    MeasureUs([&] {
+        hid::ResetEnumerationCache();
+        hid::DetectDevices(devices);
+    });
+    printf("  warm                                 ");
+    MeasureUs([&] { hid::DetectDevices(devices); });
+    printf("  controllers found: %zu\n", devices.size());
+
+    hid::ResetEnumerationCache();
+    RemoveTree(root);
+
+    if (!ok) {
+        printf("Synthetic enumeration returned the wrong devices\n");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,429 @@
+// Hot path microbenchmarks
+// CPU cost of input parsing, output composition, trigger encoding, CRC and
+// audio haptic reports. Writes go to a null transport, so no I/O is timed.
+//
+// Output is one JSON object per line: a header with the build details, then
+// one line per benchmark (median and best ns/op over several samples), so
+// runs from different commits can be diffed or loaded into a script.
+//
+// Usage: micro_bench [filter]   (only benchmarks whose name contains filter)
+// Build: make bench (GNU make) / nmake bench (NMAKE)
+
+#include "core/device_context.h"
+#include "core/seqlock.h"
+#include "hid/hid_constants.h"
+#include "protocol/crc32.h"
+#include "protocol/input_parser.h"
+#include "protocol/motion.h"
+#include "protocol/output_composer.h"
+#include "protocol/response_curve.h"
+#include "protocol/touch_gestures.h"
+#include "../include/dualsense.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace dualsense;
+using namespace dualsense::protocol;
+
+namespace {
+
+// Each sample runs for at least this long; the median of SAMPLES is reported
+constexpr double MIN_SAMPLE_NS = 20e6;
+constexpr int SAMPLES = 7;
+
+// Results are folded into this so the measured work cannot be dropped
+volatile uint32_t g_sink;
+
+// Keep the compiler from dropping or hoisting work whose result is unused
+inline void ClobberMemory() {
+#if defined(_MSC_VER)
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : : "memory");
+#endif
+}
+
+// Transport that accepts and discards every write
+class NullTransport : public hid::Transport {
+public:
+    bool Open(const std::string&) override { return true; }
+    void Close() override {}
+    bool IsOpen() const override { return true; }
+    int Read(unsigned char*, size_t, int) override { return hid::READ_TIMEOUT; }
+    bool Write(const unsigned char* buffer, size_t size) override {
+        bytes_ += size + buffer[0];
+        return true;
+    }
+    bool GetFeature(unsigned char*, size_t) override { return false; }
+    void Flush() override {}
+    bool Ping() override { return true; }
+
+    uint64_t bytes_ = 0;
+};
+
+struct Result {
+    double median_ns;
+    double best_ns;
+    uint64_t iterations;
+};
+
+template <typename Fn>
+double TimeBatch(Fn& fn, uint64_t iterations) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        fn(i);
+        ClobberMemory();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Fn>
+Result Measure(Fn fn) {
+    // Grow the batch until one sample is long enough to time reliably
+    uint64_t iterations = 1000;
+    while (TimeBatch(fn, iterations) < MIN_SAMPLE_NS && iterations < (1ull << 40)) {
+        iterations *= 2;
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < SAMPLES; i++) {
+        samples.push_back(TimeBatch(fn, iterations) / static_cast<double>(iterations));
+    }
+    std::sort(samples.begin(), samples.end());
+    return { samples[SAMPLES / 2], samples[0], iterations };
+}
+
+class Suite {
+public:
+    explicit Suite(const char* filter) : filter_(filter ? filter : "") {}
+
+    // bytes: payload processed per operation (0 = no throughput in bytes)
+    template <typename Fn>
+    void Run(const char* name, size_t bytes, Fn fn) {
+        if (!filter_.empty() && std::string(name).find(filter_) == std::string::npos) {
+            return;
+        }
+        const Result result = Measure(fn);
+        printf("{\"name\":\"%s\",\"ns_per_op\":%.3f,\"best_ns_per_op\":%.3f,\"ops_per_sec\":%.0f",
+               name, result.median_ns, result.best_ns, 1e9 / result.median_ns);
+        if (bytes > 0) {
+            printf(",\"bytes_per_op\":%zu,\"mb_per_sec\":%.1f", bytes, static_cast<double>(bytes) * 1e3 / result.median_ns);
+        }
+        printf(",\"iterations\":%llu,\"samples\":%d}\n", static_cast<unsigned long long>(result.iterations), SAMPLES);
+        fflush(stdout);
+    }
+
+private:
+    std::string filter_;
+};
+
+// Input report with buttons, sticks, two touches and motion
+void MakeInputReport(const InputFormat& format, unsigned char* report) {
+    DSInputState state = {};
+    state.stick_lx = 30;
+    state.stick_ly = 220;
+    state.stick_rx = 128;
+    state.stick_ry = 90;
+    state.trigger_l2 = 200;
+    state.button_cross = true;
+    state.button_l1 = true;
+    state.button_dpad_up = true;
+    state.battery_level = 70;
+    state.touch1 = { 1200, 600, 1, true };
+    state.touch2 = { 300, 900, 2, true };
+
+    RawMotion motion = {};
+    motion.gyro[0] = 120;
+    motion.gyro[1] = -40;
+    motion.accel[1] = 8192;
+    motion.timestamp = 12345;
+
+    format.encode(state, motion, 7, report);
+    if (format.has_crc) {
+        const size_t crc_offset = format.report_size - 4;
+        const uint32_t crc = ComputeCRC32(report, crc_offset, CRC_SEED_INPUT);
+        memcpy(&report[crc_offset], &crc, sizeof(crc));
+    }
+}
+
+// Device context on a null transport, with every output field in use
+void MakeContext(DeviceContext& context, int device_type, int connection_type) {
+    context.transport.reset(new NullTransport());
+    context.device_type = device_type;
+    context.connection_type = connection_type;
+    context.is_connected = true;
+    context.output.lightbar.r = 255;
+    context.output.lightbar.g = 64;
+    context.output.rumbles.left = 128;
+    context.output.rumbles.right = 32;
+    context.output.player_led.led = PLAYER_LED_MIDDLE;
+    context.output.left_trigger.mode = DS_TRIGGER_WEAPON;
+    context.output.right_trigger.mode = DS_TRIGGER_GALLOPING;
+    for (int i = 0; i < 10; i++) {
+        context.output.left_trigger.strengths.compose[i] = static_cast<uint8_t>(i * 20);
+        context.output.right_trigger.strengths.compose[i] = static_cast<uint8_t>(200 - i * 20);
+    }
+}
+
+void RunInput(Suite& suite) {
+    const InputFormat& usb = *GetInputFormat(DS_DEVICE_DUALSENSE, DS_CONNECTION_USB);
+    const InputFormat& bt = *GetInputFormat(DS_DEVICE_DUALSENSE, DS_CONNECTION_BLUETOOTH);
+    unsigned char usb_report[78] = {};
+    unsigned char bt_report[78] = {};
+    MakeInputReport(usb, usb_report);
+    MakeInputReport(bt, bt_report);
+
+    DSTouchPoint touch = {};
+    suite.Run("input/parse_touch_point", 0, [&](uint64_t i) {
+        touch = ParseTouchPoint(usb_report, (i & 1) ? TOUCHPAD2_OFFSET + 1 : TOUCHPAD1_OFFSET + 1);
+    });
+
+    DSInputState state = {};
+    RawMotion motion = {};
+    suite.Run("input/decode_usb", usb.report_size, [&](uint64_t) { usb.decode(usb_report, &state, &motion); });
+    suite.Run("input/decode_bt", bt.report_size, [&](uint64_t) { bt.decode(bt_report, &state, &motion); });
+
+    // Input thread work per Bluetooth report: CRC check, decode, fusion, publish
+    SeqLock<DSInputState> snapshot;
+    MotionProcessor processor;
+    uint32_t timestamp = 0;
+    uint32_t stored_crc;
+    memcpy(&stored_crc, &bt_report[bt.report_size - 4], sizeof(stored_crc));
+    suite.Run("input/publish_bt", bt.report_size, [&](uint64_t) {
+        if (ComputeCRC32(bt_report, bt.report_size - 4u, CRC_SEED_INPUT) == stored_crc) {
+            bt.decode(bt_report, &state, &motion);
+            motion.timestamp = (timestamp += 3000);
+            processor.Process(motion, bt, &state);
+            snapshot.Store(state);
+        }
+    });
+
+    // What ds_get_input_state does once the snapshot is published
+    suite.Run("input/get_input_state", sizeof(DSInputState), [&](uint64_t) { state = snapshot.Load(); });
+
+    // Radial deadzone with a curve on both sticks plus both triggers, per report
+    DSStickResponse response = { DS_DEADZONE_RADIAL, DefaultResponseCurve() };
+    response.curve.deadzone = 0.1f;
+    response.curve.exponent = 2.0f;
+    AnalogTables tables;
+    for (uint32_t stick = 0; stick < 2; stick++) {
+        StickTable table;
+        table.Compile(response);
+        tables.SetStick(stick, std::move(table));
+    }
+    const AnalogTables linear;
+    DSInputState analog_input = {};
+    DSAnalogState analog = {};
+    const auto set_analog_input = [&](uint64_t i) {
+        const uint8_t value = static_cast<uint8_t>(i * 37);
+        analog_input.stick_lx = value;
+        analog_input.stick_ly = static_cast<uint8_t>(255 - value);
+        analog_input.stick_rx = static_cast<uint8_t>(value + 64);
+        analog_input.stick_ry = value;
+        analog_input.trigger_l2 = value;
+        analog_input.trigger_r2 = static_cast<uint8_t>(~value);
+    };
+    suite.Run("input/analog_response", 6, [&](uint64_t i) {
+        set_analog_input(i);
+        tables.Apply(analog_input, &analog);
+    });
+    // Default curves everywhere: the tables are skipped
+    suite.Run("input/analog_response_linear", 6, [&](uint64_t i) {
+        set_analog_input(i);
+        linear.Apply(analog_input, &analog);
+    });
+
+    // Two fingers spreading for 64 reports (250 Hz), then lifting: pinch BEGIN/UPDATE/END
+    GestureRecognizer recognizer;
+    DSInputState touch_state = {};
+    DSGestureEvent gestures[MAX_GESTURES_PER_REPORT];
+    size_t gesture_count = 0;
+    suite.Run("input/touch_gestures", 0, [&](uint64_t i) {
+        const uint16_t step = static_cast<uint16_t>(i & 63);
+        touch_state.sensor_timestamp_us = i * 4000;
+        touch_state.touch1 = { static_cast<uint16_t>(900 - step * 8), 500, 1, step != 63 };
+        touch_state.touch2 = { static_cast<uint16_t>(1000 + step * 8), 500, 2, step != 63 };
+        gesture_count += recognizer.Process(touch_state, static_cast<uint32_t>(i), gestures);
+    });
+
+    g_sink = touch.x + state.stick_lx + static_cast<uint32_t>(analog.left_x + analog.r2) +
+             static_cast<uint32_t>(gesture_count);
+}
+
+void RunOutput(Suite& suite) {
+    struct Variant {
+        const char* name;
+        int device_type;
+        int connection_type;
+    };
+    const Variant variants[] = {
+        { "output/dualsense_usb", DS_DEVICE_DUALSENSE, DS_CONNECTION_USB },
+        { "output/dualsense_bt", DS_DEVICE_DUALSENSE, DS_CONNECTION_BLUETOOTH },
+        { "output/dualshock4_usb", DS_DEVICE_DUALSHOCK4, DS_CONNECTION_USB },
+        { "output/dualshock4_bt", DS_DEVICE_DUALSHOCK4, DS_CONNECTION_BLUETOOTH },
+    };
+
+    for (const Variant& variant : variants) {
+        DeviceContext context;
+        MakeContext(context, variant.device_type, variant.connection_type);
+        const size_t size = GetOutputFormat(variant.device_type, variant.connection_type)->report_size;
+        if (variant.device_type == DS_DEVICE_DUALSHOCK4) {
+            suite.Run(variant.name, size, [&](uint64_t i) {
+                context.output.lightbar.r = static_cast<uint8_t>(i);
+                OutputDualShock(&context);
+            });
+        }
+        else {
+            suite.Run(variant.name, size, [&](uint64_t i) {
+                context.output.lightbar.r = static_cast<uint8_t>(i);
+                OutputDualSense(&context);
+            });
+        }
+    }
+}
+
+void RunTriggers(Suite& suite) {
+    struct Mode {
+        const char* name;
+        uint8_t mode;
+    };
+    const Mode modes[] = {
+        { "trigger/off", DS_TRIGGER_OFF },
+        { "trigger/continuous_resistance", DS_TRIGGER_CONTINUOUS_RESISTANCE },
+        { "trigger/bow", DS_TRIGGER_BOW },
+        { "trigger/resistance", DS_TRIGGER_RESISTANCE },
+        { "trigger/bow_alt", DS_TRIGGER_BOW_ALT },
+        { "trigger/galloping", DS_TRIGGER_GALLOPING },
+        { "trigger/weapon", DS_TRIGGER_WEAPON },
+        { "trigger/automatic_gun", DS_TRIGGER_AUTOMATIC_GUN },
+        { "trigger/machine", DS_TRIGGER_MACHINE },
+        { "trigger/custom", DS_TRIGGER_CUSTOM },
+    };
+
+    for (const Mode& mode : modes) {
+        HapticTriggers effect;
+        effect.mode = mode.mode;
+        for (int i = 0; i < 10; i++) {
+            effect.strengths.compose[i] = static_cast<uint8_t>(i * 25 + 3);
+        }
+        effect.strengths.active_zones = 0x03F0;
+        effect.strengths.strength_zones = 0x0123456789ABCDEFull;
+
+        // Composers hand SetTriggerEffects a zeroed slice of their template
+        unsigned char trigger[11];
+        suite.Run(mode.name, 10, [&](uint64_t i) {
+            memset(trigger, 0, sizeof(trigger));
+            effect.strengths.compose[0] = static_cast<uint8_t>(i);
+            SetTriggerEffects(trigger, effect);
+        });
+    }
+}
+
+// Every CRC implementation must agree before the dispatched one is timed:
+// report sizes (USB/BT input, BT output, audio haptics, a long buffer),
+// both seeds and every start alignment the vector paths can see
+bool CheckCRC() {
+    static const size_t SIZES[] = { 74, 78, 138, 141, 547 };
+    static const uint32_t SEEDS[] = { CRC_SEED, CRC_SEED_INPUT };
+    constexpr size_t MAX_SIZE = 547;
+    constexpr size_t ALIGNMENTS = 16;
+
+    unsigned char buffer[MAX_SIZE + ALIGNMENTS];
+    uint32_t state = 0x12345678;
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        state = state * 1664525u + 1013904223u;
+        buffer[i] = static_cast<unsigned char>(state >> 24);
+    }
+
+    bool ok = true;
+    for (size_t size : SIZES) {
+        for (uint32_t seed : SEEDS) {
+            for (size_t offset = 0; offset < ALIGNMENTS; offset++) {
+                const unsigned char* data = buffer + offset;
+                const uint32_t expected = ComputeCRC32Bytewise(data, size, seed);
+                const uint32_t slice16 = ComputeCRC32Slice16(data, size, seed);
+                const uint32_t dispatched = ComputeCRC32(data, size, seed);
+                if (slice16 != expected || dispatched != expected) {
+                    fprintf(stderr, "micro_bench: CRC mismatch, size %zu seed 0x%08x offset %zu: "
+                            "bytewise 0x%08x slice16 0x%08x %s 0x%08x\n",
+                            size, seed, offset, expected, slice16, GetCRC32Implementation(), dispatched);
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+void RunCRC(Suite& suite) {
+    unsigned char buffer[HAPTIC_REPORT_SIZE];
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = static_cast<unsigned char>(i * 37 + 11);
+    }
+
+    uint32_t crc = 0;
+    suite.Run("crc32/74", 74, [&](uint64_t i) {
+        buffer[1] = static_cast<unsigned char>(i);
+        crc ^= ComputeCRC32(buffer, 74);
+    });
+    suite.Run("crc32/138", 138, [&](uint64_t i) {
+        buffer[1] = static_cast<unsigned char>(i);
+        crc ^= ComputeCRC32(buffer, 138);
+    });
+    g_sink = crc;
+}
+
+void RunAudio(Suite& suite) {
+    DeviceContext context;
+    MakeContext(context, DS_DEVICE_DUALSENSE, DS_CONNECTION_BLUETOOTH);
+
+    int8_t samples[HAPTIC_SAMPLES_PER_REPORT];
+    for (size_t i = 0; i < HAPTIC_SAMPLES_PER_REPORT; i++) {
+        samples[i] = static_cast<int8_t>((i * 13) & 0x7F);
+    }
+    ComposeHapticReport(samples, 0, context.buffer_audio);
+
+    suite.Run("audio/send_audio_haptic_advanced", HAPTIC_REPORT_SIZE, [&](uint64_t i) {
+        context.buffer_audio[13] = static_cast<unsigned char>(i);
+        SendAudioHapticAdvanced(&context);
+    });
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    Suite suite(argc > 1 ? argv[1] : nullptr);
+
+    printf("{\"suite\":\"micro_bench\",\"format\":1,\"crc32\":\"%s\",\"compiler\":\"%s\",\"pointer_bits\":%zu}\n",
+           GetCRC32Implementation(),
+#if defined(__clang__)
+           "clang " __clang_version__,
+#elif defined(__GNUC__)
+           "gcc " __VERSION__,
+#elif defined(_MSC_VER)
+           "msvc",
+#else
+           "unknown",
+#endif
+           sizeof(void*) * 8);
+
+    if (!CheckCRC()) {
+        return 1;
+    }
+
+    RunInput(suite);
+    RunOutput(suite);
+    RunTriggers(suite);
+    RunCRC(suite);
+    RunAudio(suite);
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Haptic resampler benchmark
+// Input samples per second per core for each FIR kernel and common input
+// rates, plus a passband/stopband check of the converted output.
+//
+// Build: make bench (GNU make) / nmake bench (NMAKE)
+
+#include "protocol/haptic_resampler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace dualsense::protocol;
+
+namespace {
+
+constexpr uint32_t SECONDS = 20;
+constexpr size_t BLOCK_FRAMES = 480;    // 10 ms at 48 kHz
+constexpr double PI = 3.14159265358979323846;
+
+const FirKernel KERNELS[] = { FirKernel::Scalar, FirKernel::Sse, FirKernel::Avx2, FirKernel::Neon };
+
+// Stereo test signal: 80 Hz on the left, 160 Hz + noise on the right
+std::vector<float> MakeSignal(uint32_t rate, size_t frames) {
+    std::vector<float> signal(frames * 2);
+    uint32_t state = 1;
+    for (size_t i = 0; i < frames; i++) {
+        state = state * 1664525u + 1013904223u;
+        const double t = static_cast<double>(i) / rate;
+        const float noise = static_cast<float>(state >> 8) * (1.0f / 16777216.0f) - 0.5f;
+        signal[i * 2] = static_cast<float>(0.8 * std::sin(2.0 * PI * 80.0 * t));
+        signal[i * 2 + 1] = static_cast<float>(0.5 * std::sin(2.0 * PI * 160.0 * t)) + 0.2f * noise;
+    }
+    return signal;
+}
+
+template <typename Sample>
+size_t Convert(HapticResampler& resampler, const std::vector<Sample>& input, std::vector<int8_t>& output) {
+    const size_t frames = input.size() / 2;
+    const size_t capacity = output.size() / 2;
+    size_t consumed = 0;
+    size_t produced = 0;
+    while (consumed < frames) {
+        const size_t count = (frames - consumed < BLOCK_FRAMES) ? frames - consumed : BLOCK_FRAMES;
+        size_t written = 0;
+        consumed += resampler.Process(input.data() + consumed * 2, count,
+                                      output.data() + produced * 2, capacity - produced, &written);
+        produced += written;
+    }
+    return produced;
+}
+
+// Peak output level for a full-scale mono sine at the given frequency
+int PeakLevel(uint32_t rate, double frequency) {
+    HapticResampler resampler;
+    resampler.Configure(rate, 1, 1.0f);
+
+    std::vector<float> input(rate);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = static_cast<float>(std::sin(2.0 * PI * frequency * static_cast<double>(i) / rate));
+    }
+
+    std::vector<int8_t> output(HAPTIC_SAMPLE_RATE * 2 + 64);
+    size_t produced = 0;
+    resampler.Process(input.data(), input.size(), output.data(), output.size() / 2, &produced);
+
+    // Skip the filter warm-up
+    int peak = 0;
+    for (size_t i = produced / 4; i < produced; i++) {
+        peak = std::max(peak, std::abs(static_cast<int>(output[i * 2])));
+    }
+    return peak;
+}
+
+} // anonymous namespace
+
+int main() {
+    const uint32_t rates[] = { 48000, 44100, 96000 };
+    bool all_match = true;
+
+    printf("Default kernel: %s\n", GetFirKernelName(GetBestFirKernel()));
+
+    for (uint32_t rate : rates) {
+        const size_t frames = static_cast<size_t>(rate) * SECONDS;
+        const std::vector<float> input = MakeSignal(rate, frames);
+        std::vector<int8_t> reference(static_cast<size_t>(HAPTIC_SAMPLE_RATE) * SECONDS * 2 + 64);
+        std::vector<int8_t> output(reference.size());
+        size_t reference_frames = 0;
+
+        printf("%u Hz stereo float -> %u Hz (passband 100 Hz: %d, stopband 2 kHz: %d, 5 kHz: %d)\n",
+               rate, HAPTIC_SAMPLE_RATE, PeakLevel(rate, 100.0), PeakLevel(rate, 2000.0), PeakLevel(rate, 5000.0));
+
+        for (FirKernel kernel : KERNELS) {
+            if (!IsFirKernelSupported(kernel)) {
+                continue;
+            }
+
+            HapticResampler resampler;
+            resampler.Configure(rate, 2, 1.0f);
+            resampler.SetKernel(kernel);
+
+            const auto start = std::chrono::steady_clock::now();
+            const size_t produced = Convert(resampler, input, output);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            // Kernels differ only in summation order: allow one LSB of rounding
+            int max_diff = 0;
+            if (kernel == FirKernel::Scalar) {
+                reference.swap(output);
+                reference_frames = produced;
+            }
+            else {
+                for (size_t i = 0; i < produced * 2 && i < reference_frames * 2; i++) {
+                    max_diff = std::max(max_diff, std::abs(output[i] - reference[i]));
+                }
+                all_match = all_match && produced == reference_frames && max_diff <= 1;
+            }
+
+            printf("  %-8s %8.1f M input samples/s per core  %7.0fx realtime  (max diff %d LSB)\n",
+                   GetFirKernelName(kernel), frames * 2 / seconds / 1e6, SECONDS / seconds, max_diff);
+        }
+
+        // int16 input through the default kernel
+        std::vector<int16_t> input16(input.size());
+        for (size_t i = 0; i < input.size(); i++) {
+            input16[i] = static_cast<int16_t>(input[i] * 32767.0f);
+        }
+        HapticResampler resampler;
+        resampler.Configure(rate, 2, 1.0f);
+        const auto start = std::chrono::steady_clock::now();
+        Convert(resampler, input16, output);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("  %-8s %8.1f M input samples/s per core  %7.0fx realtime  (int16 input)\n",
+               GetFirKernelName(GetBestFirKernel()), frames * 2 / seconds / 1e6, SECONDS / seconds);
+    }
+
+    return all_match ? 0 : 1;
+}
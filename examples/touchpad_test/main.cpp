@@ -15,55 +15,45 @@ int main() {
 
     printf("Connected! Waiting for touchpad input...\n\n");
 
-    DSInputState state;
-    DSInputState prev_state = {};
-
-    while (true) {
-        // Update and read input
-        ds_update_input();
-        ds_get_input_state(&state);
-
-        // Detect touch 1 events (client-side event detection)
-        if (state.touch1.is_active && !prev_state.touch1.is_active) {
-            printf("[Touch1 START] ID=%d, X=%4d, Y=%4d\n",
-                   state.touch1.id, state.touch1.x, state.touch1.y);
-        }
-        else if (state.touch1.is_active && prev_state.touch1.is_active) {
-            // Only print if position changed
-            if (state.touch1.x != prev_state.touch1.x ||
-                state.touch1.y != prev_state.touch1.y) {
-                printf("[Touch1 MOVE ] ID=%d, X=%4d, Y=%4d\n",
-                       state.touch1.id, state.touch1.x, state.touch1.y);
+    // The input thread sees every report, so no touch or press is missed
+    // between polls even at a low polling rate
+    ds_start_input_thread();
+
+    DSEvent events[64];
+    bool running = true;
+
+    while (running) {
+        uint32_t count = 0;
+        ds_poll_events(events, 64, &count);
+
+        for (uint32_t i = 0; i < count; i++) {
+            const DSEvent& event = events[i];
+            switch (event.type) {
+            case DS_EVENT_TOUCH_BEGIN:
+                printf("[Touch%d START] ID=%d, X=%4d, Y=%4d\n",
+                       event.touch_slot + 1, event.touch_id, event.touch_x, event.touch_y);
+                break;
+            case DS_EVENT_TOUCH_MOVE:
+                printf("[Touch%d MOVE ] ID=%d, X=%4d, Y=%4d\n",
+                       event.touch_slot + 1, event.touch_id, event.touch_x, event.touch_y);
+                break;
+            case DS_EVENT_TOUCH_END:
+                printf("[Touch%d END  ] ID=%d\n", event.touch_slot + 1, event.touch_id);
+                break;
+            case DS_EVENT_BUTTON_DOWN:
+                // Check touchpad button
+                if (event.button == DS_BUTTON_TOUCHPAD) {
+                    printf("\nTouchpad button pressed - exiting\n");
+                    running = false;
+                }
+                break;
+            default:
+                break;
             }
         }
-        else if (!state.touch1.is_active && prev_state.touch1.is_active) {
-            printf("[Touch1 END  ] ID=%d\n", prev_state.touch1.id);
-        }
-
-        // Detect touch 2 events
-        if (state.touch2.is_active && !prev_state.touch2.is_active) {
-            printf("[Touch2 START] ID=%d, X=%4d, Y=%4d\n",
-                   state.touch2.id, state.touch2.x, state.touch2.y);
-        }
-        else if (state.touch2.is_active && prev_state.touch2.is_active) {
-            if (state.touch2.x != prev_state.touch2.x ||
-                state.touch2.y != prev_state.touch2.y) {
-                printf("[Touch2 MOVE ] ID=%d, X=%4d, Y=%4d\n",
-                       state.touch2.id, state.touch2.x, state.touch2.y);
-            }
-        }
-        else if (!state.touch2.is_active && prev_state.touch2.is_active) {
-            printf("[Touch2 END  ] ID=%d\n", prev_state.touch2.id);
-        }
-
-        // Check touchpad button
-        if (state.button_touchpad) {
-            printf("\nTouchpad button pressed - exiting\n");
-            break;
-        }
 
-        prev_state = state;
-        Sleep(16);  // ~60 FPS polling rate
+        // Block until the input thread publishes the next report
+        ds_wait_for_input(-1);
     }
 
     ds_shutdown();
@@ -1,5 +1,5 @@
 // DualSense C API
-// Windows-only DLL for controlling Sony DualSense controllers
+// Shared library (Windows DLL / Linux .so) for controlling Sony DualSense controllers
 
 #pragma once
 
@@ -10,11 +10,22 @@
 extern "C" {
 #endif
 
+#if defined(_WIN32)
 #ifdef DUALSENSE_EXPORTS
 #define DUALSENSE_API __declspec(dllexport)
 #else
 #define DUALSENSE_API __declspec(dllimport)
 #endif
+#else
+#define DUALSENSE_API __attribute__((visibility("default")))
+#endif
+
+// Alignment of structures meant for SIMD loads
+#if defined(_MSC_VER)
+#define DS_ALIGN(bytes) __declspec(align(bytes))
+#else
+#define DS_ALIGN(bytes) __attribute__((aligned(bytes)))
+#endif
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -29,9 +40,23 @@ typedef enum {
     DS_ERROR_NOT_CONNECTED = -3,
     DS_ERROR_INVALID_PARAM = -4,
     DS_ERROR_IO_FAILED = -5,
-    DS_ERROR_DISCONNECTED = -6
+    DS_ERROR_DISCONNECTED = -6,
+    DS_ERROR_INVALID_HANDLE = -7,
+    DS_ERROR_TOO_MANY_DEVICES = -8,
+    DS_ERROR_TIMEOUT = -9
 } DSResult;
 
+// ========================================
+// Device Handles
+// ========================================
+// Handle to one opened controller (see ds_open)
+typedef int32_t DSHandle;
+
+#define DS_INVALID_HANDLE (-1)
+
+// Maximum number of controllers open at the same time
+#define DS_MAX_DEVICES 8
+
 // ========================================
 // Device Enumerations
 // ========================================
@@ -44,6 +69,7 @@ typedef enum {
 typedef enum {
     DS_DEVICE_DUALSENSE = 0,
     DS_DEVICE_DUALSENSE_EDGE = 1,
+    DS_DEVICE_DUALSHOCK4 = 2,
     DS_DEVICE_NOT_FOUND = 255
 } DSDeviceType;
 
@@ -125,13 +151,36 @@ typedef struct {
     uint8_t trigger_l2;
     uint8_t trigger_r2;
 
-    // Battery level (0-100, or negative if charging)
+    // Battery level (0-100) and charging status
     int8_t battery_level;
     bool battery_charging;
 
     // Touchpad (2-point multi-touch)
     DSTouchPoint touch1;
     DSTouchPoint touch2;
+
+    // DualSense Edge only (always false on other models)
+    bool button_fn1;
+    bool button_fn2;
+    bool button_paddle_left;
+    bool button_paddle_right;
+
+    // Motion sensors (factory-calibrated, device axes)
+    float gyro_x;            // Pitch rate in deg/s (estimated bias removed)
+    float gyro_y;            // Yaw rate in deg/s
+    float gyro_z;            // Roll rate in deg/s
+    float accel_x;           // Acceleration in g
+    float accel_y;
+    float accel_z;
+
+    // Fused orientation (unit quaternion, device to world, world +Y = up)
+    float orientation_w;
+    float orientation_x;
+    float orientation_y;
+    float orientation_z;
+
+    // Device sensor clock in microseconds since connection
+    uint64_t sensor_timestamp_us;
 } DSInputState;
 
 // ========================================
@@ -156,11 +205,315 @@ DUALSENSE_API DSDeviceType ds_get_device_type(void);
 // ========================================
 
 // Update input state (call this once per frame)
+// Reads every report queued since the last call, or blocks until the next
+// one arrives if none is queued. No-op while the input thread runs.
 DUALSENSE_API DSResult ds_update_input(void);
 
 // Get current input state
+// Copies the latest published snapshot; never performs I/O or takes a lock.
 DUALSENSE_API DSResult ds_get_input_state(DSInputState* out_state);
 
+// Start a background thread that reads every input report as it arrives
+// and keeps the snapshot returned by ds_get_input_state current
+DUALSENSE_API DSResult ds_start_input_thread(void);
+
+// Stop the background input thread (ds_update_input polling resumes)
+DUALSENSE_API DSResult ds_stop_input_thread(void);
+
+// Block until new input is published (returns DS_ERROR_TIMEOUT if none arrived)
+// timeout_us < 0 waits forever, 0 polls. With the input thread running this
+// wakes as soon as the thread publishes a report; otherwise it reads the next
+// report itself (timeout rounded up to milliseconds).
+DUALSENSE_API DSResult ds_wait_for_input(int64_t timeout_us);
+
+// Native handle that becomes ready when the input thread publishes new input
+// Linux: eventfd (poll/epoll for POLLIN), Windows: event HANDLE (WaitForMultipleObjects).
+// After it fires, call ds_wait_for_input(0) to clear it before waiting again.
+// The handle is owned by the library and stays the same for the device slot.
+DUALSENSE_API DSResult ds_get_input_wait_handle(intptr_t* out_handle);
+
+// Input report counters (since the device was opened)
+typedef struct {
+    uint64_t reports_received;  // Reports decoded into the input state
+    uint64_t crc_errors;        // Bluetooth reports dropped for a bad CRC
+    uint64_t events_dropped;    // Input events lost because the event queue was full
+    uint64_t history_dropped;   // Input states lost because the input history was full
+    uint64_t gestures_dropped;  // Gestures lost because the gesture queue was full
+} DSInputCounters;
+
+// Verify the CRC of Bluetooth input reports and drop corrupted ones (default off)
+DUALSENSE_API DSResult ds_set_input_crc_check(bool enabled);
+
+// Get input report counters
+DUALSENSE_API DSResult ds_get_input_counters(DSInputCounters* out_counters);
+
+// Input events: edges detected on every raw report, so presses shorter than
+// the polling interval are not lost (the input thread, or ds_update_input
+// draining the OS queue, sees every report)
+typedef enum {
+    DS_EVENT_BUTTON_DOWN = 0,
+    DS_EVENT_BUTTON_UP = 1,
+    DS_EVENT_TOUCH_BEGIN = 2,
+    DS_EVENT_TOUCH_MOVE = 3,
+    DS_EVENT_TOUCH_END = 4
+} DSEventType;
+
+typedef enum {
+    DS_BUTTON_CROSS = 0,
+    DS_BUTTON_CIRCLE = 1,
+    DS_BUTTON_SQUARE = 2,
+    DS_BUTTON_TRIANGLE = 3,
+    DS_BUTTON_L1 = 4,
+    DS_BUTTON_R1 = 5,
+    DS_BUTTON_L2 = 6,
+    DS_BUTTON_R2 = 7,
+    DS_BUTTON_L3 = 8,
+    DS_BUTTON_R3 = 9,
+    DS_BUTTON_DPAD_UP = 10,
+    DS_BUTTON_DPAD_DOWN = 11,
+    DS_BUTTON_DPAD_LEFT = 12,
+    DS_BUTTON_DPAD_RIGHT = 13,
+    DS_BUTTON_CREATE = 14,
+    DS_BUTTON_OPTIONS = 15,
+    DS_BUTTON_PS = 16,
+    DS_BUTTON_MUTE = 17,
+    DS_BUTTON_TOUCHPAD = 18,
+    DS_BUTTON_FN1 = 19,
+    DS_BUTTON_FN2 = 20,
+    DS_BUTTON_PADDLE_LEFT = 21,
+    DS_BUTTON_PADDLE_RIGHT = 22,
+    DS_BUTTON_COUNT = 23
+} DSButton;
+
+typedef struct {
+    uint64_t timestamp_us;      // Device sensor clock of the report (see DSInputState)
+    uint32_t sequence;          // Input report sequence number (1 = first report after open)
+    uint8_t type;               // DSEventType
+    uint8_t button;             // DSButton (button events)
+    uint8_t touch_slot;         // 0 = touch1, 1 = touch2 (touch events)
+    uint8_t touch_id;           // Finger ID (touch events)
+    uint16_t touch_x;           // Position (TOUCH_BEGIN / TOUCH_MOVE; last position for TOUCH_END)
+    uint16_t touch_y;
+} DSEvent;
+
+// Capacity of the per-device event queue
+#define DS_EVENT_QUEUE_SIZE 1024
+
+// Drain up to max_events queued events, oldest first, without blocking
+// Call from one thread only. When the queue is full new events are dropped
+// and counted in DSInputCounters::events_dropped.
+DUALSENSE_API DSResult ds_poll_events(DSEvent* events, uint32_t max_events, uint32_t* out_count);
+
+// Input history: every published input state, at the full report rate,
+// for clients that poll slower than the controller reports
+
+// Capacity of the per-device input history (256 ms at 1000 Hz)
+#define DS_INPUT_HISTORY_SIZE 256
+
+// Drain up to max_states states published since the previous call, oldest
+// first, without blocking. Call from one thread only. When the history is
+// full new states are dropped and counted in DSInputCounters::history_dropped.
+DUALSENSE_API DSResult ds_get_input_history(DSInputState* states, uint32_t max_states, uint32_t* out_count);
+
+// Analog inputs covered by DSInputAggregate
+typedef enum {
+    DS_AXIS_LEFT_X = 0,
+    DS_AXIS_LEFT_Y = 1,
+    DS_AXIS_RIGHT_X = 2,
+    DS_AXIS_RIGHT_Y = 3,
+    DS_AXIS_L2 = 4,
+    DS_AXIS_R2 = 5,
+    DS_AXIS_COUNT = 6
+} DSAxis;
+
+// Summary of every state published since the previous ds_get_input_aggregate,
+// starting from the state current at that call (so with no new reports it
+// describes the latest state and reports is 0)
+typedef struct {
+    uint32_t reports;                       // States folded in
+    uint32_t buttons_held;                  // DSButton bits down in any of them
+    uint32_t press_count[DS_BUTTON_COUNT];  // Presses (up to down edges) per DSButton
+    uint8_t axis_min[DS_AXIS_COUNT];        // Per DSAxis (0-255)
+    uint8_t axis_max[DS_AXIS_COUNT];
+    uint8_t stick_peak[2];                  // Largest left/right stick distance from center (0-181)
+} DSInputAggregate;
+
+// Get the aggregate since the previous call and start a new one
+DUALSENSE_API DSResult ds_get_input_aggregate(DSInputAggregate* out_aggregate);
+
+// ========================================
+// Touchpad Gestures
+// ========================================
+// Recognized on every raw report, so fast flicks are measured at the full
+// report rate instead of the polling rate. Positions are touchpad units
+// (see DSTouchPoint), velocities touchpad units per second from the device
+// sensor clock. A touch that involved two fingers never ends in a tap or swipe.
+
+typedef enum {
+    DS_GESTURE_TAP = 0,         // Short one-finger touch without movement
+    DS_GESTURE_DOUBLE_TAP = 1,  // Tap soon after and near a tap (reported instead of a second TAP)
+    DS_GESTURE_SWIPE = 2,       // One finger moved and lifted while still moving
+    DS_GESTURE_PINCH = 3,       // Two fingers moving apart or together
+    DS_GESTURE_SCROLL = 4       // Two fingers moving in the same direction
+} DSGestureType;
+
+typedef enum {
+    DS_GESTURE_PHASE_BEGIN = 0,     // PINCH / SCROLL recognized
+    DS_GESTURE_PHASE_UPDATE = 1,    // PINCH / SCROLL fingers moved
+    DS_GESTURE_PHASE_END = 2        // PINCH / SCROLL finger lifted; TAP, DOUBLE_TAP and SWIPE are a single END
+} DSGesturePhase;
+
+typedef struct {
+    uint64_t timestamp_us;      // Device sensor clock of the report (see DSInputState)
+    uint32_t sequence;          // Input report sequence number (as in DSEvent)
+    uint32_t duration_us;       // Since the finger (TAP, SWIPE) or the second finger (PINCH, SCROLL) touched
+    uint8_t type;               // DSGestureType
+    uint8_t phase;              // DSGesturePhase
+    float x;                    // Lift position (TAP, SWIPE) or midpoint of the two fingers
+    float y;
+    float delta_x;              // Touch to lift (TAP, SWIPE) or midpoint movement since the previous event
+    float delta_y;
+    float velocity_x;           // Finger at lift (SWIPE) or midpoint velocity
+    float velocity_y;
+    float scale;                // Finger distance / distance when the second finger touched (1 for one finger)
+    float scale_velocity;       // Change of scale per second
+} DSGestureEvent;
+
+// Capacity of the per-device gesture queue
+#define DS_GESTURE_QUEUE_SIZE 256
+
+// Drain up to max_gestures queued gestures, oldest first, without blocking
+// Call from one thread only. When the queue is full new gestures are dropped
+// and counted in DSInputCounters::gestures_dropped.
+DUALSENSE_API DSResult ds_poll_gestures(DSGestureEvent* gestures, uint32_t max_gestures, uint32_t* out_count);
+
+// ========================================
+// Packed Input
+// ========================================
+// The input state in a fixed 64-byte layout without bools or padding, for
+// callers that marshal it (managed languages) or process it in bulk.
+// Sticks are -32768..32767 (0 = center, raw axis directions), triggers
+// 0..32767, motion fixed-point at the scales below, orientation * 32767.
+
+#define DS_PACKED_GYRO_SCALE 16         // LSB per deg/s (+-2048 deg/s)
+#define DS_PACKED_ACCEL_SCALE 8192      // LSB per g (+-4 g)
+
+// DSPackedInputState::flags
+#define DS_PACKED_CHARGING 0x01
+#define DS_PACKED_TOUCH1_ACTIVE 0x02
+#define DS_PACKED_TOUCH2_ACTIVE 0x04
+
+typedef struct DS_ALIGN(32) DSPackedInputState {
+    uint32_t buttons;               // Bit (1 << DSButton) per pressed button
+    int16_t left_x;
+    int16_t left_y;
+    int16_t right_x;
+    int16_t right_y;
+    int16_t l2;
+    int16_t r2;
+    int16_t gyro[3];                // Pitch, yaw, roll rate
+    int16_t accel[3];               // X, Y, Z
+    int16_t orientation[4];         // W, X, Y, Z
+    uint16_t touch_x[2];            // Touch slot 1, 2
+    uint16_t touch_y[2];
+    uint8_t touch_id[2];
+    uint8_t battery_level;          // 0-100
+    uint8_t flags;                  // DS_PACKED_* bits
+    uint64_t sensor_timestamp_us;
+    uint8_t reserved[8];
+} DSPackedInputState;
+
+// Get the current input state in packed form (same snapshot as ds_get_input_state)
+DUALSENSE_API DSResult ds_get_packed_input_state(DSPackedInputState* out_state);
+
+// Every open handle's packed state as structure-of-arrays columns, indexed
+// by DSHandle. Columns of handles without a connected controller are zero.
+typedef struct DS_ALIGN(32) DSInputStateSoA {
+    uint32_t buttons[DS_MAX_DEVICES];
+    int16_t left_x[DS_MAX_DEVICES];
+    int16_t left_y[DS_MAX_DEVICES];
+    int16_t right_x[DS_MAX_DEVICES];
+    int16_t right_y[DS_MAX_DEVICES];
+    int16_t l2[DS_MAX_DEVICES];
+    int16_t r2[DS_MAX_DEVICES];
+    int16_t gyro_x[DS_MAX_DEVICES];
+    int16_t gyro_y[DS_MAX_DEVICES];
+    int16_t gyro_z[DS_MAX_DEVICES];
+    int16_t accel_x[DS_MAX_DEVICES];
+    int16_t accel_y[DS_MAX_DEVICES];
+    int16_t accel_z[DS_MAX_DEVICES];
+    int16_t orientation_w[DS_MAX_DEVICES];
+    int16_t orientation_x[DS_MAX_DEVICES];
+    int16_t orientation_y[DS_MAX_DEVICES];
+    int16_t orientation_z[DS_MAX_DEVICES];
+    uint16_t touch1_x[DS_MAX_DEVICES];
+    uint16_t touch1_y[DS_MAX_DEVICES];
+    uint16_t touch2_x[DS_MAX_DEVICES];
+    uint16_t touch2_y[DS_MAX_DEVICES];
+    uint8_t touch1_id[DS_MAX_DEVICES];
+    uint8_t touch2_id[DS_MAX_DEVICES];
+    uint8_t battery_level[DS_MAX_DEVICES];
+    uint8_t flags[DS_MAX_DEVICES];
+    uint64_t sensor_timestamp_us[DS_MAX_DEVICES];
+    uint32_t connected_mask;        // Bit (1 << handle) per connected controller
+} DSInputStateSoA;
+
+// Fill out_states from every open handle in one call (lock-free snapshots)
+DUALSENSE_API DSResult ds_get_all_states(DSInputStateSoA* out_states);
+
+// ========================================
+// Analog Response
+// ========================================
+// Deadzones and response curves for sticks and triggers, compiled into
+// lookup tables when set and applied to every input report, so the
+// normalized values of ds_get_analog_state need no further math.
+// The default is linear with no deadzone.
+
+#define DS_CURVE_MAX_POINTS 16
+
+// Maps a 0-1 magnitude (stick distance from center or trigger travel):
+// up to deadzone -> 0, from outer_threshold -> 1, and in between
+// anti_deadzone + (1 - anti_deadzone) * shape(t) with t rescaled to 0-1
+typedef struct {
+    float deadzone;                         // 0 <= deadzone < outer_threshold
+    float outer_threshold;                  // <= 1
+    float anti_deadzone;                    // Smallest output past the deadzone (0 <= x < 1)
+    float exponent;                         // shape(t) = t^exponent (> 0, 1 = linear)
+    uint32_t point_count;                   // 2+: shape from points instead of exponent
+    float points[DS_CURVE_MAX_POINTS];      // shape at evenly spaced t (0-1, linear in between)
+} DSResponseCurve;
+
+typedef enum {
+    DS_DEADZONE_AXIAL = 0,      // Each axis on its own (square)
+    DS_DEADZONE_RADIAL = 1      // Distance from center (circle; direction kept)
+} DSDeadzoneShape;
+
+typedef struct {
+    DSDeadzoneShape shape;
+    DSResponseCurve curve;
+} DSStickResponse;
+
+// Processed analog input of the latest report
+typedef struct {
+    float left_x;               // -1..1, raw axis directions (+y = down)
+    float left_y;
+    float right_x;
+    float right_y;
+    float l2;                   // 0..1
+    float r2;
+    uint64_t sensor_timestamp_us;
+} DSAnalogState;
+
+// Set the response of a stick (0 = left, 1 = right); NULL restores the default
+// Takes effect from the next input report.
+DUALSENSE_API DSResult ds_set_stick_response(uint32_t stick, const DSStickResponse* response);
+
+// Set the response of a trigger (0 = L2, 1 = R2); NULL restores the default
+DUALSENSE_API DSResult ds_set_trigger_response(uint32_t trigger, const DSResponseCurve* curve);
+
+// Get the processed analog state (lock-free snapshot, like ds_get_input_state)
+DUALSENSE_API DSResult ds_get_analog_state(DSAnalogState* out_state);
+
 // ========================================
 // LED Control
 // ========================================
@@ -255,6 +608,51 @@ DUALSENSE_API DSResult ds_trigger_custom(
     const uint8_t params[10]
 );
 
+// ========================================
+// Effect Timeline
+// ========================================
+
+// Output field driven by a keyframe
+typedef enum {
+    DS_TIMELINE_LIGHTBAR = 0,       // value[0..2] = R, G, B
+    DS_TIMELINE_RUMBLE = 1,         // value[0..1] = left, right
+    DS_TIMELINE_PLAYER_LED = 2,     // value[0] = DSLedPlayer, value[1] = DSLedBrightness (never interpolated)
+    DS_TIMELINE_LEFT_TRIGGER = 3,   // value[0] = effect mode byte, value[1..10] = effect parameters
+    DS_TIMELINE_RIGHT_TRIGGER = 4   // Parameters are interpolated only between keyframes of the same mode
+} DSTimelineTarget;
+
+// Interpolation from the previous keyframe of the same target
+typedef enum {
+    DS_CURVE_STEP = 0,              // Hold the previous value, jump at this keyframe
+    DS_CURVE_LINEAR = 1,
+    DS_CURVE_EASE_IN = 2,           // Quadratic, slow start
+    DS_CURVE_EASE_OUT = 3,          // Quadratic, slow end
+    DS_CURVE_EASE_IN_OUT = 4        // Smoothstep
+} DSCurve;
+
+typedef struct {
+    uint32_t time_ms;               // Offset from the start of the timeline
+    uint8_t target;                 // DSTimelineTarget
+    uint8_t curve;                  // DSCurve
+    uint8_t value[11];              // Target value (layout depends on target)
+} DSKeyframe;
+
+// Maximum keyframes in one timeline
+#define DS_MAX_KEYFRAMES 1024
+
+// Play a keyframe timeline, replacing any timeline already playing
+// The library evaluates it on its own tick (the output rate) and sends only
+// reports whose content changed. Targets with keyframes are owned by the
+// timeline while it plays; a target holds its last value after its last keyframe.
+// loop: restart from 0 ms after the last keyframe
+DUALSENSE_API DSResult ds_play_timeline(const DSKeyframe* keyframes, uint32_t count, bool loop);
+
+// Stop the timeline (outputs keep their current values)
+DUALSENSE_API DSResult ds_stop_timeline(void);
+
+// Check whether a timeline is playing (false once a non-looping one has ended)
+DUALSENSE_API DSResult ds_is_timeline_playing(bool* out_playing);
+
 // ========================================
 // Audio Haptics (Bluetooth only)
 // ========================================
@@ -262,6 +660,50 @@ DUALSENSE_API DSResult ds_trigger_custom(
 // Send audio haptic data
 DUALSENSE_API DSResult ds_send_audio_haptic(const uint8_t* data, uint32_t size);
 
+// Haptic stream format: stereo interleaved signed 8-bit samples (L, R, L, R, ...)
+#define DS_HAPTIC_SAMPLE_RATE 3000
+#define DS_HAPTIC_FRAMES_PER_PACKET 32
+
+// Haptic stream statistics
+typedef struct {
+    uint64_t packets_sent;      // Haptic reports sent
+    uint64_t underruns;         // Times the buffer ran dry during playback while still being written
+    uint32_t buffered_frames;   // Frames queued and not yet sent
+    uint32_t prebuffer_frames;  // Current adaptive pre-buffer depth
+} DSHapticStreamStats;
+
+// Start a thread that sends queued haptic samples at the controller's rate
+// Playback begins once the adaptive pre-buffer is filled; every underrun
+// deepens it by one packet, and it shrinks again while playback is stable.
+// Running out after the application stops writing ends the stream instead
+// (not an underrun); the next write starts playback again.
+DUALSENSE_API DSResult ds_start_haptic_stream(void);
+
+// Stop the haptic stream thread and discard queued samples
+DUALSENSE_API DSResult ds_stop_haptic_stream(void);
+
+// Queue any number of stereo frames without blocking (one producer thread)
+// Frames that do not fit in the ring are not queued; see out_frames_written.
+DUALSENSE_API DSResult ds_write_haptic_stream(const int8_t* samples, uint32_t frame_count,
+                                              uint32_t* out_frames_written);
+
+// Get haptic stream statistics
+DUALSENSE_API DSResult ds_get_haptic_stream_stats(DSHapticStreamStats* out_stats);
+
+// Configure PCM conversion for ds_write_haptic_pcm_* (call from the producer thread)
+// sample_rate: input rate >= 3000 Hz (8000, 16000, 22050, 32000, 44100, 48000, 96000, ...)
+// channels: 1 (mono, sent to both actuators) or 2 (interleaved L/R)
+// gain: linear gain applied before 8-bit quantization (1.0 = full scale)
+DUALSENSE_API DSResult ds_configure_haptic_pcm(uint32_t sample_rate, uint32_t channels, float gain);
+
+// Resample PCM to the haptic stream rate and queue it without blocking
+// Input is low-pass filtered, decimated, gained and dithered to 8 bits.
+// Only frames whose output fits in the ring are consumed; see out_frames_consumed.
+DUALSENSE_API DSResult ds_write_haptic_pcm_f32(const float* samples, uint32_t frame_count,
+                                               uint32_t* out_frames_consumed);
+DUALSENSE_API DSResult ds_write_haptic_pcm_s16(const int16_t* samples, uint32_t frame_count,
+                                               uint32_t* out_frames_consumed);
+
 // ========================================
 // Utility Functions
 // ========================================
@@ -270,8 +712,309 @@ DUALSENSE_API DSResult ds_send_audio_haptic(const uint8_t* data, uint32_t size);
 DUALSENSE_API DSResult ds_reset_all(void);
 
 // Flush output immediately
+// Always writes the current report, even if it is unchanged.
 DUALSENSE_API DSResult ds_flush_output(void);
 
+// ========================================
+// Output Report Elision
+// ========================================
+// Setters only write when the composed report differs from the last one
+// sent. An identical report is resent once the keepalive interval expires.
+
+// Default keepalive interval for identical output reports
+#define DS_DEFAULT_OUTPUT_KEEPALIVE_MS 1000
+
+// Output write counters (since the device was opened)
+typedef struct {
+    uint64_t reports_written;   // Reports sent to the device
+    uint64_t reports_elided;    // Redundant reports that were skipped
+    uint64_t write_failures;    // Writes rejected by the device or OS
+} DSOutputCounters;
+
+// Set keepalive interval in ms (0 = never resend an identical report)
+DUALSENSE_API DSResult ds_set_output_keepalive(uint32_t interval_ms);
+
+// Get output write counters
+DUALSENSE_API DSResult ds_get_output_counters(DSOutputCounters* out_counters);
+
+// ========================================
+// Output Writer Thread
+// ========================================
+// While the writer thread runs, setters only store the new state in a
+// single-slot mailbox and return without I/O. The thread sends the newest
+// state at no more than the configured rate; intermediate states are
+// coalesced (counted as elided).
+
+// Default writer rates (reports per second)
+#define DS_DEFAULT_OUTPUT_RATE_USB 250
+#define DS_DEFAULT_OUTPUT_RATE_BT 125
+
+// Start the background output writer thread
+DUALSENSE_API DSResult ds_start_output_thread(void);
+
+// Stop the writer thread after it sends any pending state
+DUALSENSE_API DSResult ds_stop_output_thread(void);
+
+// Set the maximum writer rate (0 = unlimited)
+DUALSENSE_API DSResult ds_set_output_rate(uint32_t reports_per_second);
+
+// ========================================
+// Automatic Reconnect
+// ========================================
+// A background watcher listens for controllers being unplugged and plugged
+// back in (udev uevents on Linux, periodic enumeration on Windows). When a
+// controller returns, the handle that lost it is reopened in place: the last
+// lightbar, player LED, mic LED, rumble and trigger state is sent again, and
+// the input, output and haptic threads that were running are restarted.
+// A returning controller is matched to its old handle by its Bluetooth
+// address, and never takes the handle of a different controller. Only when
+// the address cannot be read does it fall back to device path, then model.
+// Applies to every open handle.
+
+typedef struct {
+    uint32_t disconnects;       // Connections lost (not counting ds_close)
+    uint32_t reconnects;        // Successful automatic reopens
+    uint64_t last_downtime_us;  // Disconnect to reopened, last reconnect
+    uint64_t last_reopen_us;    // Open, calibration and state resend, last reconnect
+} DSReconnectStats;
+
+// Start or stop the hotplug watcher (off by default)
+DUALSENSE_API DSResult ds_set_auto_reconnect(bool enabled);
+
+// Get reconnect statistics (available while disconnected)
+DUALSENSE_API DSResult ds_get_reconnect_stats(DSReconnectStats* out_stats);
+
+// ========================================
+// Runtime Statistics
+// ========================================
+// Per-device counters and latency histograms, recorded on the I/O paths
+// with atomics (no locks). Everything counts from when the device was
+// opened or the statistics were last reset; reconnects keep them.
+// Input reports are also followed by their report counter and sensor clock:
+// lost reports (radio or a full OS queue), repeated and out-of-order reports
+// are counted, and jitter is the difference between the spacing at which
+// reports arrived and the spacing at which the controller sent them.
+
+// Histogram bucket 0 counts durations under 1 us, bucket i durations in
+// [2^(i-1), 2^i) us, and the last bucket everything from 2^22 us (~4.2 s) up
+#define DS_HISTOGRAM_BUCKETS 24
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t max_us;
+    uint64_t buckets[DS_HISTOGRAM_BUCKETS];
+} DSHistogram;
+
+typedef struct {
+    uint64_t reports_received;      // Input reports published
+    uint64_t reports_dropped;       // Input reports discarded (bad CRC, unexpected ID or size)
+    uint64_t read_errors;           // Failed input reads
+    uint64_t reports_written;       // Output reports sent
+    uint64_t reports_elided;        // Output reports skipped as unchanged
+    uint64_t write_failures;        // Output and audio writes that failed
+    uint64_t audio_reports;         // Audio haptic reports sent
+    uint64_t audio_underruns;       // Haptic stream ran out of samples
+    uint64_t sequence_gaps;         // Times one or more input reports went missing
+    uint64_t reports_lost;          // Input reports missing in those gaps (including bad CRCs)
+    uint64_t reports_duplicated;    // Input reports repeating the previous one (not published)
+    uint64_t reports_reordered;     // Input reports older than one already seen (not published)
+    uint32_t device_interval_us;    // Input report period measured by the controller's clock
+    DSHistogram report_interval;    // Time between input reports arriving
+    DSHistogram report_wait;        // Read call start to report returned: mostly the wait for the controller,
+                                    // not the cost of the read itself
+    DSHistogram write_latency;      // Output and audio write calls
+    DSHistogram input_age;          // Age of the input returned by ds_get_input_state
+    DSHistogram jitter;             // |arrival spacing - controller spacing| of consecutive reports
+} DSStats;
+
+// Get runtime statistics (available while disconnected)
+DUALSENSE_API DSResult ds_get_stats(DSStats* out_stats);
+
+// Zero all counters and histograms
+DUALSENSE_API DSResult ds_reset_stats(void);
+
+// ========================================
+// Capture and Replay
+// ========================================
+// A capture records every raw report read from and written to a controller
+// (input, output, audio haptics and the calibration feature report) with
+// its timestamp in a compact binary file. Each report only stores the bytes
+// that changed since the previous report of the same kind.
+// A replay opens such a file as a virtual controller handle: input reports
+// are served again at their original timing or back to back, and writes are
+// accepted and discarded. At the end of the file the handle reports a
+// disconnect unless it loops.
+
+typedef enum {
+    DS_REPLAY_REALTIME = 0,     // Original report timing
+    DS_REPLAY_FAST = 1          // As fast as input is read
+} DSReplayMode;
+
+// Start capturing raw reports to a file (replaces a running capture)
+DUALSENSE_API DSResult ds_start_capture(const char* path);
+
+// Stop capturing and close the file
+DUALSENSE_API DSResult ds_stop_capture(void);
+
+// Open a capture file as a virtual controller
+DUALSENSE_API DSResult ds_open_replay(const char* path, DSReplayMode mode, bool loop, DSHandle* out_handle);
+
+// ========================================
+// Software Emulator
+// ========================================
+// An emulated controller is a virtual handle backed by an in-process model
+// of the device instead of hardware. It produces well-formed input reports
+// (USB 64 bytes, Bluetooth 78 bytes with CRC) for the configured model at
+// a fixed rate, from input set by the application or played from a script.
+// Output and audio haptic reports written to it are checked for report ID,
+// size and CRC and counted. Faults can be injected: dropped reports,
+// corrupted Bluetooth CRCs and disconnects.
+// Motion values are sent with the nominal IMU calibration, so they read
+// back unchanged apart from 16-bit quantization and bias estimation.
+
+typedef struct {
+    DSDeviceType device_type;           // Model to emulate
+    DSConnectionType connection_type;   // USB or Bluetooth report format
+    uint32_t report_rate_hz;            // Input reports per second (0 = as fast as read)
+    uint32_t drop_per_million;          // Reports silently lost (sequence still advances)
+    uint32_t crc_error_per_million;     // Reports sent with a bad CRC (Bluetooth only)
+    uint64_t disconnect_after_reports;  // Disconnect after this many reports (0 = never)
+    uint32_t seed;                      // Fault pattern seed (same seed, same faults)
+} DSEmulatorConfig;
+
+// One step of an input script: state is sent for hold_reports reports
+typedef struct {
+    DSInputState state;
+    uint32_t hold_reports;
+} DSEmulatorStep;
+
+typedef struct {
+    uint64_t reports_sent;          // Input reports delivered to the reader
+    uint64_t reports_dropped;       // Lost to injected drops
+    uint64_t reports_corrupted;     // Sent with an injected CRC error
+    uint64_t reports_overwritten;   // Discarded by a flush or a full input queue
+    uint64_t output_reports;        // Valid output reports received
+    uint64_t audio_reports;         // Valid audio haptic reports received
+    uint64_t invalid_writes;        // Writes with a wrong ID, size or CRC
+} DSEmulatorStats;
+
+// Open an emulated controller as a virtual handle
+DUALSENSE_API DSResult ds_open_emulator(const DSEmulatorConfig* config, DSHandle* out_handle);
+
+// Set the input state sent from the next report on (stops a running script)
+DUALSENSE_API DSResult ds_emulator_set_input(DSHandle handle, const DSInputState* state);
+
+// Play a script of input states (copied); the last state is held at the end
+DUALSENSE_API DSResult ds_emulator_play_script(DSHandle handle, const DSEmulatorStep* steps, uint32_t count, bool loop);
+
+// Simulate the controller being unplugged
+DUALSENSE_API DSResult ds_emulator_disconnect(DSHandle handle);
+
+// Get report and fault counters of an emulated controller
+DUALSENSE_API DSResult ds_get_emulator_stats(DSHandle handle, DSEmulatorStats* out_stats);
+
+// Copy the last valid output report the emulator received
+// Returns DS_ERROR_NOT_FOUND if none has been written yet.
+DUALSENSE_API DSResult ds_emulator_get_output(DSHandle handle, uint8_t* buffer, uint32_t size, uint32_t* out_size);
+
+// ========================================
+// Multi-Device API
+// ========================================
+// ds_xxx_ex(handle, ...) behaves like ds_xxx(...) on the given controller.
+// Every device has its own lock, buffers and threads, so calls on one
+// handle never wait for I/O on another. The functions above operate on
+// the default device connected by ds_init.
+
+// Enumerate connected controllers and return how many were found
+// ds_open indexes refer to the list built by the most recent call.
+DUALSENSE_API uint32_t ds_get_device_count(void);
+
+// Open the index-th enumerated controller
+DUALSENSE_API DSResult ds_open(uint32_t index, DSHandle* out_handle);
+
+// Reset effects and close a handle
+DUALSENSE_API DSResult ds_close(DSHandle handle);
+
+DUALSENSE_API bool ds_is_connected_ex(DSHandle handle);
+DUALSENSE_API DSConnectionType ds_get_connection_type_ex(DSHandle handle);
+DUALSENSE_API DSDeviceType ds_get_device_type_ex(DSHandle handle);
+
+DUALSENSE_API DSResult ds_update_input_ex(DSHandle handle);
+DUALSENSE_API DSResult ds_get_input_state_ex(DSHandle handle, DSInputState* out_state);
+DUALSENSE_API DSResult ds_start_input_thread_ex(DSHandle handle);
+DUALSENSE_API DSResult ds_stop_input_thread_ex(DSHandle handle);
+DUALSENSE_API DSResult ds_wait_for_input_ex(DSHandle handle, int64_t timeout_us);
+DUALSENSE_API DSResult ds_get_input_wait_handle_ex(DSHandle handle, intptr_t* out_handle);
+DUALSENSE_API DSResult ds_set_input_crc_check_ex(DSHandle handle, bool enabled);
+DUALSENSE_API DSResult ds_get_input_counters_ex(DSHandle handle, DSInputCounters* out_counters);
+DUALSENSE_API DSResult ds_poll_events_ex(DSHandle handle, DSEvent* events, uint32_t max_events, uint32_t* out_count);
+DUALSENSE_API DSResult ds_get_input_history_ex(DSHandle handle, DSInputState* states, uint32_t max_states, uint32_t* out_count);
+DUALSENSE_API DSResult ds_get_input_aggregate_ex(DSHandle handle, DSInputAggregate* out_aggregate);
+DUALSENSE_API DSResult ds_poll_gestures_ex(DSHandle handle, DSGestureEvent* gestures, uint32_t max_gestures, uint32_t* out_count);
+DUALSENSE_API DSResult ds_get_packed_input_state_ex(DSHandle handle, DSPackedInputState* out_state);
+DUALSENSE_API DSResult ds_set_stick_response_ex(DSHandle handle, uint32_t stick, const DSStickResponse* response);
+DUALSENSE_API DSResult ds_set_trigger_response_ex(DSHandle handle, uint32_t trigger, const DSResponseCurve* curve);
+DUALSENSE_API DSResult ds_get_analog_state_ex(DSHandle handle, DSAnalogState* out_state);
+
+DUALSENSE_API DSResult ds_set_lightbar_ex(DSHandle handle, uint8_t r, uint8_t g, uint8_t b);
+DUALSENSE_API DSResult ds_set_player_led_ex(DSHandle handle, DSLedPlayer led, DSLedBrightness brightness);
+DUALSENSE_API DSResult ds_set_mic_led_ex(DSHandle handle, DSLedMic mode);
+
+DUALSENSE_API DSResult ds_set_rumble_ex(DSHandle handle, uint8_t left, uint8_t right);
+DUALSENSE_API DSResult ds_stop_rumble_ex(DSHandle handle);
+
+DUALSENSE_API DSResult ds_trigger_off_ex(DSHandle handle, bool left, bool right);
+DUALSENSE_API DSResult ds_trigger_continuous_resistance_ex(DSHandle handle, bool left, bool right,
+    uint8_t start_position, uint8_t force);
+DUALSENSE_API DSResult ds_trigger_bow_ex(DSHandle handle, bool left, bool right,
+    uint8_t start_position, uint8_t end_position, uint8_t strength_start, uint8_t strength_end);
+DUALSENSE_API DSResult ds_trigger_galloping_ex(DSHandle handle, bool left, bool right,
+    uint8_t start_position, uint8_t end_position, uint8_t first_foot, uint8_t second_foot, uint8_t frequency);
+DUALSENSE_API DSResult ds_trigger_resistance_ex(DSHandle handle, bool left, bool right,
+    uint8_t strength_start, uint8_t strength_mid, uint8_t strength_end);
+DUALSENSE_API DSResult ds_trigger_weapon_ex(DSHandle handle, bool left, bool right,
+    uint8_t start_position, uint8_t end_position, uint8_t strength);
+DUALSENSE_API DSResult ds_trigger_automatic_gun_ex(DSHandle handle, bool left, bool right,
+    uint8_t start_position, uint8_t strength, uint8_t frequency);
+DUALSENSE_API DSResult ds_trigger_machine_ex(DSHandle handle, bool left, bool right,
+    uint8_t start_position, uint8_t amplitude, uint8_t frequency);
+DUALSENSE_API DSResult ds_trigger_custom_ex(DSHandle handle, bool left, bool right, const uint8_t params[10]);
+
+DUALSENSE_API DSResult ds_play_timeline_ex(DSHandle handle, const DSKeyframe* keyframes, uint32_t count, bool loop);
+DUALSENSE_API DSResult ds_stop_timeline_ex(DSHandle handle);
+DUALSENSE_API DSResult ds_is_timeline_playing_ex(DSHandle handle, bool* out_playing);
+
+DUALSENSE_API DSResult ds_send_audio_haptic_ex(DSHandle handle, const uint8_t* data, uint32_t size);
+DUALSENSE_API DSResult ds_start_haptic_stream_ex(DSHandle handle);
+DUALSENSE_API DSResult ds_stop_haptic_stream_ex(DSHandle handle);
+DUALSENSE_API DSResult ds_write_haptic_stream_ex(DSHandle handle, const int8_t* samples, uint32_t frame_count,
+                                                 uint32_t* out_frames_written);
+DUALSENSE_API DSResult ds_get_haptic_stream_stats_ex(DSHandle handle, DSHapticStreamStats* out_stats);
+DUALSENSE_API DSResult ds_configure_haptic_pcm_ex(DSHandle handle, uint32_t sample_rate, uint32_t channels, float gain);
+DUALSENSE_API DSResult ds_write_haptic_pcm_f32_ex(DSHandle handle, const float* samples, uint32_t frame_count,
+                                                  uint32_t* out_frames_consumed);
+DUALSENSE_API DSResult ds_write_haptic_pcm_s16_ex(DSHandle handle, const int16_t* samples, uint32_t frame_count,
+                                                  uint32_t* out_frames_consumed);
+
+DUALSENSE_API DSResult ds_reset_all_ex(DSHandle handle);
+DUALSENSE_API DSResult ds_flush_output_ex(DSHandle handle);
+
+DUALSENSE_API DSResult ds_set_output_keepalive_ex(DSHandle handle, uint32_t interval_ms);
+DUALSENSE_API DSResult ds_get_output_counters_ex(DSHandle handle, DSOutputCounters* out_counters);
+
+DUALSENSE_API DSResult ds_start_output_thread_ex(DSHandle handle);
+DUALSENSE_API DSResult ds_stop_output_thread_ex(DSHandle handle);
+DUALSENSE_API DSResult ds_set_output_rate_ex(DSHandle handle, uint32_t reports_per_second);
+
+DUALSENSE_API DSResult ds_get_reconnect_stats_ex(DSHandle handle, DSReconnectStats* out_stats);
+
+DUALSENSE_API DSResult ds_get_stats_ex(DSHandle handle, DSStats* out_stats);
+DUALSENSE_API DSResult ds_reset_stats_ex(DSHandle handle);
+
+DUALSENSE_API DSResult ds_start_capture_ex(DSHandle handle, const char* path);
+DUALSENSE_API DSResult ds_stop_capture_ex(DSHandle handle);
+
 #ifdef __cplusplus
 }
 #endif
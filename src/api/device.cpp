@@ -0,0 +1,1701 @@
+// Device Implementation
+
+#include "device.h"
+#include "../hid/transport.h"
+#include "../protocol/crc32.h"
+#include "../protocol/device_identity.h"
+#include "../protocol/input_events.h"
+#include "../protocol/input_packing.h"
+#include "../protocol/input_parser.h"
+#include "../protocol/motion.h"
+#include "../protocol/output_composer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+
+namespace {
+
+// Read timeout used by the background reader so it can notice a stop request
+constexpr int INPUT_THREAD_READ_TIMEOUT_MS = 50;
+
+// Queued reports ds_update_input publishes per call (the depth of the hidraw
+// queue), so a transport that always has data cannot keep it spinning
+constexpr uint32_t UPDATE_INPUT_MAX_REPORTS = 64;
+
+// Haptic stream pacing: one report per packet of frames at the controller rate
+constexpr uint32_t HAPTIC_FRAMES_PER_PACKET = dualsense::protocol::HAPTIC_SAMPLES_PER_REPORT / 2;
+constexpr std::chrono::nanoseconds HAPTIC_PACKET_PERIOD(1000000000LL * HAPTIC_FRAMES_PER_PACKET / DS_HAPTIC_SAMPLE_RATE);
+
+// Adaptive pre-buffer (frames): one packet deeper per underrun, one packet
+// shallower after HAPTIC_STABLE_PACKETS sent without an underrun
+constexpr uint32_t HAPTIC_PREBUFFER_MIN_FRAMES = 2 * HAPTIC_FRAMES_PER_PACKET;
+constexpr uint32_t HAPTIC_PREBUFFER_INITIAL_FRAMES = 3 * HAPTIC_FRAMES_PER_PACKET;
+constexpr uint32_t HAPTIC_PREBUFFER_MAX_FRAMES = 30 * HAPTIC_FRAMES_PER_PACKET;
+constexpr uint32_t HAPTIC_STABLE_PACKETS = 300;
+
+// Timeline tick rate when the output rate is unlimited
+constexpr uint32_t TIMELINE_DEFAULT_TICK_HZ = 250;
+
+// Stereo frames converted per pass when writing PCM into the haptic ring
+constexpr size_t HAPTIC_PCM_BLOCK_FRAMES = 256;
+
+// Default output thread rate for a connection type (reports per second)
+uint32_t DefaultOutputRate(int connection_type) {
+    return (connection_type == DS_CONNECTION_BLUETOOTH) ? DS_DEFAULT_OUTPUT_RATE_BT : DS_DEFAULT_OUTPUT_RATE_USB;
+}
+
+} // anonymous namespace
+
+namespace dualsense {
+
+DSResult Device::Open(const DeviceInfo& device_info, std::unique_ptr<hid::Transport> transport) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (device_.is_connected) {
+        return DS_ERROR_ALREADY_CONNECTED;
+    }
+
+    return OpenLocked(device_info, lock, std::move(transport), false);
+}
+
+DSResult Device::OpenLocked(const DeviceInfo& device_info, std::unique_lock<std::mutex>& lock,
+                            std::unique_ptr<hid::Transport> transport, bool reconnect) {
+    // Release anything left over from a device that disconnected
+    StopTimelineLocked(lock);
+    StopInputThreadLocked();
+    StopOutputThreadLocked();
+    StopHapticStreamLocked();
+    if (device_.transport) {
+        device_.transport->Close();
+        device_.transport.reset();
+    }
+    input_snapshot_.Store(DSInputState{});
+    last_event_state_ = DSInputState{};
+    // The application may be polling these right now; it drops the old
+    // entries itself on its next read
+    event_queue_.MarkDiscarded();
+    history_.MarkDiscarded();
+    gestures_.Reset();
+    gesture_queue_.MarkDiscarded();
+    analog_snapshot_.Store(DSAnalogState{});
+    {
+        std::lock_guard<std::mutex> aggregate_lock(aggregate_mutex_);
+        aggregate_state_ = DSInputState{};
+        protocol::StartAggregate(aggregate_state_, &aggregate_);
+    }
+    last_report_time_ = std::chrono::steady_clock::time_point();
+    published_us_ = 0;
+    sequence_tracker_.Reset();
+
+    input_format_ = protocol::GetInputFormat(device_info.device_type, device_info.connection_type);
+    output_format_ = protocol::GetOutputFormat(device_info.device_type, device_info.connection_type);
+    if (!input_format_ || !output_format_) {
+        return DS_ERROR_NOT_FOUND;
+    }
+
+    device_.path = device_info.path;
+    device_.device_type = device_info.device_type;
+    device_.connection_type = device_info.connection_type;
+    last_output_size_ = 0;
+
+    // A reconnect keeps the application's settings, effects, capture and counters
+    if (!reconnect) {
+        StopCaptureLocked();
+        is_virtual_ = transport != nullptr;
+        device_.output = OutputContext();
+        input_thread_wanted_ = false;
+        output_thread_wanted_ = false;
+        haptic_stream_wanted_ = false;
+        output_keepalive_ms_ = DS_DEFAULT_OUTPUT_KEEPALIVE_MS;
+        output_rate_hz_ = DefaultOutputRate(device_info.connection_type);
+        verify_input_crc_ = false;
+        input_reports_ = 0;
+        input_crc_errors_ = 0;
+        events_dropped_ = 0;
+        history_dropped_ = 0;
+        gestures_dropped_ = 0;
+        {
+            std::lock_guard<std::mutex> analog_lock(analog_mutex_);
+            PublishAnalogTablesLocked(std::unique_ptr<protocol::AnalogTables>(new protocol::AnalogTables()));
+        }
+        reports_written_ = 0;
+        reports_elided_ = 0;
+        write_failures_ = 0;
+        disconnects_ = 0;
+        reconnects_ = 0;
+        last_downtime_us_ = 0;
+        last_reopen_us_ = 0;
+        stats_.Reset();
+    }
+
+    if (!input_signal_) {
+        input_signal_ = hid::CreateSignal();
+        if (!input_signal_) {
+            return DS_ERROR_IO_FAILED;
+        }
+    }
+
+    device_.transport = transport ? std::move(transport) : hid::CreateTransport();
+    if (!device_.transport->Open(device_.path)) {
+        printf("Device: Failed to open device\n");
+        device_.transport.reset();
+        return DS_ERROR_IO_FAILED;
+    }
+
+    // The calibration report also enables full input reports over Bluetooth
+    protocol::ImuCalibration calibration;
+    if (!protocol::ReadImuCalibration(*device_.transport, device_.device_type,
+                                      device_.connection_type, &calibration)) {
+        printf("Device: Warning - Failed to read IMU calibration\n");
+    }
+    motion_.Reset();
+    motion_.SetCalibration(calibration);
+    identity_ = is_virtual_ ? std::string()
+                            : protocol::ReadDeviceIdentity(*device_.transport, device_.path, device_.device_type,
+                                                           device_.connection_type);
+
+    device_.is_connected = true;
+
+    printf("Device: Connected to %s via %s (%s)\n",
+           (device_.device_type == DS_DEVICE_DUALSHOCK4) ? "DualShock 4" :
+           (device_.device_type == DS_DEVICE_DUALSENSE_EDGE) ? "DualSense Edge" : "DualSense",
+           (device_.connection_type == DS_CONNECTION_BLUETOOTH) ? "Bluetooth" : "USB",
+           device_.path.c_str());
+
+    return DS_OK;
+}
+
+DSResult Device::Reconnect(const DeviceInfo& device_info) {
+    using Clock = std::chrono::steady_clock;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (device_.is_connected) {
+        return DS_ERROR_ALREADY_CONNECTED;
+    }
+    if (is_virtual_) {
+        return DS_ERROR_NOT_FOUND;
+    }
+
+    // Background work to resume; some of it stopped on its own at the disconnect
+    const bool restart_input = input_thread_wanted_;
+    const bool restart_output = output_thread_wanted_;
+    const bool restart_haptic = haptic_stream_wanted_;
+    const OutputContext output = device_.output;
+
+    const Clock::time_point start = Clock::now();
+    const DSResult result = OpenLocked(device_info, lock, nullptr, true);
+    if (result != DS_OK) {
+        return result;
+    }
+
+    // The controller powered up with defaults: send the whole state again
+    device_.output = output;
+    device_.output.dirty = OUTPUT_DIRTY_ALL;
+    WriteOutput(true);
+
+    if (restart_input) {
+        StartInputThreadLocked();
+    }
+    if (restart_output) {
+        StartOutputThreadLocked();
+    }
+    if (restart_haptic && device_.connection_type == DS_CONNECTION_BLUETOOTH) {
+        StartHapticStreamLocked();
+    }
+
+    const Clock::time_point now = Clock::now();
+    const int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    last_reopen_us_ = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - start).count());
+    last_downtime_us_ = static_cast<uint64_t>(std::max<int64_t>(now_us - disconnect_time_us_, 0));
+    reconnects_++;
+
+    printf("Device: Reconnected after %llu ms (reopen %llu us)\n",
+           static_cast<unsigned long long>(last_downtime_us_ / 1000),
+           static_cast<unsigned long long>(last_reopen_us_.load()));
+    return DS_OK;
+}
+
+void Device::HandleRemoved() {
+    if (MarkDisconnected()) {
+        printf("Device: Removed (%s)\n", device_.path.c_str());
+    }
+}
+
+bool Device::MarkDisconnected() {
+    if (!device_.is_connected.exchange(false)) {
+        return false;
+    }
+
+    disconnect_time_us_ = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    disconnects_++;
+
+    // Wake waiters so they see the disconnect
+    input_signal_->Notify();
+    return true;
+}
+
+DSResult Device::GetReconnectStats(DSReconnectStats* out_stats) {
+    if (!out_stats) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    // Also valid while disconnected, to watch for the device coming back
+    out_stats->disconnects = disconnects_;
+    out_stats->reconnects = reconnects_;
+    out_stats->last_downtime_us = last_downtime_us_;
+    out_stats->last_reopen_us = last_reopen_us_;
+    return DS_OK;
+}
+
+DSResult Device::GetStats(DSStats* out_stats) {
+    if (!out_stats) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    // Lock-free and valid while disconnected, like the reconnect statistics
+    stats_.Snapshot(out_stats);
+    return DS_OK;
+}
+
+DSResult Device::ResetStats() {
+    stats_.Reset();
+    return DS_OK;
+}
+
+DSResult Device::StartCapture(const char* path) {
+    if (!path) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    StopCaptureLocked();
+
+    std::shared_ptr<hid::CaptureWriter> writer = std::make_shared<hid::CaptureWriter>();
+    if (!writer->Open(path, device_.device_type, device_.connection_type)) {
+        return DS_ERROR_IO_FAILED;
+    }
+
+    // Replays need the calibration, which was read before capturing started
+    unsigned char calibration[protocol::CALIBRATION_REPORT_MAX_SIZE] = {};
+    const size_t calibration_size = protocol::PrepareCalibrationReport(device_.device_type, device_.connection_type, calibration);
+    if (device_.transport->GetFeature(calibration, calibration_size)) {
+        writer->Append(hid::CaptureKind::Feature, calibration, calibration_size);
+    }
+
+    std::atomic_store(&capture_, writer);
+    capturing_ = true;
+
+    printf("Device: Capturing to %s\n", path);
+    return DS_OK;
+}
+
+DSResult Device::StopCapture() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    StopCaptureLocked();
+    return DS_OK;
+}
+
+void Device::StopCaptureLocked() {
+    capturing_ = false;
+
+    // Threads still holding the writer append nothing once it is closed
+    const std::shared_ptr<hid::CaptureWriter> writer = std::atomic_exchange(&capture_, std::shared_ptr<hid::CaptureWriter>());
+    if (writer) {
+        writer->Close();
+        printf("Device: Capture stopped (%llu reports)\n", static_cast<unsigned long long>(writer->GetRecordCount()));
+    }
+}
+
+void Device::CaptureReport(hid::CaptureKind kind, const unsigned char* report, size_t size) {
+    if (!capturing_) {
+        return;
+    }
+    if (const std::shared_ptr<hid::CaptureWriter> writer = std::atomic_load(&capture_)) {
+        writer->Append(kind, report, size);
+    }
+}
+
+bool Device::IsVirtual() const {
+    return is_virtual_;
+}
+
+void Device::Close() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    input_thread_wanted_ = false;
+    output_thread_wanted_ = false;
+    haptic_stream_wanted_ = false;
+    StopTimelineLocked(lock);
+    StopInputThreadLocked();
+    StopOutputThreadLocked();
+    StopHapticStreamLocked();
+
+    if (device_.is_connected) {
+        // Reset all effects before disconnecting
+        device_.output.lightbar = {};
+        device_.output.rumbles = {};
+        device_.output.left_trigger.mode = 0x0;
+        device_.output.right_trigger.mode = 0x0;
+        device_.output.dirty = OUTPUT_DIRTY_ALL;
+        WriteOutput(true);
+
+        device_.is_connected = false;
+        printf("Device: Disconnected\n");
+    }
+
+    // After the effect reset, so the capture ends with it
+    StopCaptureLocked();
+
+    if (device_.transport) {
+        device_.transport->Close();
+        device_.transport.reset();
+    }
+}
+
+const std::string& Device::GetPath() const {
+    return device_.path;
+}
+
+const std::string& Device::GetIdentity() const {
+    return identity_;
+}
+
+bool Device::IsConnected() const {
+    return device_.is_connected;
+}
+
+DSConnectionType Device::GetConnectionType() const {
+    return static_cast<DSConnectionType>(device_.connection_type);
+}
+
+DSDeviceType Device::GetDeviceType() const {
+    return static_cast<DSDeviceType>(device_.device_type);
+}
+
+DSResult Device::UpdateInput() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    // The background reader keeps the snapshot current on its own
+    if (input_thread_running_) {
+        return DS_OK;
+    }
+
+    // Publish everything queued since the last call instead of flushing it,
+    // so no report escapes the events and sequence tracking
+    for (uint32_t reports = 0; reports < UPDATE_INPUT_MAX_REPORTS; reports++) {
+        const DSResult result = ReadInputLocked(0);
+        if (result == DS_ERROR_TIMEOUT) {
+            // Nothing was waiting: block for the next report
+            return (reports == 0) ? ReadInputLocked(-1) : DS_OK;
+        }
+        if (result != DS_OK) {
+            return result;
+        }
+    }
+    return DS_OK;
+}
+
+DSResult Device::ReadInputLocked(int timeout_ms) {
+    std::chrono::steady_clock::time_point arrival;
+    const int bytes_read = ReadReport(device_.buffer_input, timeout_ms, &arrival);
+    if (bytes_read == hid::READ_TIMEOUT && timeout_ms >= 0) {
+        return DS_ERROR_TIMEOUT;
+    }
+    if (bytes_read <= 0) {
+        // Check if device disconnected
+        if (!device_.transport->Ping()) {
+            MarkDisconnected();
+            return DS_ERROR_DISCONNECTED;
+        }
+        return DS_ERROR_IO_FAILED;
+    }
+
+    PublishInput(device_.buffer_input, static_cast<size_t>(bytes_read), arrival);
+    return DS_OK;
+}
+
+int Device::ReadReport(unsigned char* report, int timeout_ms, std::chrono::steady_clock::time_point* out_arrival) {
+    // From the call to the report returning, so this is mostly waiting for the controller
+    const auto start = std::chrono::steady_clock::now();
+    const int result = device_.transport->Read(report, input_format_->report_size, timeout_ms);
+    *out_arrival = std::chrono::steady_clock::now();
+
+    if (result > 0) {
+        stats_.report_wait.Record(ElapsedMicros(start, *out_arrival));
+    }
+    else if (result < 0) {
+        DeviceStats::Count(stats_.read_errors);
+    }
+    return result;
+}
+
+DSResult Device::WaitForInput(int64_t timeout_us) {
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    // The reader publishes and notifies; just block on the signal
+    if (input_thread_running_) {
+        if (!input_signal_->Wait(timeout_us)) {
+            return DS_ERROR_TIMEOUT;
+        }
+        return device_.is_connected ? DS_OK : DS_ERROR_DISCONNECTED;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    // No reader: read the next report here (no flush, so nothing is skipped)
+    const int timeout_ms = (timeout_us < 0) ? -1 : static_cast<int>(std::min<int64_t>((timeout_us + 999) / 1000, INT32_MAX));
+    const DSResult result = ReadInputLocked(timeout_ms);
+
+    // This caller consumed the report, so do not leave the handle ready
+    input_signal_->Wait(0);
+    return result;
+}
+
+DSResult Device::GetInputWaitHandle(intptr_t* out_handle) {
+    if (!out_handle) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    *out_handle = input_signal_->GetNativeHandle();
+    return DS_OK;
+}
+
+DSResult Device::GetInputState(DSInputState* out_state) {
+    if (!out_state) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    // Wait-free path: no I/O and no mutex_, just a snapshot copy
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    *out_state = input_snapshot_.Load();
+
+    const int64_t published_us = published_us_.load(std::memory_order_relaxed);
+    if (published_us != 0) {
+        const int64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        stats_.input_age.Record((now_us > published_us) ? static_cast<uint64_t>(now_us - published_us) : 0);
+    }
+    return DS_OK;
+}
+
+DSResult Device::GetPackedInputState(DSPackedInputState* out_state) {
+    if (!out_state) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    DSInputState state;
+    const DSResult result = GetInputState(&state);
+    if (result != DS_OK) {
+        return result;
+    }
+
+    protocol::PackInputState(state, out_state);
+    return DS_OK;
+}
+
+DSResult Device::SetStickResponse(uint32_t stick, const DSStickResponse* response) {
+    const DSStickResponse config = response ? *response
+                                            : DSStickResponse{ DS_DEADZONE_AXIAL, protocol::DefaultResponseCurve() };
+    if (stick > 1 || (config.shape != DS_DEADZONE_AXIAL && config.shape != DS_DEADZONE_RADIAL) ||
+        !protocol::IsValidResponseCurve(config.curve)) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    // Compile outside the lock; the input path never waits for it
+    protocol::StickTable table;
+    table.Compile(config);
+
+    std::lock_guard<std::mutex> analog_lock(analog_mutex_);
+    std::unique_ptr<protocol::AnalogTables> tables(new protocol::AnalogTables(*analog_tables_owner_));
+    tables->SetStick(stick, std::move(table));
+    PublishAnalogTablesLocked(std::move(tables));
+    return DS_OK;
+}
+
+DSResult Device::SetTriggerResponse(uint32_t trigger, const DSResponseCurve* curve) {
+    const DSResponseCurve config = curve ? *curve : protocol::DefaultResponseCurve();
+    if (trigger > 1 || !protocol::IsValidResponseCurve(config)) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    protocol::TriggerTable table;
+    table.Compile(config);
+
+    std::lock_guard<std::mutex> analog_lock(analog_mutex_);
+    std::unique_ptr<protocol::AnalogTables> tables(new protocol::AnalogTables(*analog_tables_owner_));
+    tables->SetTrigger(trigger, table);
+    PublishAnalogTablesLocked(std::move(tables));
+    return DS_OK;
+}
+
+void Device::PublishAnalogTablesLocked(std::unique_ptr<protocol::AnalogTables> tables) {
+    analog_tables_.store(tables.get(), std::memory_order_seq_cst);
+    if (analog_tables_owner_) {
+        analog_tables_retired_.push_back(std::move(analog_tables_owner_));
+    }
+    analog_tables_owner_ = std::move(tables);
+
+    // Loaded after the store above: tables the input path announces later
+    // are the new ones, so anything else retired is safe to free
+    const protocol::AnalogTables* in_use = analog_tables_in_use_.load(std::memory_order_seq_cst);
+    analog_tables_retired_.erase(
+        std::remove_if(analog_tables_retired_.begin(), analog_tables_retired_.end(),
+                       [in_use](const std::unique_ptr<protocol::AnalogTables>& retired) { return retired.get() != in_use; }),
+        analog_tables_retired_.end());
+}
+
+const protocol::AnalogTables* Device::AcquireAnalogTables() {
+    // Already announced and still current: nothing can free it
+    const protocol::AnalogTables* tables = analog_tables_.load(std::memory_order_acquire);
+    if (tables == analog_tables_in_use_.load(std::memory_order_relaxed)) {
+        return tables;
+    }
+
+    // Announce, then check that a setter did not replace it in between
+    for (;;) {
+        analog_tables_in_use_.store(tables, std::memory_order_seq_cst);
+        const protocol::AnalogTables* current = analog_tables_.load(std::memory_order_seq_cst);
+        if (current == tables) {
+            return tables;
+        }
+        tables = current;
+    }
+}
+
+DSResult Device::GetAnalogState(DSAnalogState* out_state) {
+    if (!out_state) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    *out_state = analog_snapshot_.Load();
+    return DS_OK;
+}
+
+DSResult Device::StartInputThread() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    input_thread_wanted_ = true;
+    StartInputThreadLocked();
+    return DS_OK;
+}
+
+DSResult Device::StopInputThread() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    input_thread_wanted_ = false;
+    StopInputThreadLocked();
+    return DS_OK;
+}
+
+void Device::StartInputThreadLocked() {
+    if (input_thread_running_) {
+        return;
+    }
+
+    // Reap a reader that exited on its own after a disconnect
+    StopInputThreadLocked();
+
+    input_thread_running_ = true;
+    input_thread_ = std::thread(&Device::InputThreadMain, this);
+}
+
+void Device::StopInputThreadLocked() {
+    input_thread_running_ = false;
+    if (input_thread_.joinable()) {
+        input_thread_.join();
+    }
+}
+
+void Device::InputThreadMain() {
+    // Private buffer: buffer_input belongs to the polling path under mutex_
+    unsigned char report[sizeof(device_.buffer_input)] = {};
+
+    while (input_thread_running_) {
+        std::chrono::steady_clock::time_point arrival;
+        const int result = ReadReport(report, INPUT_THREAD_READ_TIMEOUT_MS, &arrival);
+
+        if (result == hid::READ_TIMEOUT) {
+            continue;
+        }
+
+        if (result < 0) {
+            // Check if device disconnected
+            if (!device_.transport->Ping()) {
+                MarkDisconnected();
+                printf("Device: Input thread stopped, device disconnected\n");
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        PublishInput(report, static_cast<size_t>(result), arrival);
+    }
+
+    input_thread_running_ = false;
+}
+
+void Device::PublishInput(const unsigned char* report, size_t size, std::chrono::steady_clock::time_point arrival) {
+    // Raw, before validation, so parse problems can be reproduced
+    CaptureReport(hid::CaptureKind::Input, report, size);
+
+    // Interval between arrivals, valid or not, as the transport delivered them
+    if (last_report_time_ != std::chrono::steady_clock::time_point()) {
+        stats_.report_interval.Record(ElapsedMicros(last_report_time_, arrival));
+    }
+    last_report_time_ = arrival;
+
+    // Ignore reduced/unrelated reports (e.g. BT 0x01 before features are enabled)
+    if (size < input_format_->report_size || report[0] != input_format_->report_id) {
+        DeviceStats::Count(stats_.reports_dropped);
+        return;
+    }
+
+    if (input_format_->has_crc && verify_input_crc_) {
+        const size_t crc_offset = input_format_->report_size - 4;
+        const uint32_t crc_checksum = static_cast<uint32_t>(report[crc_offset]) |
+                                      (static_cast<uint32_t>(report[crc_offset + 1]) << 8) |
+                                      (static_cast<uint32_t>(report[crc_offset + 2]) << 16) |
+                                      (static_cast<uint32_t>(report[crc_offset + 3]) << 24);
+        if (protocol::ComputeCRC32(report, crc_offset, protocol::CRC_SEED_INPUT) != crc_checksum) {
+            input_crc_errors_++;
+            DeviceStats::Count(stats_.reports_dropped);
+            return;
+        }
+    }
+
+    DSInputState state;
+    protocol::RawMotion motion;
+    input_format_->decode(report, &state, &motion);
+
+    const int64_t arrival_us = std::chrono::duration_cast<std::chrono::microseconds>(arrival.time_since_epoch()).count();
+    const protocol::SequenceStep step = sequence_tracker_.Track(*input_format_, report, motion.timestamp, arrival_us);
+    stats_.device_interval_us.store(step.device_interval_us, std::memory_order_relaxed);
+    // A repeat carries nothing new and an older report would roll the state back
+    if (step.result == protocol::SequenceResult::Duplicate) {
+        DeviceStats::Count(stats_.reports_duplicated);
+        return;
+    }
+    if (step.result == protocol::SequenceResult::Reordered) {
+        DeviceStats::Count(stats_.reports_reordered);
+        return;
+    }
+    if (step.missing > 0) {
+        DeviceStats::Count(stats_.sequence_gaps);
+        stats_.reports_lost.fetch_add(step.missing, std::memory_order_relaxed);
+    }
+    if (step.has_jitter) {
+        stats_.jitter.Record(step.jitter_us);
+    }
+
+    const uint64_t sequence = ++input_reports_;
+    motion_.Process(motion, *input_format_, &state);
+    input_snapshot_.Store(state);
+    DeviceStats::Count(stats_.reports_received);
+
+    DSAnalogState analog;
+    AcquireAnalogTables()->Apply(state, &analog);
+    analog.sensor_timestamp_us = state.sensor_timestamp_us;
+    analog_snapshot_.Store(analog);
+    published_us_.store(arrival_us, std::memory_order_relaxed);
+
+    // Edges against the previous report, so short presses survive slow polling
+    DSEvent events[protocol::MAX_EVENTS_PER_REPORT];
+    const size_t count = protocol::DiffInputStates(last_event_state_, state, static_cast<uint32_t>(sequence), events);
+    if (count > 0) {
+        const size_t queued = event_queue_.Write(events, count);
+        if (queued < count) {
+            events_dropped_ += count - queued;
+        }
+    }
+    last_event_state_ = state;
+
+    DSGestureEvent gestures[protocol::MAX_GESTURES_PER_REPORT];
+    const size_t gesture_count = gestures_.Process(state, static_cast<uint32_t>(sequence), gestures);
+    if (gesture_count > 0) {
+        const size_t queued = gesture_queue_.Write(gestures, gesture_count);
+        if (queued < gesture_count) {
+            gestures_dropped_ += gesture_count - queued;
+        }
+    }
+
+    if (history_.Write(&state, 1) == 0) {
+        history_dropped_++;
+    }
+    {
+        std::lock_guard<std::mutex> aggregate_lock(aggregate_mutex_);
+        protocol::AccumulateAggregate(aggregate_state_, state, &aggregate_);
+        aggregate_state_ = state;
+    }
+
+    input_signal_->Notify();
+}
+
+DSResult Device::SetInputCrcCheck(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    verify_input_crc_ = enabled;
+    return DS_OK;
+}
+
+DSResult Device::GetInputCounters(DSInputCounters* out_counters) {
+    if (!out_counters) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    out_counters->reports_received = input_reports_;
+    out_counters->crc_errors = input_crc_errors_;
+    out_counters->events_dropped = events_dropped_;
+    out_counters->history_dropped = history_dropped_;
+    out_counters->gestures_dropped = gestures_dropped_;
+    return DS_OK;
+}
+
+DSResult Device::PollEvents(DSEvent* events, uint32_t max_events, uint32_t* out_count) {
+    // Lock-free consumer path: no mutex_, only the ring
+    if (out_count) {
+        *out_count = 0;
+    }
+
+    if (!events && max_events > 0) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    const size_t count = event_queue_.Read(events, max_events);
+    if (out_count) {
+        *out_count = static_cast<uint32_t>(count);
+    }
+    return DS_OK;
+}
+
+DSResult Device::GetInputHistory(DSInputState* states, uint32_t max_states, uint32_t* out_count) {
+    // Lock-free consumer path, like PollEvents
+    if (out_count) {
+        *out_count = 0;
+    }
+
+    if (!states && max_states > 0) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    const size_t count = history_.Read(states, max_states);
+    if (out_count) {
+        *out_count = static_cast<uint32_t>(count);
+    }
+    return DS_OK;
+}
+
+DSResult Device::GetInputAggregate(DSInputAggregate* out_aggregate) {
+    if (!out_aggregate) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    std::lock_guard<std::mutex> aggregate_lock(aggregate_mutex_);
+    *out_aggregate = aggregate_;
+    protocol::StartAggregate(aggregate_state_, &aggregate_);
+    return DS_OK;
+}
+
+DSResult Device::PollGestures(DSGestureEvent* gestures, uint32_t max_gestures, uint32_t* out_count) {
+    // Lock-free consumer path, like PollEvents
+    if (out_count) {
+        *out_count = 0;
+    }
+
+    if (!gestures && max_gestures > 0) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    const size_t count = gesture_queue_.Read(gestures, max_gestures);
+    if (out_count) {
+        *out_count = static_cast<uint32_t>(count);
+    }
+    return DS_OK;
+}
+
+DSResult Device::SetLightbar(uint8_t r, uint8_t g, uint8_t b) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    Lightbar& lightbar = device_.output.lightbar;
+    if (lightbar.r != r || lightbar.g != g || lightbar.b != b) {
+        lightbar.r = r;
+        lightbar.g = g;
+        lightbar.b = b;
+        device_.output.dirty |= OUTPUT_DIRTY_LIGHTBAR;
+    }
+
+    return WriteOutput();
+}
+
+DSResult Device::SetPlayerLed(DSLedPlayer led, DSLedBrightness brightness) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    PlayerLed& player_led = device_.output.player_led;
+    if (player_led.led != led || player_led.brightness != brightness) {
+        player_led.led = static_cast<uint8_t>(led);
+        player_led.brightness = static_cast<uint8_t>(brightness);
+        device_.output.dirty |= OUTPUT_DIRTY_PLAYER_LED;
+    }
+
+    return WriteOutput();
+}
+
+DSResult Device::SetMicLed(DSLedMic mode) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    if (device_.output.mic_light.mode != mode) {
+        device_.output.mic_light.mode = static_cast<uint8_t>(mode);
+        device_.output.dirty |= OUTPUT_DIRTY_MIC_LIGHT;
+    }
+
+    return WriteOutput();
+}
+
+DSResult Device::SetRumble(uint8_t left, uint8_t right) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    Rumbles& rumbles = device_.output.rumbles;
+    if (rumbles.left != left || rumbles.right != right) {
+        rumbles.left = left;
+        rumbles.right = right;
+        device_.output.dirty |= OUTPUT_DIRTY_RUMBLE;
+    }
+
+    return WriteOutput();
+}
+
+DSResult Device::StopRumble() {
+    return SetRumble(0, 0);
+}
+
+void Device::ApplyTriggerEffect(HapticTriggers& trigger, uint32_t dirty_flag, uint8_t mode, const uint8_t params[10]) {
+    if (trigger.mode != mode) {
+        trigger.mode = mode;
+        device_.output.dirty |= dirty_flag;
+    }
+    if (params && memcmp(trigger.strengths.compose, params, 10) != 0) {
+        memcpy(trigger.strengths.compose, params, 10);
+        device_.output.dirty |= dirty_flag;
+    }
+}
+
+DSResult Device::TriggerOff(bool left, bool right) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    if (left) ApplyTriggerEffect(device_.output.left_trigger, OUTPUT_DIRTY_LEFT_TRIGGER, 0x0, nullptr);
+    if (right) ApplyTriggerEffect(device_.output.right_trigger, OUTPUT_DIRTY_RIGHT_TRIGGER, 0x0, nullptr);
+
+    return WriteOutput();
+}
+
+DSResult Device::TriggerContinuousResistance(bool left, bool right, uint8_t start_pos, uint8_t force) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    uint8_t params[10] = { start_pos, force, 0 };
+
+    if (left) ApplyTriggerEffect(device_.output.left_trigger, OUTPUT_DIRTY_LEFT_TRIGGER, 0x01, params);
+    if (right) ApplyTriggerEffect(device_.output.right_trigger, OUTPUT_DIRTY_RIGHT_TRIGGER, 0x01, params);
+
+    return WriteOutput();
+}
+
+DSResult Device::TriggerBow(bool left, bool right, uint8_t start, uint8_t end, uint8_t str_start, uint8_t str_end) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    uint8_t params[10] = { start, end, str_start, str_end, 0 };
+
+    if (left) ApplyTriggerEffect(device_.output.left_trigger, OUTPUT_DIRTY_LEFT_TRIGGER, 0x02, params);
+    if (right) ApplyTriggerEffect(device_.output.right_trigger, OUTPUT_DIRTY_RIGHT_TRIGGER, 0x02, params);
+
+    return WriteOutput();
+}
+
+DSResult Device::TriggerGalloping(bool left, bool right, uint8_t start, uint8_t end, uint8_t first, uint8_t second, uint8_t freq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    uint8_t params[10] = { start, end, first, second, freq, 0 };
+
+    if (left) ApplyTriggerEffect(device_.output.left_trigger, OUTPUT_DIRTY_LEFT_TRIGGER, 0x23, params);
+    if (right) ApplyTriggerEffect(device_.output.right_trigger, OUTPUT_DIRTY_RIGHT_TRIGGER, 0x23, params);
+
+    return WriteOutput();
+}
+
+DSResult Device::TriggerResistance(bool left, bool right, uint8_t str_start, uint8_t str_mid, uint8_t str_end) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    uint8_t params[10] = { 0, 0, str_start, str_mid, str_end, 0 };
+
+    if (left) ApplyTriggerEffect(device_.output.left_trigger, OUTPUT_DIRTY_LEFT_TRIGGER, 0x21, params);
+    if (right) ApplyTriggerEffect(device_.output.right_trigger, OUTPUT_DIRTY_RIGHT_TRIGGER, 0x21, params);
+
+    return WriteOutput();
+}
+
+DSResult Device::TriggerWeapon(bool left, bool right, uint8_t start, uint8_t end, uint8_t strength) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    uint8_t params[10] = { start, end, strength, 0 };
+
+    if (left) ApplyTriggerEffect(device_.output.left_trigger, OUTPUT_DIRTY_LEFT_TRIGGER, 0x25, params);
+    if (right) ApplyTriggerEffect(device_.output.right_trigger, OUTPUT_DIRTY_RIGHT_TRIGGER, 0x25, params);
+
+    return WriteOutput();
+}
+
+DSResult Device::TriggerAutomaticGun(bool left, bool right, uint8_t start, uint8_t strength, uint8_t freq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    uint8_t params[10] = { start, strength, freq, 0 };
+
+    if (left) ApplyTriggerEffect(device_.output.left_trigger, OUTPUT_DIRTY_LEFT_TRIGGER, 0x26, params);
+    if (right) ApplyTriggerEffect(device_.output.right_trigger, OUTPUT_DIRTY_RIGHT_TRIGGER, 0x26, params);
+
+    return WriteOutput();
+}
+
+DSResult Device::TriggerMachine(bool left, bool right, uint8_t start, uint8_t amplitude, uint8_t freq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    uint8_t params[10] = { start, amplitude, freq, 0 };
+
+    if (left) ApplyTriggerEffect(device_.output.left_trigger, OUTPUT_DIRTY_LEFT_TRIGGER, 0x27, params);
+    if (right) ApplyTriggerEffect(device_.output.right_trigger, OUTPUT_DIRTY_RIGHT_TRIGGER, 0x27, params);
+
+    return WriteOutput();
+}
+
+DSResult Device::TriggerCustom(bool left, bool right, const uint8_t params[10]) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    if (!params) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (left) ApplyTriggerEffect(device_.output.left_trigger, OUTPUT_DIRTY_LEFT_TRIGGER, 0xFF, params);
+    if (right) ApplyTriggerEffect(device_.output.right_trigger, OUTPUT_DIRTY_RIGHT_TRIGGER, 0xFF, params);
+
+    return WriteOutput();
+}
+
+DSResult Device::PlayTimeline(const DSKeyframe* keyframes, uint32_t count, bool loop) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    EffectTimeline timeline;
+    if (!timeline.Load(keyframes, count, loop)) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    StopTimelineLocked(lock);
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    timeline_ = std::move(timeline);
+    timeline_start_ = std::chrono::steady_clock::now();
+    timeline_running_ = true;
+    timeline_thread_ = std::thread(&Device::TimelineThreadMain, this);
+
+    return DS_OK;
+}
+
+DSResult Device::StopTimeline() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    StopTimelineLocked(lock);
+    return DS_OK;
+}
+
+DSResult Device::IsTimelinePlaying(bool* out_playing) {
+    if (!out_playing) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    *out_playing = timeline_running_;
+    return DS_OK;
+}
+
+void Device::StopTimelineLocked(std::unique_lock<std::mutex>& lock) {
+    timeline_running_ = false;
+    timeline_cv_.notify_all();
+
+    // The tick thread needs mutex_ to notice the stop, so join without it
+    if (timeline_thread_.joinable()) {
+        std::thread thread = std::move(timeline_thread_);
+        lock.unlock();
+        thread.join();
+        lock.lock();
+    }
+}
+
+void Device::TimelineThreadMain() {
+    using Clock = std::chrono::steady_clock;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    Clock::time_point next_tick = timeline_start_;
+
+    while (timeline_running_ && device_.is_connected) {
+        const Clock::time_point now = Clock::now();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - timeline_start_);
+        const bool playing = timeline_.Evaluate(static_cast<uint64_t>(elapsed.count()), device_.output);
+
+        // Only ticks that changed a field produce a report
+        if (device_.output.dirty != 0) {
+            WriteOutput();
+        }
+        if (!playing) {
+            break;
+        }
+
+        // Tick at the output rate; after a stall, resume from now instead of catching up
+        const uint32_t rate = output_rate_hz_;
+        next_tick += std::chrono::microseconds(1000000 / (rate > 0 ? rate : TIMELINE_DEFAULT_TICK_HZ));
+        if (next_tick < now) {
+            next_tick = now;
+        }
+        timeline_cv_.wait_until(lock, next_tick, [this] { return !timeline_running_; });
+    }
+
+    timeline_running_ = false;
+}
+
+DSResult Device::SendAudioHaptic(const uint8_t* data, uint32_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    if (device_.connection_type != DS_CONNECTION_BLUETOOTH) {
+        printf("Device: Audio haptics only supported on Bluetooth\n");
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!data || size > 142) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    std::lock_guard<std::mutex> write_lock(write_mutex_);
+    memcpy(device_.buffer_audio, data, size);
+    const auto start = std::chrono::steady_clock::now();
+    protocol::SendAudioHapticAdvanced(&device_);
+    stats_.write_latency.Record(ElapsedMicros(start, std::chrono::steady_clock::now()));
+    DeviceStats::Count(stats_.audio_reports);
+    CaptureReport(hid::CaptureKind::Output, device_.buffer_audio, sizeof(device_.buffer_audio));
+
+    return DS_OK;
+}
+
+DSResult Device::StartHapticStream() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    if (device_.connection_type != DS_CONNECTION_BLUETOOTH) {
+        printf("Device: Audio haptics only supported on Bluetooth\n");
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (haptic_thread_running_) {
+        return DS_OK;
+    }
+
+    haptic_packets_sent_ = 0;
+    haptic_underruns_ = 0;
+    haptic_stream_wanted_ = true;
+    StartHapticStreamLocked();
+    return DS_OK;
+}
+
+void Device::StartHapticStreamLocked() {
+    haptic_prebuffer_frames_ = HAPTIC_PREBUFFER_INITIAL_FRAMES;
+
+    haptic_thread_running_ = true;
+    haptic_thread_ = std::thread(&Device::HapticThreadMain, this);
+}
+
+DSResult Device::StopHapticStream() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    haptic_stream_wanted_ = false;
+    StopHapticStreamLocked();
+    return DS_OK;
+}
+
+void Device::StopHapticStreamLocked() {
+    haptic_thread_running_ = false;
+    if (haptic_thread_.joinable()) {
+        haptic_thread_.join();
+    }
+
+    // The sender is gone, so this thread may act as the consumer
+    haptic_ring_.Discard();
+}
+
+DSResult Device::WriteHapticStream(const int8_t* samples, uint32_t frame_count, uint32_t* out_frames_written) {
+    // Lock-free producer path: no mutex_, only the ring
+    if (out_frames_written) {
+        *out_frames_written = 0;
+    }
+
+    if (!samples && frame_count > 0) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    // Reads and writes are whole frames, so free space is always a whole frame
+    const size_t written = haptic_ring_.Write(samples, static_cast<size_t>(frame_count) * 2);
+    haptic_frames_queued_.fetch_add(written / 2, std::memory_order_relaxed);
+
+    if (out_frames_written) {
+        *out_frames_written = static_cast<uint32_t>(written / 2);
+    }
+    return DS_OK;
+}
+
+DSResult Device::ConfigureHapticPcm(uint32_t sample_rate, uint32_t channels, float gain) {
+    // Producer-side state like the ring's write index: call from the producer thread
+    if (!haptic_resampler_.Configure(sample_rate, channels, gain)) {
+        printf("Device: Unsupported haptic PCM format (%u Hz, %u channels)\n", sample_rate, channels);
+        return DS_ERROR_INVALID_PARAM;
+    }
+    return DS_OK;
+}
+
+template <typename Sample>
+DSResult Device::WriteHapticPcmImpl(const Sample* samples, uint32_t frame_count, uint32_t* out_frames_consumed) {
+    // Lock-free producer path, same as WriteHapticStream
+    if (out_frames_consumed) {
+        *out_frames_consumed = 0;
+    }
+
+    if ((!samples && frame_count > 0) || !haptic_resampler_.IsConfigured()) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    // Convert straight into the ring, never producing more than it can take,
+    // so input is only consumed when its output has somewhere to go
+    const size_t channels = haptic_resampler_.GetChannels();
+    int8_t packed[HAPTIC_PCM_BLOCK_FRAMES * 2];
+    size_t consumed = 0;
+    for (;;) {
+        const size_t max_frames = std::min(haptic_ring_.FreeSpace() / 2, HAPTIC_PCM_BLOCK_FRAMES);
+        size_t produced = 0;
+        const size_t used = haptic_resampler_.Process(samples + consumed * channels, frame_count - consumed,
+                                                      packed, max_frames, &produced);
+        haptic_ring_.Write(packed, produced * 2);
+        haptic_frames_queued_.fetch_add(produced, std::memory_order_relaxed);
+        consumed += used;
+
+        if (used == 0 && produced == 0) {
+            break;
+        }
+    }
+
+    if (out_frames_consumed) {
+        *out_frames_consumed = static_cast<uint32_t>(consumed);
+    }
+    return DS_OK;
+}
+
+DSResult Device::WriteHapticPcm(const float* samples, uint32_t frame_count, uint32_t* out_frames_consumed) {
+    return WriteHapticPcmImpl(samples, frame_count, out_frames_consumed);
+}
+
+DSResult Device::WriteHapticPcm(const int16_t* samples, uint32_t frame_count, uint32_t* out_frames_consumed) {
+    return WriteHapticPcmImpl(samples, frame_count, out_frames_consumed);
+}
+
+DSResult Device::GetHapticStreamStats(DSHapticStreamStats* out_stats) {
+    if (!out_stats) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    out_stats->packets_sent = haptic_packets_sent_;
+    out_stats->underruns = haptic_underruns_;
+    out_stats->buffered_frames = static_cast<uint32_t>(haptic_ring_.Size() / 2);
+    out_stats->prebuffer_frames = haptic_prebuffer_frames_;
+    return DS_OK;
+}
+
+void Device::HapticThreadMain() {
+    using Clock = std::chrono::steady_clock;
+
+    int8_t samples[protocol::HAPTIC_SAMPLES_PER_REPORT];
+    unsigned char report[protocol::HAPTIC_REPORT_SIZE];
+    uint8_t sequence = 0;
+    bool playing = false;
+    uint32_t stable_packets = 0;
+    uint64_t frames_queued = haptic_frames_queued_;
+    uint32_t idle_packets = 0;      // Packet periods since the producer last queued frames
+    Clock::time_point next_packet = Clock::now();
+
+    while (haptic_thread_running_) {
+        std::this_thread::sleep_until(next_packet);
+        next_packet += HAPTIC_PACKET_PERIOD;
+
+        // After a long stall, restart the schedule instead of bursting to catch up
+        const Clock::time_point now = Clock::now();
+        if (now > next_packet + 4 * HAPTIC_PACKET_PERIOD) {
+            next_packet = now + HAPTIC_PACKET_PERIOD;
+        }
+
+        const uint64_t queued = haptic_frames_queued_.load(std::memory_order_relaxed);
+        if (queued != frames_queued) {
+            frames_queued = queued;
+            idle_packets = 0;
+        }
+        else if (idle_packets < UINT32_MAX) {
+            idle_packets++;
+        }
+
+        const uint32_t prebuffer = haptic_prebuffer_frames_;
+        const size_t buffered_frames = haptic_ring_.Size() / 2;
+
+        if (!playing) {
+            if (buffered_frames < prebuffer) {
+                continue;
+            }
+            playing = true;
+        }
+
+        if (buffered_frames < HAPTIC_FRAMES_PER_PACKET) {
+            // Ran dry while the producer is still writing (within the time the
+            // pre-buffer covers): rebuffer to a deeper target before playing
+            // again. Otherwise the stream simply ended.
+            if (static_cast<uint64_t>(idle_packets) * HAPTIC_FRAMES_PER_PACKET < prebuffer) {
+                haptic_underruns_++;
+                DeviceStats::Count(stats_.audio_underruns);
+                haptic_prebuffer_frames_ = std::min(prebuffer + HAPTIC_FRAMES_PER_PACKET, HAPTIC_PREBUFFER_MAX_FRAMES);
+                stable_packets = 0;
+            }
+            playing = false;
+
+            // Flush the tail so a finished stream is not left hanging
+            if (buffered_frames == 0) {
+                continue;
+            }
+            memset(samples, 0, sizeof(samples));
+        }
+
+        haptic_ring_.Read(samples, sizeof(samples));
+        protocol::ComposeHapticReport(samples, sequence++, report);
+
+        {
+            std::lock_guard<std::mutex> write_lock(write_mutex_);
+            if (!WriteReport(report, sizeof(report))) {
+                write_failures_++;
+                continue;
+            }
+        }
+        CaptureReport(hid::CaptureKind::Output, report, sizeof(report));
+        haptic_packets_sent_++;
+        DeviceStats::Count(stats_.audio_reports);
+
+        if (playing && ++stable_packets >= HAPTIC_STABLE_PACKETS) {
+            stable_packets = 0;
+            if (prebuffer > HAPTIC_PREBUFFER_MIN_FRAMES) {
+                haptic_prebuffer_frames_ = prebuffer - HAPTIC_FRAMES_PER_PACKET;
+            }
+        }
+    }
+}
+
+DSResult Device::ResetAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    // Reset all outputs
+    device_.output.lightbar = {};
+    device_.output.rumbles = {};
+    device_.output.left_trigger.mode = 0x0;
+    device_.output.right_trigger.mode = 0x0;
+    device_.output.mic_light.mode = 0x0;
+    device_.output.dirty = OUTPUT_DIRTY_ALL;
+
+    return WriteOutput();
+}
+
+DSResult Device::FlushOutput() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    return WriteOutput(true);
+}
+
+DSResult Device::SetOutputKeepalive(uint32_t interval_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    output_keepalive_ms_ = interval_ms;
+    return DS_OK;
+}
+
+DSResult Device::GetOutputCounters(DSOutputCounters* out_counters) {
+    if (!out_counters) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    out_counters->reports_written = reports_written_;
+    out_counters->reports_elided = reports_elided_;
+    out_counters->write_failures = write_failures_;
+    return DS_OK;
+}
+
+DSResult Device::StartOutputThread() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    output_thread_wanted_ = true;
+    StartOutputThreadLocked();
+    return DS_OK;
+}
+
+void Device::StartOutputThreadLocked() {
+    {
+        std::lock_guard<std::mutex> mailbox_lock(mailbox_mutex_);
+        if (output_thread_running_) {
+            return;
+        }
+        output_thread_running_ = true;
+        mailbox_pending_ = false;
+        mailbox_changed_ = false;
+        mailbox_force_ = false;
+    }
+
+    output_thread_ = std::thread(&Device::OutputThreadMain, this);
+}
+
+DSResult Device::StopOutputThread() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    output_thread_wanted_ = false;
+    StopOutputThreadLocked();
+    return DS_OK;
+}
+
+DSResult Device::SetOutputRate(uint32_t reports_per_second) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!device_.is_connected) {
+        return DS_ERROR_NOT_CONNECTED;
+    }
+
+    output_rate_hz_ = reports_per_second;
+    return DS_OK;
+}
+
+void Device::StopOutputThreadLocked() {
+    {
+        std::lock_guard<std::mutex> mailbox_lock(mailbox_mutex_);
+        output_thread_running_ = false;
+    }
+    mailbox_cv_.notify_all();
+
+    if (output_thread_.joinable()) {
+        output_thread_.join();
+    }
+}
+
+void Device::OutputThreadMain() {
+    using Clock = std::chrono::steady_clock;
+
+    OutputContext output;
+    bool has_output = false;
+    Clock::time_point last_send = Clock::now();
+    Clock::time_point next_write = last_send;
+
+    std::unique_lock<std::mutex> lock(mailbox_mutex_);
+
+    // Keep going after a stop request until the last posted state is sent
+    while (output_thread_running_ || mailbox_pending_) {
+        if (!mailbox_pending_) {
+            const auto woken = [this] { return mailbox_pending_ || !output_thread_running_; };
+            const uint32_t keepalive_ms = output_keepalive_ms_;
+
+            if (!has_output || keepalive_ms == 0) {
+                mailbox_cv_.wait(lock, woken);
+            }
+            else if (!mailbox_cv_.wait_until(lock, last_send + std::chrono::milliseconds(keepalive_ms), woken)) {
+                // Idle for a whole keepalive interval: resend the last state
+                lock.unlock();
+                SendOutput(output, false, false);
+                last_send = Clock::now();
+                lock.lock();
+            }
+            continue;
+        }
+
+        // Rate limit; states posted meanwhile overwrite the slot and are coalesced
+        if (output_thread_running_ && Clock::now() < next_write) {
+            lock.unlock();
+            std::this_thread::sleep_until(next_write);
+            lock.lock();
+        }
+
+        output = mailbox_output_;
+        const bool changed = mailbox_changed_;
+        const bool force = mailbox_force_;
+        mailbox_pending_ = false;
+        mailbox_changed_ = false;
+        mailbox_force_ = false;
+        has_output = true;
+        lock.unlock();
+
+        SendOutput(output, changed, force);
+
+        last_send = Clock::now();
+        const uint32_t rate = output_rate_hz_;
+        next_write = (rate > 0) ? last_send + std::chrono::microseconds(1000000 / rate) : last_send;
+
+        lock.lock();
+    }
+}
+
+DSResult Device::WriteOutput(bool force) {
+    const bool changed = device_.output.dirty != 0;
+    device_.output.dirty = 0;
+
+    {
+        std::lock_guard<std::mutex> mailbox_lock(mailbox_mutex_);
+        if (output_thread_running_) {
+            // Unchanged state: the writer thread takes care of keepalives
+            if (!changed && !force) {
+                reports_elided_++;
+                DeviceStats::Count(stats_.reports_elided);
+                return DS_OK;
+            }
+
+            // Latest state wins; an unsent earlier state is dropped
+            if (mailbox_pending_) {
+                reports_elided_++;
+                DeviceStats::Count(stats_.reports_elided);
+            }
+            mailbox_output_ = device_.output;
+            mailbox_changed_ = mailbox_changed_ || changed;
+            mailbox_force_ = mailbox_force_ || force;
+            mailbox_pending_ = true;
+            mailbox_cv_.notify_one();
+            return DS_OK;
+        }
+    }
+
+    return SendOutput(device_.output, changed, force);
+}
+
+DSResult Device::SendOutput(const OutputContext& output, bool changed, bool force) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+
+    const auto now = std::chrono::steady_clock::now();
+    const uint32_t keepalive_ms = output_keepalive_ms_;
+    const bool keepalive_due = keepalive_ms > 0 &&
+        now - last_output_time_ >= std::chrono::milliseconds(keepalive_ms);
+
+    // Nothing changed since the last report: skip composing entirely
+    if (!force && !keepalive_due && !changed && last_output_size_ > 0) {
+        reports_elided_++;
+        DeviceStats::Count(stats_.reports_elided);
+        return DS_OK;
+    }
+
+    // Composer specialized for this model and transport
+    const size_t length = output_format_->compose(output, device_.buffer_output);
+
+    // Fields may have changed and changed back; compare before paying for the CRC
+    const size_t compare_length = output_format_->has_crc ? length - 4 : length;
+    if (!force && !keepalive_due && last_output_size_ == compare_length &&
+        memcmp(last_output_, device_.buffer_output, compare_length) == 0) {
+        reports_elided_++;
+        DeviceStats::Count(stats_.reports_elided);
+        return DS_OK;
+    }
+
+    protocol::FinalizeOutputReport(*output_format_, device_.buffer_output);
+
+    if (!WriteReport(device_.buffer_output, length)) {
+        // Forget the last report so the next call retries
+        last_output_size_ = 0;
+        write_failures_++;
+        return DS_ERROR_IO_FAILED;
+    }
+
+    CaptureReport(hid::CaptureKind::Output, device_.buffer_output, length);
+
+    memcpy(last_output_, device_.buffer_output, compare_length);
+    last_output_size_ = compare_length;
+    last_output_time_ = now;
+    reports_written_++;
+    DeviceStats::Count(stats_.reports_written);
+
+    return DS_OK;
+}
+
+bool Device::WriteReport(const unsigned char* report, size_t size) {
+    const auto start = std::chrono::steady_clock::now();
+    const bool written = device_.transport->Write(report, size);
+    stats_.write_latency.Record(ElapsedMicros(start, std::chrono::steady_clock::now()));
+
+    if (!written) {
+        DeviceStats::Count(stats_.write_failures);
+    }
+    return written;
+}
+
+} // namespace dualsense
@@ -0,0 +1,323 @@
+// Device - one connected controller
+// Each device owns its transport, buffers, lock and input thread, so calls on
+// one controller never wait on I/O of another.
+
+#pragma once
+
+#include "../core/device_context.h"
+#include "../core/effect_timeline.h"
+#include "../core/seqlock.h"
+#include "../core/spsc_ring.h"
+#include "../core/stats.h"
+#include "../hid/capture.h"
+#include "../hid/hid_constants.h"
+#include "../hid/transport.h"
+#include "../protocol/haptic_resampler.h"
+#include "../protocol/input_parser.h"
+#include "../protocol/input_sequence.h"
+#include "../protocol/motion.h"
+#include "../protocol/output_composer.h"
+#include "../protocol/response_curve.h"
+#include "../protocol/touch_gestures.h"
+#include "../../include/dualsense.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dualsense {
+
+class Device {
+public:
+    Device() = default;
+    ~Device() = default;
+    Device(const Device&) = delete;
+    Device& operator=(const Device&) = delete;
+
+    // Connect to an enumerated device, or through a given (unopened) transport
+    // such as a capture replay; such virtual devices are never reconnected
+    DSResult Open(const DeviceInfo& device_info, std::unique_ptr<hid::Transport> transport = nullptr);
+
+    // Reset effects and disconnect
+    void Close();
+
+    // Reopen a lost connection (hotplug watcher), restoring the last output
+    // state and restarting the background threads that were running
+    DSResult Reconnect(const DeviceInfo& device_info);
+
+    // The device node went away (hotplug watcher)
+    void HandleRemoved();
+
+    // Disconnect/reconnect counts and timings
+    DSResult GetReconnectStats(DSReconnectStats* out_stats);
+
+    // Runtime statistics
+    DSResult GetStats(DSStats* out_stats);
+    DSResult ResetStats();
+
+    // Raw report capture
+    DSResult StartCapture(const char* path);
+    DSResult StopCapture();
+
+    // Device path of the current/last connection
+    const std::string& GetPath() const;
+
+    // Bluetooth address of the current/last controller (empty if unknown)
+    const std::string& GetIdentity() const;
+
+    // Check connection status
+    bool IsConnected() const;
+
+    // Opened through a caller-provided transport
+    bool IsVirtual() const;
+
+    // Get device information
+    DSConnectionType GetConnectionType() const;
+    DSDeviceType GetDeviceType() const;
+
+    // Input reading
+    DSResult UpdateInput();
+    DSResult GetInputState(DSInputState* out_state);
+    DSResult GetPackedInputState(DSPackedInputState* out_state);
+
+    // Analog response
+    DSResult SetStickResponse(uint32_t stick, const DSStickResponse* response);
+    DSResult SetTriggerResponse(uint32_t trigger, const DSResponseCurve* curve);
+    DSResult GetAnalogState(DSAnalogState* out_state);
+
+    // Background input reader thread
+    DSResult StartInputThread();
+    DSResult StopInputThread();
+
+    // Input report validation
+    DSResult SetInputCrcCheck(bool enabled);
+    DSResult GetInputCounters(DSInputCounters* out_counters);
+    DSResult WaitForInput(int64_t timeout_us);
+    DSResult GetInputWaitHandle(intptr_t* out_handle);
+    DSResult PollEvents(DSEvent* events, uint32_t max_events, uint32_t* out_count);
+    DSResult GetInputHistory(DSInputState* states, uint32_t max_states, uint32_t* out_count);
+    DSResult GetInputAggregate(DSInputAggregate* out_aggregate);
+    DSResult PollGestures(DSGestureEvent* gestures, uint32_t max_gestures, uint32_t* out_count);
+
+    // LED control
+    DSResult SetLightbar(uint8_t r, uint8_t g, uint8_t b);
+    DSResult SetPlayerLed(DSLedPlayer led, DSLedBrightness brightness);
+    DSResult SetMicLed(DSLedMic mode);
+
+    // Vibration control
+    DSResult SetRumble(uint8_t left, uint8_t right);
+    DSResult StopRumble();
+
+    // Trigger effects
+    DSResult TriggerOff(bool left, bool right);
+    DSResult TriggerContinuousResistance(bool left, bool right, uint8_t start_pos, uint8_t force);
+    DSResult TriggerBow(bool left, bool right, uint8_t start, uint8_t end, uint8_t str_start, uint8_t str_end);
+    DSResult TriggerGalloping(bool left, bool right, uint8_t start, uint8_t end, uint8_t first, uint8_t second, uint8_t freq);
+    DSResult TriggerResistance(bool left, bool right, uint8_t str_start, uint8_t str_mid, uint8_t str_end);
+    DSResult TriggerWeapon(bool left, bool right, uint8_t start, uint8_t end, uint8_t strength);
+    DSResult TriggerAutomaticGun(bool left, bool right, uint8_t start, uint8_t strength, uint8_t freq);
+    DSResult TriggerMachine(bool left, bool right, uint8_t start, uint8_t amplitude, uint8_t freq);
+    DSResult TriggerCustom(bool left, bool right, const uint8_t params[10]);
+
+    // Keyframed effect timeline (evaluated on its own thread)
+    DSResult PlayTimeline(const DSKeyframe* keyframes, uint32_t count, bool loop);
+    DSResult StopTimeline();
+    DSResult IsTimelinePlaying(bool* out_playing);
+
+    // Audio haptics
+    DSResult SendAudioHaptic(const uint8_t* data, uint32_t size);
+
+    // Streaming audio haptics (paced sender thread)
+    DSResult StartHapticStream();
+    DSResult StopHapticStream();
+    DSResult WriteHapticStream(const int8_t* samples, uint32_t frame_count, uint32_t* out_frames_written);
+    DSResult GetHapticStreamStats(DSHapticStreamStats* out_stats);
+
+    // PCM input for the haptic stream (resampled on the producer thread)
+    DSResult ConfigureHapticPcm(uint32_t sample_rate, uint32_t channels, float gain);
+    DSResult WriteHapticPcm(const float* samples, uint32_t frame_count, uint32_t* out_frames_consumed);
+    DSResult WriteHapticPcm(const int16_t* samples, uint32_t frame_count, uint32_t* out_frames_consumed);
+
+    // Utility
+    DSResult ResetAll();
+    DSResult FlushOutput();
+
+    // Output report elision
+    DSResult SetOutputKeepalive(uint32_t interval_ms);
+    DSResult GetOutputCounters(DSOutputCounters* out_counters);
+
+    // Background output writer thread
+    DSResult StartOutputThread();
+    DSResult StopOutputThread();
+    DSResult SetOutputRate(uint32_t reports_per_second);
+
+private:
+    // Internal helpers
+    DSResult OpenLocked(const DeviceInfo& device_info, std::unique_lock<std::mutex>& lock,
+                        std::unique_ptr<hid::Transport> transport, bool reconnect);
+    void StopCaptureLocked();
+    void PublishAnalogTablesLocked(std::unique_ptr<protocol::AnalogTables> tables);   // analog_mutex_ held
+    const protocol::AnalogTables* AcquireAnalogTables();                               // Input path
+    void CaptureReport(hid::CaptureKind kind, const unsigned char* report, size_t size);
+    bool MarkDisconnected();
+    void StartInputThreadLocked();
+    void StartOutputThreadLocked();
+    void StartHapticStreamLocked();
+    void ApplyTriggerEffect(HapticTriggers& trigger, uint32_t dirty_flag, uint8_t mode, const uint8_t params[10]);
+    DSResult WriteOutput(bool force = false);
+    DSResult SendOutput(const OutputContext& output, bool changed, bool force);
+    DSResult ReadInputLocked(int timeout_ms);
+    int ReadReport(unsigned char* report, int timeout_ms, std::chrono::steady_clock::time_point* out_arrival);   // Timed transport read
+    void PublishInput(const unsigned char* report, size_t size, std::chrono::steady_clock::time_point arrival);
+    bool WriteReport(const unsigned char* report, size_t size);     // Timed transport write (write_mutex_ held)
+    void StopInputThreadLocked();
+    void InputThreadMain();
+    void StopOutputThreadLocked();
+    void OutputThreadMain();
+    void StopHapticStreamLocked();
+    void StopTimelineLocked(std::unique_lock<std::mutex>& lock);
+    void TimelineThreadMain();
+    void HapticThreadMain();
+    template <typename Sample>
+    DSResult WriteHapticPcmImpl(const Sample* samples, uint32_t frame_count, uint32_t* out_frames_consumed);
+
+    // Device state
+    DeviceContext device_;
+    std::mutex mutex_;
+
+    // Input/output report formats of the connected model/transport
+    const protocol::InputFormat* input_format_ = nullptr;
+    const protocol::OutputFormat* output_format_ = nullptr;
+
+    // IMU calibration and orientation filter (input path only)
+    protocol::MotionProcessor motion_;
+
+    // Report counter and sensor clock of the last report (input path only)
+    protocol::SequenceTracker sequence_tracker_;
+
+    // Latest parsed input, readable without mutex_
+    SeqLock<DSInputState> input_snapshot_;
+
+    // Input validation and counters, readable without mutex_
+    std::atomic<bool> verify_input_crc_{false};
+    std::atomic<uint64_t> input_reports_{0};
+    std::atomic<uint64_t> input_crc_errors_{0};
+
+    // Edge events: input path (single producer) -> ring -> ds_poll_events (single consumer)
+    SpscRing<DSEvent, DS_EVENT_QUEUE_SIZE> event_queue_;
+    DSInputState last_event_state_ = {};    // Input path only
+    std::atomic<uint64_t> events_dropped_{0};
+
+    // Input history: input path (single producer) -> ring -> ds_get_input_history (single consumer)
+    SpscRing<DSInputState, DS_INPUT_HISTORY_SIZE> history_;
+    std::atomic<uint64_t> history_dropped_{0};
+
+    // Touchpad gestures: recognizer on the input path -> ring -> ds_poll_gestures (single consumer)
+    protocol::GestureRecognizer gestures_;  // Input path only
+    SpscRing<DSGestureEvent, DS_GESTURE_QUEUE_SIZE> gesture_queue_;
+    std::atomic<uint64_t> gestures_dropped_{0};
+
+    // Compiled analog response and the processed state it publishes,
+    // readable without mutex_. Setters (serialized by analog_mutex_) publish
+    // new tables; the input path reads them without a lock and announces the
+    // ones it uses, and replaced tables are freed once no longer announced.
+    std::mutex analog_mutex_;
+    std::unique_ptr<protocol::AnalogTables> analog_tables_owner_;                   // analog_mutex_
+    std::vector<std::unique_ptr<protocol::AnalogTables>> analog_tables_retired_;    // analog_mutex_
+    std::atomic<const protocol::AnalogTables*> analog_tables_{nullptr};
+    std::atomic<const protocol::AnalogTables*> analog_tables_in_use_{nullptr};
+    SeqLock<DSAnalogState> analog_snapshot_;
+
+    // Aggregate since the last ds_get_input_aggregate and the state it last folded in
+    std::mutex aggregate_mutex_;
+    DSInputAggregate aggregate_ = {};
+    DSInputState aggregate_state_ = {};
+
+    // Serializes composing and writing output reports (buffer_output, last_output_*)
+    // Never held while waiting for mutex_, so setters do not wait on a slow write.
+    std::mutex write_mutex_;
+
+    // Last report written (without BT CRC), used to elide identical reports
+    unsigned char last_output_[sizeof(DeviceContext::buffer_output)] = {};
+    size_t last_output_size_ = 0;
+    std::chrono::steady_clock::time_point last_output_time_;
+    std::atomic<uint32_t> output_keepalive_ms_{DS_DEFAULT_OUTPUT_KEEPALIVE_MS};
+
+    // Output counters, readable without mutex_
+    std::atomic<uint64_t> reports_written_{0};
+    std::atomic<uint64_t> reports_elided_{0};
+    std::atomic<uint64_t> write_failures_{0};
+
+    // Ready after each published report; created on first Open and kept for
+    // the slot's lifetime so the exported handle never changes
+    std::unique_ptr<hid::Signal> input_signal_;
+
+    // Background reader (publishes to input_snapshot_ without mutex_)
+    std::thread input_thread_;
+    std::atomic<bool> input_thread_running_{false};
+
+    // Background writer and its single-slot mailbox (latest state wins)
+    std::thread output_thread_;
+    bool output_thread_running_ = false;    // Guarded by mailbox_mutex_
+    std::mutex mailbox_mutex_;
+    std::condition_variable mailbox_cv_;
+    OutputContext mailbox_output_;
+    bool mailbox_pending_ = false;
+    bool mailbox_changed_ = false;
+    bool mailbox_force_ = false;
+    std::atomic<uint32_t> output_rate_hz_{0};
+
+    // Haptic stream: application (single producer) -> ring -> paced sender thread
+    static constexpr size_t HAPTIC_RING_SAMPLES = 8192;     // ~1.4 s of stereo samples
+    SpscRing<int8_t, HAPTIC_RING_SAMPLES> haptic_ring_;
+    std::thread haptic_thread_;
+    std::atomic<bool> haptic_thread_running_{false};
+    std::atomic<uint64_t> haptic_packets_sent_{0};
+    std::atomic<uint64_t> haptic_underruns_{0};
+    std::atomic<uint32_t> haptic_prebuffer_frames_{0};
+    std::atomic<uint64_t> haptic_frames_queued_{0};     // Producer total, tells a late producer from a finished stream
+
+    // Effect timeline; the tick thread applies it under mutex_ like a setter
+    EffectTimeline timeline_;
+    std::thread timeline_thread_;
+    bool timeline_running_ = false;         // Guarded by mutex_
+    std::condition_variable timeline_cv_;   // Waits on mutex_
+    std::chrono::steady_clock::time_point timeline_start_;
+
+    // Threads the application started, restarted by Reconnect (guarded by mutex_)
+    bool input_thread_wanted_ = false;
+    bool output_thread_wanted_ = false;
+    bool haptic_stream_wanted_ = false;
+
+    // Transport was supplied by the caller (replay/emulator)
+    bool is_virtual_ = false;
+
+    // See GetIdentity; kept after a disconnect to match the controller again
+    std::string identity_;
+
+    // Raw report capture; capturing_ keeps the report paths cheap while off
+    std::atomic<bool> capturing_{false};
+    std::shared_ptr<hid::CaptureWriter> capture_;  // std::atomic_load/atomic_store
+
+    // Runtime statistics (any thread), plus the input path's arrival
+    // bookkeeping: last report time (input path only) and when the current
+    // snapshot was published (steady_clock us, 0 = none yet)
+    DeviceStats stats_;
+    std::chrono::steady_clock::time_point last_report_time_;
+    std::atomic<int64_t> published_us_{0};
+
+    // Reconnect statistics, readable without mutex_
+    std::atomic<int64_t> disconnect_time_us_{0};    // steady_clock
+    std::atomic<uint32_t> disconnects_{0};
+    std::atomic<uint32_t> reconnects_{0};
+    std::atomic<uint64_t> last_downtime_us_{0};
+    std::atomic<uint64_t> last_reopen_us_{0};
+
+    // PCM -> haptic conversion, owned by the producer thread like the ring's write side
+    protocol::HapticResampler haptic_resampler_;
+};
+
+} // namespace dualsense
@@ -1,29 +1,20 @@
 // Device Manager Implementation
 
 #include "device_manager.h"
-#include "../hid/windows_hid.h"
-#include "../protocol/output_composer.h"
-#include <cstring>
+#include "../protocol/device_identity.h"
+#include "../protocol/input_packing.h"
+#include <chrono>
 #include <cstdio>
+#include <string>
 
 namespace {
 
-// Parse a single touch point from HID input buffer
-// Reference: orig/WindowsDualsense_ds5w/Private/Core/DualSense/DualSenseLibrary.cpp:260-305
-DSTouchPoint ParseTouchPoint(const unsigned char* hid_input, size_t offset) {
-    DSTouchPoint touch = {};
+// Watcher wake-up interval, bounds how long stopping it takes
+constexpr int HOTPLUG_WAIT_MS = 200;
 
-    // Read 4 bytes as 32-bit integer (little-endian)
-    const int32_t raw = *reinterpret_cast<const int32_t*>(&hid_input[offset]);
-
-    // Extract fields using bit manipulation
-    touch.id = (raw & TOUCH_ID_MASK) % 10;
-    touch.is_active = (raw & TOUCH_DOWN_BIT) == 0;  // 0=down, 1=up
-    touch.x = (raw & TOUCH_X_MASK) >> TOUCH_X_SHIFT;
-    touch.y = (raw & TOUCH_Y_MASK) >> TOUCH_Y_SHIFT;
-
-    return touch;
-}
+// A node can appear before udev has applied its permissions; retry the open
+constexpr int RECONNECT_ATTEMPTS = 20;
+constexpr int RECONNECT_RETRY_MS = 50;
 
 } // anonymous namespace
 
@@ -34,387 +25,411 @@ DeviceManager& DeviceManager::Instance() {
     return instance;
 }
 
-DSResult DeviceManager::Initialize() {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (device_.is_connected) {
-        return DS_ERROR_ALREADY_CONNECTED;
-    }
+DeviceManager::~DeviceManager() {
+    SetAutoReconnect(false);
+}
 
-    // Detect devices
+uint32_t DeviceManager::GetDeviceCount() {
     std::vector<DeviceInfo> devices;
-    if (!hid::DetectDevices(devices) || devices.empty()) {
-        return DS_ERROR_NOT_FOUND;
-    }
-
-    // Connect to first DualSense device found
-    for (const auto& device_info : devices) {
-        if (device_info.device_type == DS_DEVICE_DUALSENSE ||
-            device_info.device_type == DS_DEVICE_DUALSENSE_EDGE) {
-
-            device_.path = device_info.path;
-            device_.device_type = device_info.device_type;
-            device_.connection_type = device_info.connection_type;
-
-            device_.handle = hid::OpenDevice(device_.path);
-            if (device_.handle == INVALID_HANDLE_VALUE) {
-                printf("DeviceManager: Failed to open device\n");
-                return DS_ERROR_IO_FAILED;
-            }
-
-            device_.is_connected = true;
-
-            printf("DeviceManager: Connected to %s via %s\n",
-                   (device_.device_type == DS_DEVICE_DUALSENSE_EDGE) ? "DualSense Edge" : "DualSense",
-                   (device_.connection_type == DS_CONNECTION_BLUETOOTH) ? "Bluetooth" : "USB");
+    hid::DetectDevices(devices);
 
-            return DS_OK;
-        }
-    }
+    std::lock_guard<std::mutex> lock(table_mutex_);
 
-    return DS_ERROR_NOT_FOUND;
+    enumerated_.swap(devices);
+    return static_cast<uint32_t>(enumerated_.size());
 }
 
-void DeviceManager::Shutdown() {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (device_.is_connected) {
-        // Reset all effects before disconnecting
-        device_.output.lightbar = {};
-        device_.output.rumbles = {};
-        device_.output.left_trigger.mode = 0x0;
-        device_.output.right_trigger.mode = 0x0;
-        WriteOutput();
-
-        hid::CloseDevice(device_.handle);
-        device_.handle = INVALID_HANDLE_VALUE;
-        device_.is_connected = false;
-
-        printf("DeviceManager: Disconnected\n");
+DSResult DeviceManager::Open(uint32_t index, DSHandle* out_handle) {
+    if (!out_handle) {
+        return DS_ERROR_INVALID_PARAM;
     }
-}
 
-bool DeviceManager::IsConnected() const {
-    return device_.is_connected;
-}
-
-DSConnectionType DeviceManager::GetConnectionType() const {
-    return static_cast<DSConnectionType>(device_.connection_type);
-}
-
-DSDeviceType DeviceManager::GetDeviceType() const {
-    return static_cast<DSDeviceType>(device_.device_type);
-}
+    std::unique_lock<std::mutex> lock(table_mutex_);
 
-DSResult DeviceManager::UpdateInput() {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+    // Enumerate on demand if the application has not done so yet
+    if (enumerated_.empty()) {
+        lock.unlock();
+        std::vector<DeviceInfo> devices;
+        hid::DetectDevices(devices);
+        lock.lock();
+        if (enumerated_.empty()) {
+            enumerated_.swap(devices);
+        }
     }
 
-    const size_t input_size = (device_.connection_type == DS_CONNECTION_BLUETOOTH) ? 78 : 64;
-    unsigned long bytes_read = 0;
-
-    if (!hid::ReadInputReport(device_.handle, device_.buffer_input, input_size, &bytes_read)) {
-        // Check if device disconnected
-        if (!hid::PingDevice(device_.handle)) {
-            device_.is_connected = false;
-            return DS_ERROR_DISCONNECTED;
-        }
-        return DS_ERROR_IO_FAILED;
+    if (index >= enumerated_.size()) {
+        return DS_ERROR_NOT_FOUND;
     }
 
-    // Input parsing will be implemented here
-    // For now, return success
-    return DS_OK;
+    // A copy: enumerated_ may change while the device opens
+    const DeviceInfo device_info = enumerated_[index];
+    return OpenLocked(device_info, lock, out_handle);
 }
 
-DSResult DeviceManager::GetInputState(DSInputState* out_state) {
-    if (!out_state) {
+DSResult DeviceManager::OpenReplay(const char* path, hid::ReplayMode mode, bool loop, DSHandle* out_handle) {
+    if (!path || !out_handle) {
         return DS_ERROR_INVALID_PARAM;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+    DeviceInfo device_info = {};
+    device_info.path = path;
+    if (!hid::ReadCaptureInfo(device_info.path, &device_info.device_type, &device_info.connection_type)) {
+        printf("DeviceManager: %s is not a capture file\n", path);
+        return DS_ERROR_NOT_FOUND;
     }
 
-    // Zero out the structure
-    memset(out_state, 0, sizeof(DSInputState));
+    std::unique_lock<std::mutex> lock(table_mutex_);
 
-    // Calculate padding offset (Bluetooth has 2-byte header, USB has 1-byte)
-    const size_t padding = (device_.connection_type == DS_CONNECTION_BLUETOOTH) ? 2 : 1;
-    const unsigned char* hid_input = &device_.buffer_input[padding];
-
-    // Parse touchpad data
-    out_state->touch1 = ParseTouchPoint(hid_input, TOUCHPAD1_OFFSET);
-    out_state->touch2 = ParseTouchPoint(hid_input, TOUCHPAD2_OFFSET);
-
-    // Parse touchpad button (offset 0x09, bit 0x02)
-    out_state->button_touchpad = (hid_input[0x09] & BTN_PAD_BUTTON) != 0;
-
-    return DS_OK;
+    return OpenLocked(device_info, lock, out_handle,
+                      std::unique_ptr<hid::Transport>(new hid::ReplayTransport(mode, loop)));
 }
 
-DSResult DeviceManager::SetLightbar(uint8_t r, uint8_t g, uint8_t b) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+DSResult DeviceManager::OpenEmulator(const DSEmulatorConfig& config, DSHandle* out_handle) {
+    if (!out_handle || !hid::ControllerEmulator::IsValidConfig(config)) {
+        return DS_ERROR_INVALID_PARAM;
     }
 
-    device_.output.lightbar.r = r;
-    device_.output.lightbar.g = g;
-    device_.output.lightbar.b = b;
+    std::unique_lock<std::mutex> lock(table_mutex_);
 
-    return WriteOutput();
-}
+    DeviceInfo device_info = {};
+    device_info.path = "emulator:" + std::to_string(emulators_opened_++);
+    device_info.device_type = config.device_type;
+    device_info.connection_type = config.connection_type;
 
-DSResult DeviceManager::SetPlayerLed(DSLedPlayer led, DSLedBrightness brightness) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+    std::shared_ptr<hid::ControllerEmulator> emulator = std::make_shared<hid::ControllerEmulator>(config);
+    const DSResult result = OpenLocked(device_info, lock, out_handle,
+                                       std::unique_ptr<hid::Transport>(new hid::EmulatedTransport(emulator)));
+    if (result == DS_OK) {
+        emulators_[*out_handle] = emulator;
     }
+    return result;
+}
 
-    device_.output.player_led.led = static_cast<uint8_t>(led);
-    device_.output.player_led.brightness = static_cast<uint8_t>(brightness);
+std::shared_ptr<hid::ControllerEmulator> DeviceManager::GetEmulator(DSHandle handle) {
+    std::lock_guard<std::mutex> lock(table_mutex_);
 
-    return WriteOutput();
+    return GetDevice(handle) ? emulators_[handle] : nullptr;
 }
 
-DSResult DeviceManager::SetMicLed(DSLedMic mode) {
-    std::lock_guard<std::mutex> lock(mutex_);
+DSResult DeviceManager::Close(DSHandle handle) {
+    std::unique_lock<std::mutex> lock(table_mutex_);
 
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+    if (!GetDevice(handle)) {
+        return DS_ERROR_INVALID_HANDLE;
     }
 
-    device_.output.mic_light.mode = static_cast<uint8_t>(mode);
-
-    return WriteOutput();
+    CloseLocked(handle, lock);
+    return DS_OK;
 }
 
-DSResult DeviceManager::SetRumble(uint8_t left, uint8_t right) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+Device* DeviceManager::GetDevice(DSHandle handle) {
+    if (handle < 0 || handle >= DS_MAX_DEVICES || !in_use_[handle]) {
+        return nullptr;
     }
+    return &devices_[handle];
+}
 
-    device_.output.rumbles.left = left;
-    device_.output.rumbles.right = right;
+DSResult DeviceManager::Initialize() {
+    // Detect devices
+    std::vector<DeviceInfo> devices;
+    hid::DetectDevices(devices);
 
-    return WriteOutput();
-}
+    std::unique_lock<std::mutex> lock(table_mutex_);
 
-DSResult DeviceManager::StopRumble() {
-    return SetRumble(0, 0);
-}
+    const DSHandle current = default_handle_;
+    if (Device* device = GetDevice(current)) {
+        if (device->IsConnected()) {
+            return DS_ERROR_ALREADY_CONNECTED;
+        }
+        // Previous default device disconnected; free its slot
+        CloseLocked(current, lock);
+    }
 
-void DeviceManager::ApplyTriggerEffect(HapticTriggers& trigger, uint8_t mode, const uint8_t params[10]) {
-    trigger.mode = mode;
-    if (params) {
-        memcpy(trigger.strengths.compose, params, 10);
+    enumerated_ = devices;
+    if (devices.empty()) {
+        return DS_ERROR_NOT_FOUND;
     }
-}
 
-DSResult DeviceManager::TriggerOff(bool left, bool right) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    // Connect to first device not already opened through a handle
+    DSResult result = DS_ERROR_NOT_FOUND;
+    for (const auto& device_info : devices) {
+        if (IsPathOpenLocked(device_info.path)) {
+            continue;
+        }
 
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+        DSHandle handle = DS_INVALID_HANDLE;
+        result = OpenLocked(device_info, lock, &handle);
+        if (result == DS_OK) {
+            // Another ds_init connected while this one was opening
+            if (GetDevice(default_handle_)) {
+                CloseLocked(handle, lock);
+                return DS_ERROR_ALREADY_CONNECTED;
+            }
+            default_handle_ = handle;
+            return DS_OK;
+        }
     }
 
-    if (left) device_.output.left_trigger.mode = 0x0;
-    if (right) device_.output.right_trigger.mode = 0x0;
-
-    return WriteOutput();
+    return result;
 }
 
-DSResult DeviceManager::TriggerContinuousResistance(bool left, bool right, uint8_t start_pos, uint8_t force) {
-    std::lock_guard<std::mutex> lock(mutex_);
+void DeviceManager::Shutdown() {
+    std::unique_lock<std::mutex> lock(table_mutex_);
 
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+    const DSHandle current = default_handle_;
+    if (GetDevice(current)) {
+        CloseLocked(current, lock);
     }
-
-    uint8_t params[10] = { start_pos, force, 0 };
-
-    if (left) ApplyTriggerEffect(device_.output.left_trigger, 0x01, params);
-    if (right) ApplyTriggerEffect(device_.output.right_trigger, 0x01, params);
-
-    return WriteOutput();
 }
 
-DSResult DeviceManager::TriggerBow(bool left, bool right, uint8_t start, uint8_t end, uint8_t str_start, uint8_t str_end) {
-    std::lock_guard<std::mutex> lock(mutex_);
+Device* DeviceManager::GetDefaultDevice() {
+    return GetDevice(default_handle_);
+}
 
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+DSResult DeviceManager::GetAllStates(DSInputStateSoA* out_states) {
+    if (!out_states) {
+        return DS_ERROR_INVALID_PARAM;
     }
 
-    uint8_t params[10] = { start, end, str_start, str_end, 0 };
-
-    if (left) ApplyTriggerEffect(device_.output.left_trigger, 0x02, params);
-    if (right) ApplyTriggerEffect(device_.output.right_trigger, 0x02, params);
-
-    return WriteOutput();
+    *out_states = DSInputStateSoA{};
+    for (DSHandle handle = 0; handle < DS_MAX_DEVICES; handle++) {
+        Device* device = GetDevice(handle);
+        DSPackedInputState state;
+        if (device && device->GetPackedInputState(&state) == DS_OK) {
+            protocol::StorePackedColumn(state, static_cast<size_t>(handle), out_states);
+            out_states->connected_mask |= 1u << handle;
+        }
+    }
+    return DS_OK;
 }
 
-DSResult DeviceManager::TriggerGalloping(bool left, bool right, uint8_t start, uint8_t end, uint8_t first, uint8_t second, uint8_t freq) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+DSResult DeviceManager::OpenLocked(const DeviceInfo& device_info, std::unique_lock<std::mutex>& lock,
+                                   DSHandle* out_handle, std::unique_ptr<hid::Transport> transport) {
+    // Virtual devices may share a source (e.g. one capture replayed many times)
+    if (!transport && IsPathOpenLocked(device_info.path)) {
+        return DS_ERROR_ALREADY_CONNECTED;
     }
 
-    uint8_t params[10] = { start, end, first, second, freq, 0 };
-
-    if (left) ApplyTriggerEffect(device_.output.left_trigger, 0x23, params);
-    if (right) ApplyTriggerEffect(device_.output.right_trigger, 0x23, params);
+    for (DSHandle handle = 0; handle < DS_MAX_DEVICES; handle++) {
+        if (in_use_[handle] || busy_[handle]) {
+            continue;
+        }
 
-    return WriteOutput();
-}
+        // Transport open and feature reads without the table lock; the slot
+        // gets a handle only once the device is ready
+        BeginSlotIoLocked(handle, device_info.path);
+        lock.unlock();
+        const DSResult result = devices_[handle].Open(device_info, std::move(transport));
+        if (result != DS_OK) {
+            devices_[handle].Close();
+        }
+        lock.lock();
+        EndSlotIoLocked(handle);
 
-DSResult DeviceManager::TriggerResistance(bool left, bool right, uint8_t str_start, uint8_t str_mid, uint8_t str_end) {
-    std::lock_guard<std::mutex> lock(mutex_);
+        if (result != DS_OK) {
+            return result;
+        }
 
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+        in_use_[handle] = true;
+        *out_handle = handle;
+        return DS_OK;
     }
 
-    uint8_t params[10] = { 0, 0, str_start, str_mid, str_end, 0 };
-
-    if (left) ApplyTriggerEffect(device_.output.left_trigger, 0x21, params);
-    if (right) ApplyTriggerEffect(device_.output.right_trigger, 0x21, params);
-
-    return WriteOutput();
+    printf("DeviceManager: All %d device slots are in use\n", DS_MAX_DEVICES);
+    return DS_ERROR_TOO_MANY_DEVICES;
 }
 
-DSResult DeviceManager::TriggerWeapon(bool left, bool right, uint8_t start, uint8_t end, uint8_t strength) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+void DeviceManager::CloseLocked(DSHandle handle, std::unique_lock<std::mutex>& lock) {
+    // Let a reconnect in progress finish first
+    busy_cv_.wait(lock, [&] { return !busy_[handle]; });
+    if (!in_use_[handle]) {
+        return;
     }
 
-    uint8_t params[10] = { start, end, strength, 0 };
-
-    if (left) ApplyTriggerEffect(device_.output.left_trigger, 0x25, params);
-    if (right) ApplyTriggerEffect(device_.output.right_trigger, 0x25, params);
+    in_use_[handle] = false;
+    devices_[handle].Close();
+    emulators_[handle].reset();
 
-    return WriteOutput();
+    if (default_handle_ == handle) {
+        default_handle_ = DS_INVALID_HANDLE;
+    }
 }
 
-DSResult DeviceManager::TriggerAutomaticGun(bool left, bool right, uint8_t start, uint8_t strength, uint8_t freq) {
-    std::lock_guard<std::mutex> lock(mutex_);
+DSHandle DeviceManager::FindReconnectSlotLocked(const DeviceInfo& device_info, const std::string& identity) {
+    // Another handle already owns this node, or is opening it
+    for (DSHandle handle = 0; handle < DS_MAX_DEVICES; handle++) {
+        if (busy_[handle] ? busy_path_[handle] == device_info.path
+                          : in_use_[handle] && devices_[handle].IsConnected() &&
+                            devices_[handle].GetPath() == device_info.path) {
+            return DS_INVALID_HANDLE;
+        }
+    }
 
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+    // The lost controller with the same address
+    if (!identity.empty()) {
+        for (DSHandle handle = 0; handle < DS_MAX_DEVICES; handle++) {
+            if (in_use_[handle] && !devices_[handle].IsConnected() && !devices_[handle].IsVirtual() &&
+                devices_[handle].GetIdentity() == identity) {
+                return handle;
+            }
+        }
     }
 
-    uint8_t params[10] = { start, strength, freq, 0 };
+    // Only where either address is unknown: same node first (USB replug),
+    // then a lost controller of the same model
+    const auto unidentified = [&](DSHandle handle) {
+        return in_use_[handle] && !devices_[handle].IsConnected() && !devices_[handle].IsVirtual() &&
+               (identity.empty() || devices_[handle].GetIdentity().empty());
+    };
+    for (DSHandle handle = 0; handle < DS_MAX_DEVICES; handle++) {
+        if (unidentified(handle) && devices_[handle].GetPath() == device_info.path) {
+            return handle;
+        }
+    }
+    for (DSHandle handle = 0; handle < DS_MAX_DEVICES; handle++) {
+        if (unidentified(handle) && devices_[handle].GetDeviceType() == device_info.device_type) {
+            return handle;
+        }
+    }
+    return DS_INVALID_HANDLE;
+}
 
-    if (left) ApplyTriggerEffect(device_.output.left_trigger, 0x26, params);
-    if (right) ApplyTriggerEffect(device_.output.right_trigger, 0x26, params);
+void DeviceManager::BeginSlotIoLocked(DSHandle handle, const std::string& path) {
+    busy_[handle] = true;
+    busy_path_[handle] = path;
+}
 
-    return WriteOutput();
+void DeviceManager::EndSlotIoLocked(DSHandle handle) {
+    busy_[handle] = false;
+    busy_path_[handle].clear();
+    busy_cv_.notify_all();
 }
 
-DSResult DeviceManager::TriggerMachine(bool left, bool right, uint8_t start, uint8_t amplitude, uint8_t freq) {
-    std::lock_guard<std::mutex> lock(mutex_);
+DSResult DeviceManager::SetAutoReconnect(bool enabled, std::unique_ptr<hid::HotplugSource> source) {
+    std::lock_guard<std::mutex> lock(hotplug_mutex_);
 
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+    if (!enabled) {
+        hotplug_running_ = false;
+        if (hotplug_thread_.joinable()) {
+            hotplug_thread_.join();
+        }
+        hotplug_source_.reset();
+        return DS_OK;
     }
 
-    uint8_t params[10] = { start, amplitude, freq, 0 };
+    if (hotplug_running_) {
+        return DS_OK;
+    }
 
-    if (left) ApplyTriggerEffect(device_.output.left_trigger, 0x27, params);
-    if (right) ApplyTriggerEffect(device_.output.right_trigger, 0x27, params);
+    hotplug_source_ = source ? std::move(source) : hid::CreateHotplugSource();
+    if (!hotplug_source_) {
+        return DS_ERROR_IO_FAILED;
+    }
 
-    return WriteOutput();
+    hotplug_running_ = true;
+    hotplug_thread_ = std::thread(&DeviceManager::HotplugThreadMain, this);
+    return DS_OK;
 }
 
-DSResult DeviceManager::TriggerCustom(bool left, bool right, const uint8_t params[10]) {
-    std::lock_guard<std::mutex> lock(mutex_);
+void DeviceManager::HotplugThreadMain() {
+    hid::HotplugEvent event;
 
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
-    }
+    while (hotplug_running_) {
+        if (!hotplug_source_->WaitEvent(&event, HOTPLUG_WAIT_MS)) {
+            continue;
+        }
 
-    if (!params) {
-        return DS_ERROR_INVALID_PARAM;
+        if (event.added) {
+            HandleDeviceAdded(event.path);
+        }
+        else {
+            HandleDeviceRemoved(event.path);
+        }
     }
-
-    if (left) ApplyTriggerEffect(device_.output.left_trigger, 0xFF, params);
-    if (right) ApplyTriggerEffect(device_.output.right_trigger, 0xFF, params);
-
-    return WriteOutput();
 }
 
-DSResult DeviceManager::SendAudioHaptic(const uint8_t* data, uint32_t size) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
-    }
+void DeviceManager::HandleDeviceRemoved(const std::string& path) {
+    std::lock_guard<std::mutex> lock(table_mutex_);
 
-    if (device_.connection_type != DS_CONNECTION_BLUETOOTH) {
-        printf("DeviceManager: Audio haptics only supported on Bluetooth\n");
-        return DS_ERROR_INVALID_PARAM;
+    for (DSHandle handle = 0; handle < DS_MAX_DEVICES; handle++) {
+        if (in_use_[handle] && devices_[handle].GetPath() == path) {
+            devices_[handle].HandleRemoved();
+        }
     }
+}
 
-    if (!data || size > 142) {
-        return DS_ERROR_INVALID_PARAM;
-    }
+void DeviceManager::HandleDeviceAdded(const std::string& path) {
+    for (int attempt = 0; attempt < RECONNECT_ATTEMPTS && hotplug_running_; attempt++) {
+        if (attempt > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(RECONNECT_RETRY_MS));
+        }
 
-    memcpy(device_.buffer_audio, data, size);
-    protocol::SendAudioHapticAdvanced(&device_);
+        // Nothing to reopen (e.g. some other HID device was plugged in)
+        {
+            std::lock_guard<std::mutex> lock(table_mutex_);
+            bool waiting = false;
+            for (DSHandle handle = 0; handle < DS_MAX_DEVICES; handle++) {
+                waiting = waiting || (in_use_[handle] && !devices_[handle].IsConnected() && !devices_[handle].IsVirtual());
+            }
+            if (!waiting) {
+                return;
+            }
+        }
 
-    return DS_OK;
-}
+        // Private list: ds_open indexes refer to enumerated_
+        std::vector<DeviceInfo> devices;
+        hid::DetectDevices(devices);
 
-DSResult DeviceManager::ResetAll() {
-    std::lock_guard<std::mutex> lock(mutex_);
+        const DeviceInfo* device_info = nullptr;
+        for (const DeviceInfo& candidate : devices) {
+            if (candidate.path == path) {
+                device_info = &candidate;
+                break;
+            }
+        }
+        if (!device_info) {
+            // Not a controller, or not enumerable yet
+            continue;
+        }
 
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
-    }
+        // Which controller this is decides whose handle it takes (I/O, so unlocked)
+        std::string identity;
+        {
+            std::unique_ptr<hid::Transport> probe = hid::CreateTransport();
+            if (!probe->Open(path)) {
+                continue;
+            }
+            identity = protocol::ReadDeviceIdentity(*probe, path, device_info->device_type, device_info->connection_type);
+        }
 
-    // Reset all outputs
-    device_.output.lightbar = {};
-    device_.output.rumbles = {};
-    device_.output.left_trigger.mode = 0x0;
-    device_.output.right_trigger.mode = 0x0;
-    device_.output.mic_light.mode = 0x0;
+        std::unique_lock<std::mutex> lock(table_mutex_);
 
-    return WriteOutput();
-}
+        const DSHandle handle = FindReconnectSlotLocked(*device_info, identity);
+        if (handle == DS_INVALID_HANDLE) {
+            return;
+        }
 
-DSResult DeviceManager::FlushOutput() {
-    std::lock_guard<std::mutex> lock(mutex_);
+        // Reopen without the table lock; closing this handle waits for it
+        BeginSlotIoLocked(handle, device_info->path);
+        lock.unlock();
+        const DSResult result = devices_[handle].Reconnect(*device_info);
+        lock.lock();
+        EndSlotIoLocked(handle);
 
-    if (!device_.is_connected) {
-        return DS_ERROR_NOT_CONNECTED;
+        if (result == DS_OK) {
+            return;
+        }
     }
-
-    return WriteOutput();
 }
 
-DSResult DeviceManager::WriteOutput() {
-    // Call appropriate output composer based on device type
-    if (device_.device_type == DS_DEVICE_DUALSHOCK4) {
-        protocol::OutputDualShock(&device_);
-    }
-    else {
-        protocol::OutputDualSense(&device_);
+bool DeviceManager::IsPathOpenLocked(const std::string& path) const {
+    for (DSHandle handle = 0; handle < DS_MAX_DEVICES; handle++) {
+        // A busy slot's device may be rewriting its path
+        if (busy_[handle] ? busy_path_[handle] == path : in_use_[handle] && devices_[handle].GetPath() == path) {
+            return true;
+        }
     }
-
-    return DS_OK;
+    return false;
 }
 
 } // namespace dualsense
@@ -1,12 +1,21 @@
-// Device Manager - Singleton for managing global device state
-// This manages a single DualSense device
+// Device Manager - Singleton owning the device table
+// Maps DSHandle values to Device slots. The legacy single-device API
+// (ds_init, ds_set_lightbar, ...) operates on a default handle.
 
 #pragma once
 
-#include "../core/device_context.h"
-#include "../hid/hid_constants.h"
+#include "device.h"
+#include "../hid/capture.h"
+#include "../hid/emulator.h"
+#include "../hid/hotplug.h"
+#include "../hid/transport.h"
 #include "../../include/dualsense.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 namespace dualsense {
 
@@ -15,63 +24,95 @@ public:
     // Get singleton instance
     static DeviceManager& Instance();
 
-    // Initialize and connect to device
-    DSResult Initialize();
+    // Enumerate connected controllers; ds_open indexes refer to this list
+    uint32_t GetDeviceCount();
 
-    // Shutdown and disconnect
-    void Shutdown();
+    // Open the index-th enumerated controller
+    DSResult Open(uint32_t index, DSHandle* out_handle);
 
-    // Check connection status
-    bool IsConnected() const;
+    // Open a capture file as a virtual controller
+    DSResult OpenReplay(const char* path, hid::ReplayMode mode, bool loop, DSHandle* out_handle);
 
-    // Get device information
-    DSConnectionType GetConnectionType() const;
-    DSDeviceType GetDeviceType() const;
+    // Open an emulated controller as a virtual device
+    DSResult OpenEmulator(const DSEmulatorConfig& config, DSHandle* out_handle);
 
-    // Input reading
-    DSResult UpdateInput();
-    DSResult GetInputState(DSInputState* out_state);
+    // Emulator behind a handle (nullptr if the handle is not an emulator)
+    std::shared_ptr<hid::ControllerEmulator> GetEmulator(DSHandle handle);
 
-    // LED control
-    DSResult SetLightbar(uint8_t r, uint8_t g, uint8_t b);
-    DSResult SetPlayerLed(DSLedPlayer led, DSLedBrightness brightness);
-    DSResult SetMicLed(DSLedMic mode);
+    // Close a handle and disconnect its controller
+    DSResult Close(DSHandle handle);
 
-    // Vibration control
-    DSResult SetRumble(uint8_t left, uint8_t right);
-    DSResult StopRumble();
+    // Look up the device behind a handle (nullptr if not open)
+    // Lock-free; the returned device stays valid for the process lifetime.
+    Device* GetDevice(DSHandle handle);
 
-    // Trigger effects
-    DSResult TriggerOff(bool left, bool right);
-    DSResult TriggerContinuousResistance(bool left, bool right, uint8_t start_pos, uint8_t force);
-    DSResult TriggerBow(bool left, bool right, uint8_t start, uint8_t end, uint8_t str_start, uint8_t str_end);
-    DSResult TriggerGalloping(bool left, bool right, uint8_t start, uint8_t end, uint8_t first, uint8_t second, uint8_t freq);
-    DSResult TriggerResistance(bool left, bool right, uint8_t str_start, uint8_t str_mid, uint8_t str_end);
-    DSResult TriggerWeapon(bool left, bool right, uint8_t start, uint8_t end, uint8_t strength);
-    DSResult TriggerAutomaticGun(bool left, bool right, uint8_t start, uint8_t strength, uint8_t freq);
-    DSResult TriggerMachine(bool left, bool right, uint8_t start, uint8_t amplitude, uint8_t freq);
-    DSResult TriggerCustom(bool left, bool right, const uint8_t params[10]);
+    // Packed state of every open handle, one column per slot (no locks taken)
+    DSResult GetAllStates(DSInputStateSoA* out_states);
 
-    // Audio haptics
-    DSResult SendAudioHaptic(const uint8_t* data, uint32_t size);
+    // Legacy API: connect the first free controller as the default device
+    DSResult Initialize();
 
-    // Utility
-    DSResult ResetAll();
-    DSResult FlushOutput();
+    // Legacy API: close the default device
+    void Shutdown();
+
+    // Legacy API: the default device (nullptr if none)
+    Device* GetDefaultDevice();
+
+    // Start/stop the hotplug watcher that reopens lost devices
+    // A null source uses the platform's native notifications.
+    DSResult SetAutoReconnect(bool enabled, std::unique_ptr<hid::HotplugSource> source = nullptr);
 
 private:
     DeviceManager() = default;
-    ~DeviceManager() = default;
+    ~DeviceManager();
     DeviceManager(const DeviceManager&) = delete;
     DeviceManager& operator=(const DeviceManager&) = delete;
 
-    // Internal helpers
-    void ApplyTriggerEffect(HapticTriggers& trigger, uint8_t mode, const uint8_t params[10]);
-    DSResult WriteOutput();
-
-    // Device state
-    DeviceContext device_;
-    std::mutex mutex_;
+    // Internal helpers (table_mutex_ held)
+    // OpenLocked releases lock while the device opens and holds it again on
+    // return; CloseLocked may release it to wait for a busy slot.
+    DSResult OpenLocked(const DeviceInfo& device_info, std::unique_lock<std::mutex>& lock, DSHandle* out_handle,
+                        std::unique_ptr<hid::Transport> transport = nullptr);
+    void CloseLocked(DSHandle handle, std::unique_lock<std::mutex>& lock);
+    bool IsPathOpenLocked(const std::string& path) const;
+    DSHandle FindReconnectSlotLocked(const DeviceInfo& device_info, const std::string& identity);
+
+    // Mark a slot whose device is being opened or reconnected without table_mutex_
+    void BeginSlotIoLocked(DSHandle handle, const std::string& path);
+    void EndSlotIoLocked(DSHandle handle);
+
+    // Hotplug watcher
+    void HotplugThreadMain();
+    void HandleDeviceAdded(const std::string& path);
+    void HandleDeviceRemoved(const std::string& path);
+
+    // Device table; slots are reused, never destroyed
+    Device devices_[DS_MAX_DEVICES];
+    std::atomic<bool> in_use_[DS_MAX_DEVICES] = {};
+
+    // Emulators behind virtual handles (guarded by table_mutex_)
+    std::shared_ptr<hid::ControllerEmulator> emulators_[DS_MAX_DEVICES];
+    uint32_t emulators_opened_ = 0;
+
+    // Handle used by the legacy single-device API
+    std::atomic<DSHandle> default_handle_{DS_INVALID_HANDLE};
+
+    // Result of the last enumeration
+    std::vector<DeviceInfo> enumerated_;
+
+    // Guards the slot table, enumerated_ and emulators_. Released during
+    // device I/O: enumeration, and opening or reconnecting a device, which
+    // happens on a busy slot that no other open or close touches.
+    std::mutex table_mutex_;
+    bool busy_[DS_MAX_DEVICES] = {};
+    std::string busy_path_[DS_MAX_DEVICES];     // Node being opened in a busy slot
+    std::condition_variable busy_cv_;           // Signaled when a slot stops being busy
+
+    // Hotplug watcher thread and its event source (guarded by hotplug_mutex_)
+    std::mutex hotplug_mutex_;
+    std::unique_ptr<hid::HotplugSource> hotplug_source_;
+    std::thread hotplug_thread_;
+    std::atomic<bool> hotplug_running_{false};
 };
 
 } // namespace dualsense
@@ -6,6 +6,31 @@
 
 using namespace dualsense;
 
+namespace {
+
+// Run fn on the device behind a handle
+template <typename Fn>
+DSResult WithDevice(DSHandle handle, Fn fn) {
+    Device* device = DeviceManager::Instance().GetDevice(handle);
+    return device ? fn(*device) : DS_ERROR_INVALID_HANDLE;
+}
+
+// Run fn on the default device (legacy single-device API)
+template <typename Fn>
+DSResult WithDefaultDevice(Fn fn) {
+    Device* device = DeviceManager::Instance().GetDefaultDevice();
+    return device ? fn(*device) : DS_ERROR_NOT_CONNECTED;
+}
+
+// Run fn on the emulator behind a handle
+template <typename Fn>
+DSResult WithEmulator(DSHandle handle, Fn fn) {
+    std::shared_ptr<hid::ControllerEmulator> emulator = DeviceManager::Instance().GetEmulator(handle);
+    return emulator ? fn(*emulator) : DS_ERROR_INVALID_HANDLE;
+}
+
+} // anonymous namespace
+
 extern "C" {
 
 // ========================================
@@ -21,15 +46,18 @@ DUALSENSE_API void ds_shutdown(void) {
 }
 
 DUALSENSE_API bool ds_is_connected(void) {
-    return DeviceManager::Instance().IsConnected();
+    Device* device = DeviceManager::Instance().GetDefaultDevice();
+    return device && device->IsConnected();
 }
 
 DUALSENSE_API DSConnectionType ds_get_connection_type(void) {
-    return DeviceManager::Instance().GetConnectionType();
+    Device* device = DeviceManager::Instance().GetDefaultDevice();
+    return device ? device->GetConnectionType() : DS_CONNECTION_UNKNOWN;
 }
 
 DUALSENSE_API DSDeviceType ds_get_device_type(void) {
-    return DeviceManager::Instance().GetDeviceType();
+    Device* device = DeviceManager::Instance().GetDefaultDevice();
+    return device ? device->GetDeviceType() : DS_DEVICE_NOT_FOUND;
 }
 
 // ========================================
@@ -37,11 +65,83 @@ DUALSENSE_API DSDeviceType ds_get_device_type(void) {
 // ========================================
 
 DUALSENSE_API DSResult ds_update_input(void) {
-    return DeviceManager::Instance().UpdateInput();
+    return WithDefaultDevice([&](Device& device) { return device.UpdateInput(); });
 }
 
 DUALSENSE_API DSResult ds_get_input_state(DSInputState* out_state) {
-    return DeviceManager::Instance().GetInputState(out_state);
+    return WithDefaultDevice([&](Device& device) { return device.GetInputState(out_state); });
+}
+
+DUALSENSE_API DSResult ds_start_input_thread(void) {
+    return WithDefaultDevice([&](Device& device) { return device.StartInputThread(); });
+}
+
+DUALSENSE_API DSResult ds_stop_input_thread(void) {
+    return WithDefaultDevice([&](Device& device) { return device.StopInputThread(); });
+}
+
+DUALSENSE_API DSResult ds_wait_for_input(int64_t timeout_us) {
+    return WithDefaultDevice([&](Device& device) { return device.WaitForInput(timeout_us); });
+}
+
+DUALSENSE_API DSResult ds_get_input_wait_handle(intptr_t* out_handle) {
+    return WithDefaultDevice([&](Device& device) { return device.GetInputWaitHandle(out_handle); });
+}
+
+DUALSENSE_API DSResult ds_set_input_crc_check(bool enabled) {
+    return WithDefaultDevice([&](Device& device) { return device.SetInputCrcCheck(enabled); });
+}
+
+DUALSENSE_API DSResult ds_get_input_counters(DSInputCounters* out_counters) {
+    return WithDefaultDevice([&](Device& device) { return device.GetInputCounters(out_counters); });
+}
+
+DUALSENSE_API DSResult ds_poll_events(DSEvent* events, uint32_t max_events, uint32_t* out_count) {
+    return WithDefaultDevice([&](Device& device) { return device.PollEvents(events, max_events, out_count); });
+}
+
+DUALSENSE_API DSResult ds_get_input_history(DSInputState* states, uint32_t max_states, uint32_t* out_count) {
+    return WithDefaultDevice([&](Device& device) { return device.GetInputHistory(states, max_states, out_count); });
+}
+
+DUALSENSE_API DSResult ds_get_input_aggregate(DSInputAggregate* out_aggregate) {
+    return WithDefaultDevice([&](Device& device) { return device.GetInputAggregate(out_aggregate); });
+}
+
+// ========================================
+// Touchpad Gestures
+// ========================================
+
+DUALSENSE_API DSResult ds_poll_gestures(DSGestureEvent* gestures, uint32_t max_gestures, uint32_t* out_count) {
+    return WithDefaultDevice([&](Device& device) { return device.PollGestures(gestures, max_gestures, out_count); });
+}
+
+// ========================================
+// Packed Input
+// ========================================
+
+DUALSENSE_API DSResult ds_get_packed_input_state(DSPackedInputState* out_state) {
+    return WithDefaultDevice([&](Device& device) { return device.GetPackedInputState(out_state); });
+}
+
+DUALSENSE_API DSResult ds_get_all_states(DSInputStateSoA* out_states) {
+    return DeviceManager::Instance().GetAllStates(out_states);
+}
+
+// ========================================
+// Analog Response
+// ========================================
+
+DUALSENSE_API DSResult ds_set_stick_response(uint32_t stick, const DSStickResponse* response) {
+    return WithDefaultDevice([&](Device& device) { return device.SetStickResponse(stick, response); });
+}
+
+DUALSENSE_API DSResult ds_set_trigger_response(uint32_t trigger, const DSResponseCurve* curve) {
+    return WithDefaultDevice([&](Device& device) { return device.SetTriggerResponse(trigger, curve); });
+}
+
+DUALSENSE_API DSResult ds_get_analog_state(DSAnalogState* out_state) {
+    return WithDefaultDevice([&](Device& device) { return device.GetAnalogState(out_state); });
 }
 
 // ========================================
@@ -49,15 +149,15 @@ DUALSENSE_API DSResult ds_get_input_state(DSInputState* out_state) {
 // ========================================
 
 DUALSENSE_API DSResult ds_set_lightbar(uint8_t r, uint8_t g, uint8_t b) {
-    return DeviceManager::Instance().SetLightbar(r, g, b);
+    return WithDefaultDevice([&](Device& device) { return device.SetLightbar(r, g, b); });
 }
 
 DUALSENSE_API DSResult ds_set_player_led(DSLedPlayer led, DSLedBrightness brightness) {
-    return DeviceManager::Instance().SetPlayerLed(led, brightness);
+    return WithDefaultDevice([&](Device& device) { return device.SetPlayerLed(led, brightness); });
 }
 
 DUALSENSE_API DSResult ds_set_mic_led(DSLedMic mode) {
-    return DeviceManager::Instance().SetMicLed(mode);
+    return WithDefaultDevice([&](Device& device) { return device.SetMicLed(mode); });
 }
 
 // ========================================
@@ -65,11 +165,11 @@ DUALSENSE_API DSResult ds_set_mic_led(DSLedMic mode) {
 // ========================================
 
 DUALSENSE_API DSResult ds_set_rumble(uint8_t left, uint8_t right) {
-    return DeviceManager::Instance().SetRumble(left, right);
+    return WithDefaultDevice([&](Device& device) { return device.SetRumble(left, right); });
 }
 
 DUALSENSE_API DSResult ds_stop_rumble(void) {
-    return DeviceManager::Instance().StopRumble();
+    return WithDefaultDevice([&](Device& device) { return device.StopRumble(); });
 }
 
 // ========================================
@@ -77,39 +177,55 @@ DUALSENSE_API DSResult ds_stop_rumble(void) {
 // ========================================
 
 DUALSENSE_API DSResult ds_trigger_off(bool left, bool right) {
-    return DeviceManager::Instance().TriggerOff(left, right);
+    return WithDefaultDevice([&](Device& device) { return device.TriggerOff(left, right); });
 }
 
 DUALSENSE_API DSResult ds_trigger_continuous_resistance(bool left, bool right, uint8_t start_position, uint8_t force) {
-    return DeviceManager::Instance().TriggerContinuousResistance(left, right, start_position, force);
+    return WithDefaultDevice([&](Device& device) { return device.TriggerContinuousResistance(left, right, start_position, force); });
 }
 
 DUALSENSE_API DSResult ds_trigger_bow(bool left, bool right, uint8_t start_position, uint8_t end_position, uint8_t strength_start, uint8_t strength_end) {
-    return DeviceManager::Instance().TriggerBow(left, right, start_position, end_position, strength_start, strength_end);
+    return WithDefaultDevice([&](Device& device) { return device.TriggerBow(left, right, start_position, end_position, strength_start, strength_end); });
 }
 
 DUALSENSE_API DSResult ds_trigger_galloping(bool left, bool right, uint8_t start_position, uint8_t end_position, uint8_t first_foot, uint8_t second_foot, uint8_t frequency) {
-    return DeviceManager::Instance().TriggerGalloping(left, right, start_position, end_position, first_foot, second_foot, frequency);
+    return WithDefaultDevice([&](Device& device) { return device.TriggerGalloping(left, right, start_position, end_position, first_foot, second_foot, frequency); });
 }
 
 DUALSENSE_API DSResult ds_trigger_resistance(bool left, bool right, uint8_t strength_start, uint8_t strength_mid, uint8_t strength_end) {
-    return DeviceManager::Instance().TriggerResistance(left, right, strength_start, strength_mid, strength_end);
+    return WithDefaultDevice([&](Device& device) { return device.TriggerResistance(left, right, strength_start, strength_mid, strength_end); });
 }
 
 DUALSENSE_API DSResult ds_trigger_weapon(bool left, bool right, uint8_t start_position, uint8_t end_position, uint8_t strength) {
-    return DeviceManager::Instance().TriggerWeapon(left, right, start_position, end_position, strength);
+    return WithDefaultDevice([&](Device& device) { return device.TriggerWeapon(left, right, start_position, end_position, strength); });
 }
 
 DUALSENSE_API DSResult ds_trigger_automatic_gun(bool left, bool right, uint8_t start_position, uint8_t strength, uint8_t frequency) {
-    return DeviceManager::Instance().TriggerAutomaticGun(left, right, start_position, strength, frequency);
+    return WithDefaultDevice([&](Device& device) { return device.TriggerAutomaticGun(left, right, start_position, strength, frequency); });
 }
 
 DUALSENSE_API DSResult ds_trigger_machine(bool left, bool right, uint8_t start_position, uint8_t amplitude, uint8_t frequency) {
-    return DeviceManager::Instance().TriggerMachine(left, right, start_position, amplitude, frequency);
+    return WithDefaultDevice([&](Device& device) { return device.TriggerMachine(left, right, start_position, amplitude, frequency); });
 }
 
 DUALSENSE_API DSResult ds_trigger_custom(bool left, bool right, const uint8_t params[10]) {
-    return DeviceManager::Instance().TriggerCustom(left, right, params);
+    return WithDefaultDevice([&](Device& device) { return device.TriggerCustom(left, right, params); });
+}
+
+// ========================================
+// Effect Timeline
+// ========================================
+
+DUALSENSE_API DSResult ds_play_timeline(const DSKeyframe* keyframes, uint32_t count, bool loop) {
+    return WithDefaultDevice([&](Device& device) { return device.PlayTimeline(keyframes, count, loop); });
+}
+
+DUALSENSE_API DSResult ds_stop_timeline(void) {
+    return WithDefaultDevice([&](Device& device) { return device.StopTimeline(); });
+}
+
+DUALSENSE_API DSResult ds_is_timeline_playing(bool* out_playing) {
+    return WithDefaultDevice([&](Device& device) { return device.IsTimelinePlaying(out_playing); });
 }
 
 // ========================================
@@ -117,7 +233,44 @@ DUALSENSE_API DSResult ds_trigger_custom(bool left, bool right, const uint8_t pa
 // ========================================
 
 DUALSENSE_API DSResult ds_send_audio_haptic(const uint8_t* data, uint32_t size) {
-    return DeviceManager::Instance().SendAudioHaptic(data, size);
+    return WithDefaultDevice([&](Device& device) { return device.SendAudioHaptic(data, size); });
+}
+
+DUALSENSE_API DSResult ds_start_haptic_stream(void) {
+    return WithDefaultDevice([&](Device& device) { return device.StartHapticStream(); });
+}
+
+DUALSENSE_API DSResult ds_stop_haptic_stream(void) {
+    return WithDefaultDevice([&](Device& device) { return device.StopHapticStream(); });
+}
+
+DUALSENSE_API DSResult ds_write_haptic_stream(const int8_t* samples, uint32_t frame_count,
+                                              uint32_t* out_frames_written) {
+    return WithDefaultDevice([&](Device& device) {
+        return device.WriteHapticStream(samples, frame_count, out_frames_written);
+    });
+}
+
+DUALSENSE_API DSResult ds_get_haptic_stream_stats(DSHapticStreamStats* out_stats) {
+    return WithDefaultDevice([&](Device& device) { return device.GetHapticStreamStats(out_stats); });
+}
+
+DUALSENSE_API DSResult ds_configure_haptic_pcm(uint32_t sample_rate, uint32_t channels, float gain) {
+    return WithDefaultDevice([&](Device& device) { return device.ConfigureHapticPcm(sample_rate, channels, gain); });
+}
+
+DUALSENSE_API DSResult ds_write_haptic_pcm_f32(const float* samples, uint32_t frame_count,
+                                               uint32_t* out_frames_consumed) {
+    return WithDefaultDevice([&](Device& device) {
+        return device.WriteHapticPcm(samples, frame_count, out_frames_consumed);
+    });
+}
+
+DUALSENSE_API DSResult ds_write_haptic_pcm_s16(const int16_t* samples, uint32_t frame_count,
+                                               uint32_t* out_frames_consumed) {
+    return WithDefaultDevice([&](Device& device) {
+        return device.WriteHapticPcm(samples, frame_count, out_frames_consumed);
+    });
 }
 
 // ========================================
@@ -125,11 +278,386 @@ DUALSENSE_API DSResult ds_send_audio_haptic(const uint8_t* data, uint32_t size)
 // ========================================
 
 DUALSENSE_API DSResult ds_reset_all(void) {
-    return DeviceManager::Instance().ResetAll();
+    return WithDefaultDevice([&](Device& device) { return device.ResetAll(); });
 }
 
 DUALSENSE_API DSResult ds_flush_output(void) {
-    return DeviceManager::Instance().FlushOutput();
+    return WithDefaultDevice([&](Device& device) { return device.FlushOutput(); });
+}
+
+// ========================================
+// Output Report Elision
+// ========================================
+
+DUALSENSE_API DSResult ds_set_output_keepalive(uint32_t interval_ms) {
+    return WithDefaultDevice([&](Device& device) { return device.SetOutputKeepalive(interval_ms); });
+}
+
+DUALSENSE_API DSResult ds_get_output_counters(DSOutputCounters* out_counters) {
+    return WithDefaultDevice([&](Device& device) { return device.GetOutputCounters(out_counters); });
+}
+
+// ========================================
+// Output Writer Thread
+// ========================================
+
+DUALSENSE_API DSResult ds_start_output_thread(void) {
+    return WithDefaultDevice([&](Device& device) { return device.StartOutputThread(); });
+}
+
+DUALSENSE_API DSResult ds_stop_output_thread(void) {
+    return WithDefaultDevice([&](Device& device) { return device.StopOutputThread(); });
+}
+
+DUALSENSE_API DSResult ds_set_output_rate(uint32_t reports_per_second) {
+    return WithDefaultDevice([&](Device& device) { return device.SetOutputRate(reports_per_second); });
+}
+
+// ========================================
+// Automatic Reconnect
+// ========================================
+
+DUALSENSE_API DSResult ds_set_auto_reconnect(bool enabled) {
+    return DeviceManager::Instance().SetAutoReconnect(enabled);
+}
+
+DUALSENSE_API DSResult ds_get_reconnect_stats(DSReconnectStats* out_stats) {
+    return WithDefaultDevice([&](Device& device) { return device.GetReconnectStats(out_stats); });
+}
+
+// ========================================
+// Runtime Statistics
+// ========================================
+
+DUALSENSE_API DSResult ds_get_stats(DSStats* out_stats) {
+    return WithDefaultDevice([&](Device& device) { return device.GetStats(out_stats); });
+}
+
+DUALSENSE_API DSResult ds_reset_stats(void) {
+    return WithDefaultDevice([&](Device& device) { return device.ResetStats(); });
+}
+
+// ========================================
+// Capture and Replay
+// ========================================
+
+DUALSENSE_API DSResult ds_start_capture(const char* path) {
+    return WithDefaultDevice([&](Device& device) { return device.StartCapture(path); });
+}
+
+DUALSENSE_API DSResult ds_stop_capture(void) {
+    return WithDefaultDevice([&](Device& device) { return device.StopCapture(); });
+}
+
+DUALSENSE_API DSResult ds_open_replay(const char* path, DSReplayMode mode, bool loop, DSHandle* out_handle) {
+    const hid::ReplayMode replay_mode = (mode == DS_REPLAY_FAST) ? hid::ReplayMode::Fast : hid::ReplayMode::Realtime;
+    return DeviceManager::Instance().OpenReplay(path, replay_mode, loop, out_handle);
+}
+
+// ========================================
+// Software Emulator
+// ========================================
+
+DUALSENSE_API DSResult ds_open_emulator(const DSEmulatorConfig* config, DSHandle* out_handle) {
+    if (!config) {
+        return DS_ERROR_INVALID_PARAM;
+    }
+    return DeviceManager::Instance().OpenEmulator(*config, out_handle);
+}
+
+DUALSENSE_API DSResult ds_emulator_set_input(DSHandle handle, const DSInputState* state) {
+    return WithEmulator(handle, [&](hid::ControllerEmulator& emulator) {
+        if (!state) {
+            return DS_ERROR_INVALID_PARAM;
+        }
+        emulator.SetInput(*state);
+        return DS_OK;
+    });
+}
+
+DUALSENSE_API DSResult ds_emulator_play_script(DSHandle handle, const DSEmulatorStep* steps, uint32_t count, bool loop) {
+    return WithEmulator(handle, [&](hid::ControllerEmulator& emulator) {
+        return emulator.PlayScript(steps, count, loop) ? DS_OK : DS_ERROR_INVALID_PARAM;
+    });
+}
+
+DUALSENSE_API DSResult ds_emulator_disconnect(DSHandle handle) {
+    return WithEmulator(handle, [&](hid::ControllerEmulator& emulator) {
+        emulator.Disconnect();
+        return DS_OK;
+    });
+}
+
+DUALSENSE_API DSResult ds_get_emulator_stats(DSHandle handle, DSEmulatorStats* out_stats) {
+    return WithEmulator(handle, [&](hid::ControllerEmulator& emulator) {
+        if (!out_stats) {
+            return DS_ERROR_INVALID_PARAM;
+        }
+        emulator.GetStats(out_stats);
+        return DS_OK;
+    });
+}
+
+DUALSENSE_API DSResult ds_emulator_get_output(DSHandle handle, uint8_t* buffer, uint32_t size, uint32_t* out_size) {
+    return WithEmulator(handle, [&](hid::ControllerEmulator& emulator) {
+        if (!buffer || !out_size) {
+            return DS_ERROR_INVALID_PARAM;
+        }
+        *out_size = static_cast<uint32_t>(emulator.GetLastOutput(buffer, size));
+        return (*out_size > 0) ? DS_OK : DS_ERROR_NOT_FOUND;
+    });
+}
+
+// ========================================
+// Multi-Device API
+// ========================================
+
+DUALSENSE_API uint32_t ds_get_device_count(void) {
+    return DeviceManager::Instance().GetDeviceCount();
+}
+
+DUALSENSE_API DSResult ds_open(uint32_t index, DSHandle* out_handle) {
+    return DeviceManager::Instance().Open(index, out_handle);
+}
+
+DUALSENSE_API DSResult ds_close(DSHandle handle) {
+    return DeviceManager::Instance().Close(handle);
+}
+
+DUALSENSE_API bool ds_is_connected_ex(DSHandle handle) {
+    Device* device = DeviceManager::Instance().GetDevice(handle);
+    return device && device->IsConnected();
+}
+
+DUALSENSE_API DSConnectionType ds_get_connection_type_ex(DSHandle handle) {
+    Device* device = DeviceManager::Instance().GetDevice(handle);
+    return device ? device->GetConnectionType() : DS_CONNECTION_UNKNOWN;
+}
+
+DUALSENSE_API DSDeviceType ds_get_device_type_ex(DSHandle handle) {
+    Device* device = DeviceManager::Instance().GetDevice(handle);
+    return device ? device->GetDeviceType() : DS_DEVICE_NOT_FOUND;
+}
+
+DUALSENSE_API DSResult ds_update_input_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.UpdateInput(); });
+}
+
+DUALSENSE_API DSResult ds_get_input_state_ex(DSHandle handle, DSInputState* out_state) {
+    return WithDevice(handle, [&](Device& device) { return device.GetInputState(out_state); });
+}
+
+DUALSENSE_API DSResult ds_start_input_thread_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.StartInputThread(); });
+}
+
+DUALSENSE_API DSResult ds_stop_input_thread_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.StopInputThread(); });
+}
+
+DUALSENSE_API DSResult ds_wait_for_input_ex(DSHandle handle, int64_t timeout_us) {
+    return WithDevice(handle, [&](Device& device) { return device.WaitForInput(timeout_us); });
+}
+
+DUALSENSE_API DSResult ds_get_input_wait_handle_ex(DSHandle handle, intptr_t* out_handle) {
+    return WithDevice(handle, [&](Device& device) { return device.GetInputWaitHandle(out_handle); });
+}
+
+DUALSENSE_API DSResult ds_set_input_crc_check_ex(DSHandle handle, bool enabled) {
+    return WithDevice(handle, [&](Device& device) { return device.SetInputCrcCheck(enabled); });
+}
+
+DUALSENSE_API DSResult ds_get_input_counters_ex(DSHandle handle, DSInputCounters* out_counters) {
+    return WithDevice(handle, [&](Device& device) { return device.GetInputCounters(out_counters); });
+}
+
+DUALSENSE_API DSResult ds_poll_events_ex(DSHandle handle, DSEvent* events, uint32_t max_events, uint32_t* out_count) {
+    return WithDevice(handle, [&](Device& device) { return device.PollEvents(events, max_events, out_count); });
+}
+
+DUALSENSE_API DSResult ds_get_input_history_ex(DSHandle handle, DSInputState* states, uint32_t max_states, uint32_t* out_count) {
+    return WithDevice(handle, [&](Device& device) { return device.GetInputHistory(states, max_states, out_count); });
+}
+
+DUALSENSE_API DSResult ds_get_input_aggregate_ex(DSHandle handle, DSInputAggregate* out_aggregate) {
+    return WithDevice(handle, [&](Device& device) { return device.GetInputAggregate(out_aggregate); });
+}
+
+DUALSENSE_API DSResult ds_poll_gestures_ex(DSHandle handle, DSGestureEvent* gestures, uint32_t max_gestures, uint32_t* out_count) {
+    return WithDevice(handle, [&](Device& device) { return device.PollGestures(gestures, max_gestures, out_count); });
+}
+
+DUALSENSE_API DSResult ds_get_packed_input_state_ex(DSHandle handle, DSPackedInputState* out_state) {
+    return WithDevice(handle, [&](Device& device) { return device.GetPackedInputState(out_state); });
+}
+
+DUALSENSE_API DSResult ds_set_stick_response_ex(DSHandle handle, uint32_t stick, const DSStickResponse* response) {
+    return WithDevice(handle, [&](Device& device) { return device.SetStickResponse(stick, response); });
+}
+
+DUALSENSE_API DSResult ds_set_trigger_response_ex(DSHandle handle, uint32_t trigger, const DSResponseCurve* curve) {
+    return WithDevice(handle, [&](Device& device) { return device.SetTriggerResponse(trigger, curve); });
+}
+
+DUALSENSE_API DSResult ds_get_analog_state_ex(DSHandle handle, DSAnalogState* out_state) {
+    return WithDevice(handle, [&](Device& device) { return device.GetAnalogState(out_state); });
+}
+
+DUALSENSE_API DSResult ds_set_lightbar_ex(DSHandle handle, uint8_t r, uint8_t g, uint8_t b) {
+    return WithDevice(handle, [&](Device& device) { return device.SetLightbar(r, g, b); });
+}
+
+DUALSENSE_API DSResult ds_set_player_led_ex(DSHandle handle, DSLedPlayer led, DSLedBrightness brightness) {
+    return WithDevice(handle, [&](Device& device) { return device.SetPlayerLed(led, brightness); });
+}
+
+DUALSENSE_API DSResult ds_set_mic_led_ex(DSHandle handle, DSLedMic mode) {
+    return WithDevice(handle, [&](Device& device) { return device.SetMicLed(mode); });
+}
+
+DUALSENSE_API DSResult ds_set_rumble_ex(DSHandle handle, uint8_t left, uint8_t right) {
+    return WithDevice(handle, [&](Device& device) { return device.SetRumble(left, right); });
+}
+
+DUALSENSE_API DSResult ds_stop_rumble_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.StopRumble(); });
+}
+
+DUALSENSE_API DSResult ds_trigger_off_ex(DSHandle handle, bool left, bool right) {
+    return WithDevice(handle, [&](Device& device) { return device.TriggerOff(left, right); });
+}
+
+DUALSENSE_API DSResult ds_trigger_continuous_resistance_ex(DSHandle handle, bool left, bool right, uint8_t start_position, uint8_t force) {
+    return WithDevice(handle, [&](Device& device) { return device.TriggerContinuousResistance(left, right, start_position, force); });
+}
+
+DUALSENSE_API DSResult ds_trigger_bow_ex(DSHandle handle, bool left, bool right, uint8_t start_position, uint8_t end_position, uint8_t strength_start, uint8_t strength_end) {
+    return WithDevice(handle, [&](Device& device) { return device.TriggerBow(left, right, start_position, end_position, strength_start, strength_end); });
+}
+
+DUALSENSE_API DSResult ds_trigger_galloping_ex(DSHandle handle, bool left, bool right, uint8_t start_position, uint8_t end_position, uint8_t first_foot, uint8_t second_foot, uint8_t frequency) {
+    return WithDevice(handle, [&](Device& device) { return device.TriggerGalloping(left, right, start_position, end_position, first_foot, second_foot, frequency); });
+}
+
+DUALSENSE_API DSResult ds_trigger_resistance_ex(DSHandle handle, bool left, bool right, uint8_t strength_start, uint8_t strength_mid, uint8_t strength_end) {
+    return WithDevice(handle, [&](Device& device) { return device.TriggerResistance(left, right, strength_start, strength_mid, strength_end); });
+}
+
+DUALSENSE_API DSResult ds_trigger_weapon_ex(DSHandle handle, bool left, bool right, uint8_t start_position, uint8_t end_position, uint8_t strength) {
+    return WithDevice(handle, [&](Device& device) { return device.TriggerWeapon(left, right, start_position, end_position, strength); });
+}
+
+DUALSENSE_API DSResult ds_trigger_automatic_gun_ex(DSHandle handle, bool left, bool right, uint8_t start_position, uint8_t strength, uint8_t frequency) {
+    return WithDevice(handle, [&](Device& device) { return device.TriggerAutomaticGun(left, right, start_position, strength, frequency); });
+}
+
+DUALSENSE_API DSResult ds_trigger_machine_ex(DSHandle handle, bool left, bool right, uint8_t start_position, uint8_t amplitude, uint8_t frequency) {
+    return WithDevice(handle, [&](Device& device) { return device.TriggerMachine(left, right, start_position, amplitude, frequency); });
+}
+
+DUALSENSE_API DSResult ds_trigger_custom_ex(DSHandle handle, bool left, bool right, const uint8_t params[10]) {
+    return WithDevice(handle, [&](Device& device) { return device.TriggerCustom(left, right, params); });
+}
+
+DUALSENSE_API DSResult ds_play_timeline_ex(DSHandle handle, const DSKeyframe* keyframes, uint32_t count, bool loop) {
+    return WithDevice(handle, [&](Device& device) { return device.PlayTimeline(keyframes, count, loop); });
+}
+
+DUALSENSE_API DSResult ds_stop_timeline_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.StopTimeline(); });
+}
+
+DUALSENSE_API DSResult ds_is_timeline_playing_ex(DSHandle handle, bool* out_playing) {
+    return WithDevice(handle, [&](Device& device) { return device.IsTimelinePlaying(out_playing); });
+}
+
+DUALSENSE_API DSResult ds_send_audio_haptic_ex(DSHandle handle, const uint8_t* data, uint32_t size) {
+    return WithDevice(handle, [&](Device& device) { return device.SendAudioHaptic(data, size); });
+}
+
+DUALSENSE_API DSResult ds_start_haptic_stream_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.StartHapticStream(); });
+}
+
+DUALSENSE_API DSResult ds_stop_haptic_stream_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.StopHapticStream(); });
+}
+
+DUALSENSE_API DSResult ds_write_haptic_stream_ex(DSHandle handle, const int8_t* samples, uint32_t frame_count,
+                                                 uint32_t* out_frames_written) {
+    return WithDevice(handle, [&](Device& device) {
+        return device.WriteHapticStream(samples, frame_count, out_frames_written);
+    });
+}
+
+DUALSENSE_API DSResult ds_get_haptic_stream_stats_ex(DSHandle handle, DSHapticStreamStats* out_stats) {
+    return WithDevice(handle, [&](Device& device) { return device.GetHapticStreamStats(out_stats); });
+}
+
+DUALSENSE_API DSResult ds_configure_haptic_pcm_ex(DSHandle handle, uint32_t sample_rate, uint32_t channels, float gain) {
+    return WithDevice(handle, [&](Device& device) { return device.ConfigureHapticPcm(sample_rate, channels, gain); });
+}
+
+DUALSENSE_API DSResult ds_write_haptic_pcm_f32_ex(DSHandle handle, const float* samples, uint32_t frame_count,
+                                                  uint32_t* out_frames_consumed) {
+    return WithDevice(handle, [&](Device& device) {
+        return device.WriteHapticPcm(samples, frame_count, out_frames_consumed);
+    });
+}
+
+DUALSENSE_API DSResult ds_write_haptic_pcm_s16_ex(DSHandle handle, const int16_t* samples, uint32_t frame_count,
+                                                  uint32_t* out_frames_consumed) {
+    return WithDevice(handle, [&](Device& device) {
+        return device.WriteHapticPcm(samples, frame_count, out_frames_consumed);
+    });
+}
+
+DUALSENSE_API DSResult ds_reset_all_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.ResetAll(); });
+}
+
+DUALSENSE_API DSResult ds_flush_output_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.FlushOutput(); });
+}
+
+DUALSENSE_API DSResult ds_set_output_keepalive_ex(DSHandle handle, uint32_t interval_ms) {
+    return WithDevice(handle, [&](Device& device) { return device.SetOutputKeepalive(interval_ms); });
+}
+
+DUALSENSE_API DSResult ds_get_output_counters_ex(DSHandle handle, DSOutputCounters* out_counters) {
+    return WithDevice(handle, [&](Device& device) { return device.GetOutputCounters(out_counters); });
+}
+
+DUALSENSE_API DSResult ds_start_output_thread_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.StartOutputThread(); });
+}
+
+DUALSENSE_API DSResult ds_stop_output_thread_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.StopOutputThread(); });
+}
+
+DUALSENSE_API DSResult ds_set_output_rate_ex(DSHandle handle, uint32_t reports_per_second) {
+    return WithDevice(handle, [&](Device& device) { return device.SetOutputRate(reports_per_second); });
+}
+
+DUALSENSE_API DSResult ds_get_reconnect_stats_ex(DSHandle handle, DSReconnectStats* out_stats) {
+    return WithDevice(handle, [&](Device& device) { return device.GetReconnectStats(out_stats); });
+}
+
+DUALSENSE_API DSResult ds_get_stats_ex(DSHandle handle, DSStats* out_stats) {
+    return WithDevice(handle, [&](Device& device) { return device.GetStats(out_stats); });
+}
+
+DUALSENSE_API DSResult ds_reset_stats_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.ResetStats(); });
+}
+
+DUALSENSE_API DSResult ds_start_capture_ex(DSHandle handle, const char* path) {
+    return WithDevice(handle, [&](Device& device) { return device.StartCapture(path); });
+}
+
+DUALSENSE_API DSResult ds_stop_capture_ex(DSHandle handle) {
+    return WithDevice(handle, [&](Device& device) { return device.StopCapture(); });
 }
 
 } // extern "C"
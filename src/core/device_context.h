@@ -4,19 +4,20 @@
 #pragma once
 
 #include "output_context.h"
-#include <Windows.h>
+#include "../hid/transport.h"
+#include <atomic>
+#include <memory>
 #include <string>
 
 namespace dualsense {
 
 // Device context - holds all device state
 struct DeviceContext {
-    // Device handles
-    HANDLE handle = INVALID_HANDLE_VALUE;
-    HANDLE audio_handle = INVALID_HANDLE_VALUE;
+    // Device transport (owns the OS handle)
+    std::unique_ptr<hid::Transport> transport;
 
     // Device path
-    std::wstring path;
+    std::string path;
 
     // HID buffers
     unsigned char buffer_input[78] = {};
@@ -24,8 +25,8 @@ struct DeviceContext {
     unsigned char buffer_audio[142] = {};
     unsigned char buffer_output[78] = {};
 
-    // Connection status
-    bool is_connected = false;
+    // Connection status (read without the device lock)
+    std::atomic<bool> is_connected{false};
 
     // Output settings
     OutputContext output;
@@ -35,11 +36,6 @@ struct DeviceContext {
 
     // Device type (DSDeviceType enum values)
     int device_type = 255;  // DS_DEVICE_NOT_FOUND
-
-    // Runtime trigger override
-    bool override_trigger_bytes = false;
-    unsigned char override_trigger_right[10] = {};
-    unsigned char override_trigger_left[10] = {};
 };
 
 } // namespace dualsense
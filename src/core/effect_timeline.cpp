@@ -0,0 +1,199 @@
+// Keyframed Effect Timeline
+
+#include "effect_timeline.h"
+#include <algorithm>
+#include <cstring>
+
+namespace dualsense {
+
+namespace {
+
+// Fraction of a segment (0-1) shaped by the keyframe's curve
+float ApplyCurve(uint8_t curve, float t) {
+    switch (curve) {
+    case DS_CURVE_LINEAR:
+        return t;
+    case DS_CURVE_EASE_IN:
+        return t * t;
+    case DS_CURVE_EASE_OUT:
+        return 1.0f - (1.0f - t) * (1.0f - t);
+    case DS_CURVE_EASE_IN_OUT:
+        return t * t * (3.0f - 2.0f * t);
+    default:    // DS_CURVE_STEP
+        return 0.0f;
+    }
+}
+
+// Bytes of DSKeyframe::value interpolated for a target ([first, last))
+void InterpolatedRange(uint8_t target, const DSKeyframe& from, const DSKeyframe& to, size_t* first, size_t* last) {
+    *first = 0;
+    *last = 0;
+    switch (target) {
+    case DS_TIMELINE_LIGHTBAR:
+        *last = 3;
+        break;
+    case DS_TIMELINE_RUMBLE:
+        *last = 2;
+        break;
+    case DS_TIMELINE_LEFT_TRIGGER:
+    case DS_TIMELINE_RIGHT_TRIGGER:
+        // Parameters of different effect modes do not mean the same thing
+        if (from.value[0] == to.value[0]) {
+            *first = 1;
+            *last = 11;
+        }
+        break;
+    default:    // Player LED masks are not interpolated
+        break;
+    }
+}
+
+void ApplyTrigger(HapticTriggers& trigger, uint32_t dirty_flag, const uint8_t value[11], OutputContext& output) {
+    if (trigger.mode != value[0] || memcmp(trigger.strengths.compose, &value[1], 10) != 0) {
+        trigger.mode = value[0];
+        memcpy(trigger.strengths.compose, &value[1], 10);
+        output.dirty |= dirty_flag;
+    }
+}
+
+void ApplyValue(uint8_t target, const uint8_t value[11], OutputContext& output) {
+    switch (target) {
+    case DS_TIMELINE_LIGHTBAR: {
+        Lightbar& lightbar = output.lightbar;
+        if (lightbar.r != value[0] || lightbar.g != value[1] || lightbar.b != value[2]) {
+            lightbar.r = value[0];
+            lightbar.g = value[1];
+            lightbar.b = value[2];
+            output.dirty |= OUTPUT_DIRTY_LIGHTBAR;
+        }
+        break;
+    }
+    case DS_TIMELINE_RUMBLE: {
+        Rumbles& rumbles = output.rumbles;
+        if (rumbles.left != value[0] || rumbles.right != value[1]) {
+            rumbles.left = value[0];
+            rumbles.right = value[1];
+            output.dirty |= OUTPUT_DIRTY_RUMBLE;
+        }
+        break;
+    }
+    case DS_TIMELINE_PLAYER_LED: {
+        PlayerLed& player_led = output.player_led;
+        if (player_led.led != value[0] || player_led.brightness != value[1]) {
+            player_led.led = value[0];
+            player_led.brightness = value[1];
+            output.dirty |= OUTPUT_DIRTY_PLAYER_LED;
+        }
+        break;
+    }
+    case DS_TIMELINE_LEFT_TRIGGER:
+        ApplyTrigger(output.left_trigger, OUTPUT_DIRTY_LEFT_TRIGGER, value, output);
+        break;
+    case DS_TIMELINE_RIGHT_TRIGGER:
+        ApplyTrigger(output.right_trigger, OUTPUT_DIRTY_RIGHT_TRIGGER, value, output);
+        break;
+    default:
+        break;
+    }
+}
+
+} // anonymous namespace
+
+bool EffectTimeline::Load(const DSKeyframe* keyframes, uint32_t count, bool loop) {
+    if (!keyframes || count == 0 || count > DS_MAX_KEYFRAMES) {
+        return false;
+    }
+
+    Track tracks[TIMELINE_TARGET_COUNT];
+    uint32_t duration_ms = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const DSKeyframe& key = keyframes[i];
+        if (key.target >= TIMELINE_TARGET_COUNT || key.curve > DS_CURVE_EASE_IN_OUT) {
+            return false;
+        }
+        tracks[key.target].keys.push_back(key);
+        duration_ms = std::max(duration_ms, key.time_ms);
+    }
+
+    // Stable: keyframes sharing a time keep their order, the last one wins
+    for (Track& track : tracks) {
+        std::stable_sort(track.keys.begin(), track.keys.end(),
+                         [](const DSKeyframe& a, const DSKeyframe& b) { return a.time_ms < b.time_ms; });
+    }
+
+    for (size_t i = 0; i < TIMELINE_TARGET_COUNT; i++) {
+        tracks_[i] = std::move(tracks[i]);
+    }
+    duration_ms_ = duration_ms;
+    loop_ = loop;
+    return true;
+}
+
+bool EffectTimeline::Evaluate(uint64_t elapsed_ms, OutputContext& output) {
+    bool playing = true;
+    bool wrapped = false;
+    uint32_t time_ms;
+
+    if (loop_ && duration_ms_ > 0) {
+        wrapped = elapsed_ms >= duration_ms_;
+        time_ms = static_cast<uint32_t>(elapsed_ms % duration_ms_);
+    }
+    else if (elapsed_ms >= duration_ms_) {
+        time_ms = duration_ms_;
+        playing = false;
+    }
+    else {
+        time_ms = static_cast<uint32_t>(elapsed_ms);
+    }
+
+    for (size_t target = 0; target < TIMELINE_TARGET_COUNT; target++) {
+        Track& track = tracks_[target];
+        const std::vector<DSKeyframe>& keys = track.keys;
+        if (keys.empty()) {
+            continue;
+        }
+
+        // Last keyframe at or before time_ms; time only moves forward between wraps
+        size_t& cursor = track.cursor;
+        if (cursor >= keys.size() || keys[cursor].time_ms > time_ms) {
+            cursor = 0;
+        }
+        while (cursor + 1 < keys.size() && keys[cursor + 1].time_ms <= time_ms) {
+            cursor++;
+        }
+
+        uint8_t value[11];
+        if (keys[cursor].time_ms > time_ms) {
+            // Before the first keyframe: untouched on the first pass, then
+            // holding the value the previous loop ended on
+            if (!wrapped) {
+                continue;
+            }
+            memcpy(value, keys.back().value, sizeof(value));
+        }
+        else if (cursor + 1 == keys.size()) {
+            memcpy(value, keys[cursor].value, sizeof(value));
+        }
+        else {
+            const DSKeyframe& from = keys[cursor];
+            const DSKeyframe& to = keys[cursor + 1];
+            const float fraction = static_cast<float>(time_ms - from.time_ms) / static_cast<float>(to.time_ms - from.time_ms);
+            const float amount = ApplyCurve(to.curve, fraction);
+
+            memcpy(value, from.value, sizeof(value));
+            size_t first;
+            size_t last;
+            InterpolatedRange(static_cast<uint8_t>(target), from, to, &first, &last);
+            for (size_t i = first; i < last; i++) {
+                const float delta = static_cast<float>(to.value[i]) - static_cast<float>(from.value[i]);
+                value[i] = static_cast<uint8_t>(static_cast<float>(from.value[i]) + delta * amount + 0.5f);
+            }
+        }
+
+        ApplyValue(static_cast<uint8_t>(target), value, output);
+    }
+
+    return playing;
+}
+
+} // namespace dualsense
@@ -0,0 +1,42 @@
+// Keyframed Effect Timeline
+// Interpolates lightbar, rumble, player LED and trigger keyframes into an OutputContext
+
+#pragma once
+
+#include "output_context.h"
+#include "../../include/dualsense.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace dualsense {
+
+// Number of DSTimelineTarget values
+constexpr size_t TIMELINE_TARGET_COUNT = 5;
+
+class EffectTimeline {
+public:
+    // Load keyframes in any order. Returns false (and keeps the previous
+    // timeline) if the list is empty, too long or has an unknown target/curve.
+    bool Load(const DSKeyframe* keyframes, uint32_t count, bool loop);
+
+    // Time of the last keyframe
+    uint32_t GetDuration() const { return duration_ms_; }
+
+    // Write the state at elapsed_ms into output, marking changed fields dirty.
+    // Returns false once a non-looping timeline has passed its last keyframe.
+    bool Evaluate(uint64_t elapsed_ms, OutputContext& output);
+
+private:
+    // Keyframes of one target sorted by time; cursor caches the active segment
+    struct Track {
+        std::vector<DSKeyframe> keys;
+        size_t cursor = 0;
+    };
+
+    Track tracks_[TIMELINE_TARGET_COUNT];
+    uint32_t duration_ms_ = 0;
+    bool loop_ = false;
+};
+
+} // namespace dualsense
@@ -73,6 +73,17 @@ struct DualShockFlashLightbar {
     uint8_t toggle_time = 0x0;
 };
 
+// OutputContext::dirty bits (fields changed since the last composed report)
+enum OutputDirtyFlags : uint32_t {
+    OUTPUT_DIRTY_LIGHTBAR = 1u << 0,
+    OUTPUT_DIRTY_PLAYER_LED = 1u << 1,
+    OUTPUT_DIRTY_MIC_LIGHT = 1u << 2,
+    OUTPUT_DIRTY_RUMBLE = 1u << 3,
+    OUTPUT_DIRTY_LEFT_TRIGGER = 1u << 4,
+    OUTPUT_DIRTY_RIGHT_TRIGGER = 1u << 5,
+    OUTPUT_DIRTY_ALL = 0xFFFFFFFFu,
+};
+
 // Complete output context
 struct OutputContext {
     Lightbar lightbar;
@@ -84,6 +95,14 @@ struct OutputContext {
     FeatureConfig feature;
     HapticTriggers left_trigger;
     HapticTriggers right_trigger;
+
+    // Runtime trigger override (raw bytes sent instead of the effects above)
+    bool override_trigger_bytes = false;
+    unsigned char override_trigger_right[10] = {};
+    unsigned char override_trigger_left[10] = {};
+
+    // OutputDirtyFlags; cleared when the state is handed to the writer
+    uint32_t dirty = OUTPUT_DIRTY_ALL;
 };
 
 } // namespace dualsense
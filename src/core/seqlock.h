@@ -0,0 +1,70 @@
+// Sequence Lock
+// Single-writer, multi-reader snapshot of a trivially copyable value
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <stdint.h>
+#include <type_traits>
+
+namespace dualsense {
+
+// Readers never block the writer and never take a lock; a read retries only
+// if it overlapped a store. The payload is kept in relaxed atomic words so
+// concurrent access is well-defined.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+    SeqLock() {
+        for (auto& word : data_) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Publish a new value (must not be called concurrently with itself)
+    void Store(const T& value) {
+        uint64_t words[WORD_COUNT] = {};
+        memcpy(words, &value, sizeof(T));
+
+        const uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            data_[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copy out the latest published value
+    T Load() const {
+        uint64_t words[WORD_COUNT];
+        uint32_t seq_begin;
+        uint32_t seq_end;
+
+        do {
+            seq_begin = seq_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORD_COUNT; i++) {
+                words[i] = data_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seq_end = seq_.load(std::memory_order_relaxed);
+        } while (seq_begin != seq_end || (seq_begin & 1) != 0);
+
+        T value;
+        memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> seq_{0};
+    std::atomic<uint64_t> data_[WORD_COUNT];
+};
+
+} // namespace dualsense
@@ -0,0 +1,104 @@
+// Single-Producer Single-Consumer Ring Buffer
+// Lock-free FIFO of trivially copyable elements with a fixed capacity
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <stddef.h>
+#include <type_traits>
+
+namespace dualsense {
+
+// One thread calls Write/MarkDiscarded, one other thread calls Read/Discard.
+// Neither side ever blocks; Write stores as much as fits and Read returns
+// what is there.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing requires a trivially copyable type");
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    // Append up to count elements (producer). Returns the number stored.
+    size_t Write(const T* data, size_t count) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t free_space = Capacity - (head - tail);
+        if (count > free_space) {
+            count = free_space;
+        }
+
+        const size_t offset = head & MASK;
+        const size_t first = (count < Capacity - offset) ? count : Capacity - offset;
+        memcpy(&buffer_[offset], data, first * sizeof(T));
+        memcpy(&buffer_[0], data + first, (count - first) * sizeof(T));
+
+        head_.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // Remove up to count elements into out (consumer). Returns the number read.
+    size_t Read(T* out, size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t discard_end = discard_end_.load(std::memory_order_acquire);
+        if (static_cast<ptrdiff_t>(discard_end - tail) > 0) {
+            tail = discard_end;
+        }
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t available = head - tail;
+        if (count > available) {
+            count = available;
+        }
+
+        const size_t offset = tail & MASK;
+        const size_t first = (count < Capacity - offset) ? count : Capacity - offset;
+        memcpy(out, &buffer_[offset], first * sizeof(T));
+        memcpy(out + first, &buffer_[0], (count - first) * sizeof(T));
+
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Drop everything currently queued (consumer)
+    void Discard() {
+        tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Drop everything written so far (producer, or a thread that stopped it).
+    // The consumer skips it on its next Read; until then it still takes up space.
+    void MarkDiscarded() {
+        discard_end_.store(head_.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+
+    // Number of queued elements (exact on either side, approximate elsewhere)
+    size_t Size() const {
+        // Tail first: the head read afterwards can only be further ahead
+        size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t discard_end = discard_end_.load(std::memory_order_acquire);
+        if (static_cast<ptrdiff_t>(discard_end - tail) > 0) {
+            tail = discard_end;
+        }
+        const size_t head = head_.load(std::memory_order_acquire);
+        return head - tail;
+    }
+
+    // Number of elements Write can currently store (exact on the producer side)
+    size_t FreeSpace() const {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return Capacity - (head - tail);
+    }
+
+    static constexpr size_t CAPACITY = Capacity;
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    // Indices grow without bound and are masked on access
+    alignas(64) std::atomic<size_t> head_{0};   // Written by the producer
+    std::atomic<size_t> discard_end_{0};        // Written by the producer; Read starts no earlier
+    alignas(64) std::atomic<size_t> tail_{0};   // Written by the consumer
+    T buffer_[Capacity];
+};
+
+} // namespace dualsense
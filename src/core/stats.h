@@ -0,0 +1,154 @@
+// Runtime Statistics
+// Lock-free counters and log2-bucketed latency histograms, recorded on the
+// I/O paths with relaxed atomics and read at any time by ds_get_stats
+
+#pragma once
+
+#include "../../include/dualsense.h"
+#include <atomic>
+#include <chrono>
+#include <initializer_list>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace dualsense {
+
+// Bucket of a duration: 0 = under 1 us, i = [2^(i-1), 2^i) us, last = the rest
+inline size_t HistogramBucket(uint64_t us) {
+    if (us == 0) {
+        return 0;
+    }
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long msb;
+    _BitScanReverse64(&msb, us);
+    const size_t bucket = static_cast<size_t>(msb) + 1;
+#elif defined(_MSC_VER)
+    // 32-bit targets have no _BitScanReverse64: scan the high half, then the low half
+    unsigned long msb;
+    size_t bucket;
+    if (_BitScanReverse(&msb, static_cast<unsigned long>(us >> 32))) {
+        bucket = static_cast<size_t>(msb) + 33;
+    }
+    else {
+        _BitScanReverse(&msb, static_cast<unsigned long>(us));
+        bucket = static_cast<size_t>(msb) + 1;
+    }
+#else
+    const size_t bucket = static_cast<size_t>(64 - __builtin_clzll(us));
+#endif
+    return (bucket < DS_HISTOGRAM_BUCKETS) ? bucket : DS_HISTOGRAM_BUCKETS - 1;
+}
+
+// Microseconds between two steady_clock points (0 if out of order)
+inline uint64_t ElapsedMicros(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    const int64_t us = std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+    return (us > 0) ? static_cast<uint64_t>(us) : 0;
+}
+
+// Durations in microseconds; Record may be called from any thread
+class LatencyHistogram {
+public:
+    LatencyHistogram() { Reset(); }
+
+    void Record(uint64_t us) {
+        buckets_[HistogramBucket(us)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_us_.fetch_add(us, std::memory_order_relaxed);
+        uint64_t max = max_us_.load(std::memory_order_relaxed);
+        while (us > max && !max_us_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    void Reset() {
+        for (auto& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        count_.store(0, std::memory_order_relaxed);
+        sum_us_.store(0, std::memory_order_relaxed);
+        max_us_.store(0, std::memory_order_relaxed);
+    }
+
+    // Fields are read one by one, so records in flight may be partly included
+    void Snapshot(DSHistogram* out) const {
+        out->count = count_.load(std::memory_order_relaxed);
+        out->sum_us = sum_us_.load(std::memory_order_relaxed);
+        out->max_us = max_us_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < DS_HISTOGRAM_BUCKETS; i++) {
+            out->buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_us_;
+    std::atomic<uint64_t> max_us_;
+    std::atomic<uint64_t> buckets_[DS_HISTOGRAM_BUCKETS];
+};
+
+// Everything ds_get_stats reports for one device
+struct DeviceStats {
+    std::atomic<uint64_t> reports_received{0};
+    std::atomic<uint64_t> reports_dropped{0};
+    std::atomic<uint64_t> read_errors{0};
+    std::atomic<uint64_t> reports_written{0};
+    std::atomic<uint64_t> reports_elided{0};
+    std::atomic<uint64_t> write_failures{0};
+    std::atomic<uint64_t> audio_reports{0};
+    std::atomic<uint64_t> audio_underruns{0};
+    std::atomic<uint64_t> sequence_gaps{0};
+    std::atomic<uint64_t> reports_lost{0};
+    std::atomic<uint64_t> reports_duplicated{0};
+    std::atomic<uint64_t> reports_reordered{0};
+    std::atomic<uint32_t> device_interval_us{0};
+
+    LatencyHistogram report_interval;
+    LatencyHistogram report_wait;
+    LatencyHistogram write_latency;
+    LatencyHistogram input_age;
+    LatencyHistogram jitter;
+
+    static void Count(std::atomic<uint64_t>& counter) {
+        counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Reset() {
+        for (std::atomic<uint64_t>* counter : { &reports_received, &reports_dropped, &read_errors, &reports_written,
+                                                &reports_elided, &write_failures, &audio_reports, &audio_underruns,
+                                                &sequence_gaps, &reports_lost, &reports_duplicated, &reports_reordered }) {
+            counter->store(0, std::memory_order_relaxed);
+        }
+        device_interval_us.store(0, std::memory_order_relaxed);
+        report_interval.Reset();
+        report_wait.Reset();
+        write_latency.Reset();
+        input_age.Reset();
+        jitter.Reset();
+    }
+
+    void Snapshot(DSStats* out) const {
+        out->reports_received = reports_received.load(std::memory_order_relaxed);
+        out->reports_dropped = reports_dropped.load(std::memory_order_relaxed);
+        out->read_errors = read_errors.load(std::memory_order_relaxed);
+        out->reports_written = reports_written.load(std::memory_order_relaxed);
+        out->reports_elided = reports_elided.load(std::memory_order_relaxed);
+        out->write_failures = write_failures.load(std::memory_order_relaxed);
+        out->audio_reports = audio_reports.load(std::memory_order_relaxed);
+        out->audio_underruns = audio_underruns.load(std::memory_order_relaxed);
+        out->sequence_gaps = sequence_gaps.load(std::memory_order_relaxed);
+        out->reports_lost = reports_lost.load(std::memory_order_relaxed);
+        out->reports_duplicated = reports_duplicated.load(std::memory_order_relaxed);
+        out->reports_reordered = reports_reordered.load(std::memory_order_relaxed);
+        out->device_interval_us = device_interval_us.load(std::memory_order_relaxed);
+        report_interval.Snapshot(&out->report_interval);
+        report_wait.Snapshot(&out->report_wait);
+        write_latency.Snapshot(&out->write_latency);
+        input_age.Snapshot(&out->input_age);
+        jitter.Snapshot(&out->jitter);
+    }
+};
+
+} // namespace dualsense
@@ -0,0 +1,377 @@
+// HID Traffic Capture and Replay (platform-independent parts)
+
+#include "capture.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+constexpr unsigned char CAPTURE_MAGIC[4] = { 'D', 'S', 'C', 'P' };
+constexpr uint16_t CAPTURE_VERSION = 1;
+constexpr size_t CAPTURE_HEADER_SIZE = 16;
+
+// Unchanged bytes shorter than this stay inside a literal run
+constexpr size_t MIN_UNCHANGED_RUN = 3;
+
+void WriteVarint(std::vector<unsigned char>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+} // anonymous namespace
+
+namespace dualsense {
+namespace hid {
+
+CaptureWriter::~CaptureWriter() {
+    Close();
+}
+
+bool CaptureWriter::Open(const std::string& path, int device_type, int connection_type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        printf("Capture: Failed to create %s\n", path.c_str());
+        return false;
+    }
+    setvbuf(file_, nullptr, _IOFBF, 1 << 16);
+
+    unsigned char header[CAPTURE_HEADER_SIZE] = {};
+    memcpy(header, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    header[4] = static_cast<unsigned char>(CAPTURE_VERSION);
+    header[5] = static_cast<unsigned char>(CAPTURE_VERSION >> 8);
+    header[6] = static_cast<unsigned char>(device_type);
+    header[7] = static_cast<unsigned char>(connection_type);
+    fwrite(header, 1, sizeof(header), file_);
+
+    start_ = std::chrono::steady_clock::now();
+    last_time_us_ = 0;
+    records_ = 0;
+    memset(previous_, 0, sizeof(previous_));
+    record_.reserve(CAPTURE_MAX_REPORT_SIZE + 32);
+    return true;
+}
+
+void CaptureWriter::Append(CaptureKind kind, const unsigned char* data, size_t size) {
+    const auto now = std::chrono::steady_clock::now();
+    size = std::min(size, CAPTURE_MAX_REPORT_SIZE);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!file_) {
+        return;
+    }
+
+    // Timestamps from other threads can arrive slightly out of order
+    const uint64_t time_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - start_).count());
+    const uint64_t delta_us = (time_us > last_time_us_) ? time_us - last_time_us_ : 0;
+    last_time_us_ += delta_us;
+
+    record_.clear();
+    record_.push_back(static_cast<unsigned char>(kind));
+    WriteVarint(record_, delta_us);
+    WriteVarint(record_, size);
+
+    unsigned char* previous = previous_[static_cast<size_t>(kind)];
+    size_t offset = 0;
+    while (offset < size) {
+        const size_t unchanged_start = offset;
+        while (offset < size && data[offset] == previous[offset]) {
+            offset++;
+        }
+        const size_t literal_start = offset;
+
+        // Extend the literal up to the next run worth a token (or the end)
+        while (offset < size) {
+            size_t run = 0;
+            while (run < MIN_UNCHANGED_RUN && offset + run < size && data[offset + run] == previous[offset + run]) {
+                run++;
+            }
+            if (run == MIN_UNCHANGED_RUN || (run > 0 && offset + run == size)) {
+                break;
+            }
+            offset += (run > 0) ? run : 1;
+        }
+
+        WriteVarint(record_, literal_start - unchanged_start);
+        WriteVarint(record_, offset - literal_start);
+        record_.insert(record_.end(), data + literal_start, data + offset);
+    }
+    memcpy(previous, data, size);
+
+    if (fwrite(record_.data(), 1, record_.size(), file_) != record_.size()) {
+        printf("Capture: Write failed, capture stopped\n");
+        fclose(file_);
+        file_ = nullptr;
+        return;
+    }
+    records_++;
+}
+
+void CaptureWriter::Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool CaptureReader::Open(const unsigned char* data, size_t size) {
+    if (!data || size < CAPTURE_HEADER_SIZE || memcmp(data, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) {
+        return false;
+    }
+    const uint16_t version = static_cast<uint16_t>(data[4] | (data[5] << 8));
+    if (version != CAPTURE_VERSION) {
+        printf("Capture: Unsupported capture version %u\n", version);
+        return false;
+    }
+
+    data_ = data;
+    size_ = size;
+    device_type_ = data[6];
+    connection_type_ = data[7];
+    Rewind();
+    return true;
+}
+
+void CaptureReader::Rewind() {
+    offset_ = CAPTURE_HEADER_SIZE;
+    time_us_ = 0;
+    memset(previous_, 0, sizeof(previous_));
+}
+
+bool CaptureReader::ReadVarint(uint64_t* out_value) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset_ >= size_) {
+            return false;
+        }
+        const unsigned char byte = data_[offset_++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *out_value = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CaptureReader::Next(CaptureKind* out_kind, uint64_t* out_time_us, const unsigned char** out_report, size_t* out_size) {
+    if (offset_ >= size_) {
+        return false;
+    }
+
+    const unsigned char kind = data_[offset_++];
+    uint64_t delta_us;
+    uint64_t size;
+    if (kind >= CAPTURE_KIND_COUNT || !ReadVarint(&delta_us) || !ReadVarint(&size) || size > CAPTURE_MAX_REPORT_SIZE) {
+        offset_ = size_;
+        return false;
+    }
+
+    // Decode in place: unchanged bytes are already in the previous report
+    unsigned char* report = previous_[kind];
+    size_t position = 0;
+    while (position < size) {
+        uint64_t unchanged;
+        uint64_t literal;
+        if (!ReadVarint(&unchanged) || !ReadVarint(&literal) ||
+            unchanged > size - position || literal > size - position - unchanged ||
+            literal > size_ - offset_) {
+            offset_ = size_;
+            return false;
+        }
+        position += static_cast<size_t>(unchanged);
+        memcpy(report + position, data_ + offset_, static_cast<size_t>(literal));
+        position += static_cast<size_t>(literal);
+        offset_ += static_cast<size_t>(literal);
+    }
+
+    time_us_ += delta_us;
+    *out_kind = static_cast<CaptureKind>(kind);
+    *out_time_us = time_us_;
+    *out_report = report;
+    *out_size = static_cast<size_t>(size);
+    return true;
+}
+
+bool ReadCaptureInfo(const std::string& path, int* out_device_type, int* out_connection_type) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+
+    unsigned char header[CAPTURE_HEADER_SIZE];
+    const bool read = fread(header, 1, sizeof(header), file) == sizeof(header);
+    fclose(file);
+
+    CaptureReader reader;
+    if (!read || !reader.Open(header, sizeof(header))) {
+        return false;
+    }
+    *out_device_type = reader.GetDeviceType();
+    *out_connection_type = reader.GetConnectionType();
+    return true;
+}
+
+bool ReplayTransport::Open(const std::string& path) {
+    Close();
+
+    file_ = MapFile(path);
+    if (!file_ || !reader_.Open(file_->GetData(), file_->GetSize())) {
+        printf("Capture: Failed to open replay %s\n", path.c_str());
+        file_.reset();
+        return false;
+    }
+
+    // One pass to collect feature reports (latest per ID wins)
+    CaptureKind kind;
+    uint64_t time_us;
+    const unsigned char* report;
+    size_t size;
+    while (reader_.Next(&kind, &time_us, &report, &size)) {
+        duration_us_ = time_us;
+        if (kind != CaptureKind::Feature || size == 0) {
+            continue;
+        }
+        auto existing = std::find_if(features_.begin(), features_.end(),
+                                     [&](const std::vector<unsigned char>& feature) { return feature[0] == report[0]; });
+        if (existing != features_.end()) {
+            existing->assign(report, report + size);
+        }
+        else {
+            features_.emplace_back(report, report + size);
+        }
+    }
+    reader_.Rewind();
+
+    // The first input report is due immediately
+    has_pending_ = false;
+    ended_ = false;
+    if (Advance()) {
+        base_ = Clock::now() - std::chrono::microseconds(pending_time_us_);
+    }
+    return true;
+}
+
+void ReplayTransport::Close() {
+    file_.reset();
+    features_.clear();
+    has_pending_ = false;
+    ended_ = true;
+}
+
+bool ReplayTransport::IsOpen() const {
+    return file_ != nullptr;
+}
+
+bool ReplayTransport::Advance() {
+    CaptureKind kind;
+    uint64_t time_us;
+    const unsigned char* report;
+    size_t size;
+    for (;;) {
+        if (!reader_.Next(&kind, &time_us, &report, &size)) {
+            if (!loop_ || duration_us_ == 0) {
+                return false;
+            }
+
+            // Start over right away, keeping the original spacing within a pass
+            reader_.Rewind();
+            if (!reader_.Next(&kind, &time_us, &report, &size)) {
+                return false;
+            }
+            base_ = Clock::now() - std::chrono::microseconds(time_us);
+        }
+        if (kind == CaptureKind::Input) {
+            break;
+        }
+    }
+
+    pending_report_ = report;
+    pending_size_ = size;
+    pending_time_us_ = time_us;
+    has_pending_ = true;
+    return true;
+}
+
+int ReplayTransport::Read(unsigned char* buffer, size_t size, int timeout_ms) {
+    if (!file_ || ended_) {
+        return READ_ERROR;
+    }
+
+    if (!has_pending_ && !Advance()) {
+        ended_ = true;
+        return READ_ERROR;
+    }
+
+    if (mode_ == ReplayMode::Realtime) {
+        const Clock::time_point due = base_ + std::chrono::microseconds(pending_time_us_);
+        const Clock::time_point now = Clock::now();
+        if (now < due) {
+            if (timeout_ms == 0) {
+                return READ_TIMEOUT;
+            }
+            if (timeout_ms > 0 && now + std::chrono::milliseconds(timeout_ms) < due) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+                return READ_TIMEOUT;
+            }
+            std::this_thread::sleep_until(due);
+        }
+    }
+
+    const size_t length = std::min(size, pending_size_);
+    memcpy(buffer, pending_report_, length);
+    has_pending_ = false;
+    return static_cast<int>(length);
+}
+
+bool ReplayTransport::Write(const unsigned char* buffer, size_t size) {
+    (void)buffer;
+    (void)size;
+    writes_++;
+    return file_ != nullptr && !ended_;
+}
+
+bool ReplayTransport::GetFeature(unsigned char* buffer, size_t size) {
+    for (const std::vector<unsigned char>& feature : features_) {
+        if (feature[0] == buffer[0]) {
+            memcpy(buffer, feature.data(), std::min(size, feature.size()));
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReplayTransport::Flush() {
+    // As fast as possible: nothing ever queues up
+    if (mode_ != ReplayMode::Realtime || !file_ || ended_) {
+        return;
+    }
+
+    // Drop reports that are already due, like the OS queue of a live device
+    const Clock::time_point now = Clock::now();
+    for (;;) {
+        if (!has_pending_ && !Advance()) {
+            return;
+        }
+        if (base_ + std::chrono::microseconds(pending_time_us_) > now) {
+            return;
+        }
+        has_pending_ = false;
+    }
+}
+
+bool ReplayTransport::Ping() {
+    return file_ != nullptr && !ended_;
+}
+
+} // namespace hid
+} // namespace dualsense
@@ -0,0 +1,159 @@
+// HID Traffic Capture and Replay
+// Binary log of raw input/output/feature reports, and a transport that plays
+// one back from a memory-mapped file without hardware.
+//
+// File layout (little-endian):
+//   header  "DSCP", u16 version, u8 device type, u8 connection type, 8 reserved bytes
+//   record  u8 kind, varint microseconds since the previous record, varint size,
+//           then (varint unchanged, varint literal, literal bytes)... until size
+//           bytes are covered. Unchanged bytes repeat the previous report of the
+//           same kind, so only the fields that moved are stored.
+
+#pragma once
+
+#include "transport.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dualsense {
+namespace hid {
+
+// Report direction stored in a capture record
+enum class CaptureKind : uint8_t {
+    Input = 0,      // Read from the device
+    Output = 1,     // Written to the device (output and audio reports)
+    Feature = 2,    // Feature report returned by the device
+};
+
+constexpr size_t CAPTURE_KIND_COUNT = 3;
+
+// Largest report a capture can hold
+constexpr size_t CAPTURE_MAX_REPORT_SIZE = 1024;
+
+// Appends reports to a capture file; Append may be called from any thread
+class CaptureWriter {
+public:
+    ~CaptureWriter();
+
+    // Create (truncate) the file and write the header
+    bool Open(const std::string& path, int device_type, int connection_type);
+
+    // Record one report, timestamped now. Ignored once closed.
+    void Append(CaptureKind kind, const unsigned char* data, size_t size);
+
+    // Flush and close the file
+    void Close();
+
+    uint64_t GetRecordCount() const { return records_; }
+
+private:
+    std::mutex mutex_;
+    FILE* file_ = nullptr;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t last_time_us_ = 0;
+    std::atomic<uint64_t> records_{0};
+
+    // Previous report of each kind (delta reference) and the encoded record
+    unsigned char previous_[CAPTURE_KIND_COUNT][CAPTURE_MAX_REPORT_SIZE] = {};
+    std::vector<unsigned char> record_;
+};
+
+// Sequential decoder over capture data held in memory
+class CaptureReader {
+public:
+    // Check the header and position at the first record
+    bool Open(const unsigned char* data, size_t size);
+
+    int GetDeviceType() const { return device_type_; }
+    int GetConnectionType() const { return connection_type_; }
+
+    // Decode the next record. The report stays valid until the next call.
+    // Returns false at the end of the data or on a corrupt record.
+    bool Next(CaptureKind* out_kind, uint64_t* out_time_us, const unsigned char** out_report, size_t* out_size);
+
+    // Go back to the first record
+    void Rewind();
+
+private:
+    bool ReadVarint(uint64_t* out_value);
+
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    uint64_t time_us_ = 0;
+    int device_type_ = 0;
+    int connection_type_ = 0;
+    unsigned char previous_[CAPTURE_KIND_COUNT][CAPTURE_MAX_REPORT_SIZE] = {};
+};
+
+// Read-only view of a whole file (platform backend)
+class MappedFile {
+public:
+    virtual ~MappedFile() = default;
+    virtual const unsigned char* GetData() const = 0;
+    virtual size_t GetSize() const = 0;
+};
+
+// Map a file for reading (nullptr on failure or if empty)
+std::unique_ptr<MappedFile> MapFile(const std::string& path);
+
+// Model and connection type recorded in a capture's header
+bool ReadCaptureInfo(const std::string& path, int* out_device_type, int* out_connection_type);
+
+// How a replay paces input reports
+enum class ReplayMode {
+    Realtime,   // At the offsets they were captured with
+    Fast,       // Back to back, as fast as they are read
+};
+
+// Transport that serves a capture's input and feature reports
+// Writes are accepted and counted. At the end of the capture the device
+// reports a disconnect, or starts over when looping.
+class ReplayTransport : public Transport {
+public:
+    ReplayTransport(ReplayMode mode, bool loop) : mode_(mode), loop_(loop) {}
+
+    bool Open(const std::string& path) override;
+    void Close() override;
+    bool IsOpen() const override;
+    int Read(unsigned char* buffer, size_t size, int timeout_ms) override;
+    bool Write(const unsigned char* buffer, size_t size) override;
+    bool GetFeature(unsigned char* buffer, size_t size) override;
+    void Flush() override;
+    bool Ping() override;
+
+    uint64_t GetWriteCount() const { return writes_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Load the next input record into pending_* (false at the end)
+    bool Advance();
+
+    ReplayMode mode_;
+    bool loop_;
+    std::unique_ptr<MappedFile> file_;
+    CaptureReader reader_;
+
+    // Feature reports by report ID, collected when opened
+    std::vector<std::vector<unsigned char>> features_;
+
+    // Next input report and when it is due
+    bool has_pending_ = false;
+    const unsigned char* pending_report_ = nullptr;
+    size_t pending_size_ = 0;
+    uint64_t pending_time_us_ = 0;
+    Clock::time_point base_;
+    uint64_t duration_us_ = 0;
+    std::atomic<bool> ended_{false};
+
+    std::atomic<uint64_t> writes_{0};
+};
+
+} // namespace hid
+} // namespace dualsense
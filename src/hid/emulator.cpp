@@ -0,0 +1,329 @@
+// Software Controller Emulator
+
+#include "emulator.h"
+#include "../protocol/crc32.h"
+#include "../protocol/motion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Largest input report (Bluetooth)
+constexpr size_t MAX_INPUT_REPORT_SIZE = 78;
+
+// Raw LSB per unit at the nominal calibration the emulator reports
+constexpr float GYRO_LSB_PER_DPS = 32768.0f / 2000.0f;
+constexpr float ACCEL_LSB_PER_G = 8192.0f;
+
+int16_t ToRaw(float value, float lsb_per_unit) {
+    const float raw = std::round(value * lsb_per_unit);
+    return static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, raw)));
+}
+
+uint32_t ReadLE32(const unsigned char* data) {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+void WriteLE32(unsigned char* data, uint32_t value) {
+    data[0] = static_cast<unsigned char>(value);
+    data[1] = static_cast<unsigned char>(value >> 8);
+    data[2] = static_cast<unsigned char>(value >> 16);
+    data[3] = static_cast<unsigned char>(value >> 24);
+}
+
+} // anonymous namespace
+
+namespace dualsense {
+namespace hid {
+
+ControllerEmulator::ControllerEmulator(const DSEmulatorConfig& config)
+    : config_(config),
+      input_format_(protocol::GetInputFormat(config.device_type, config.connection_type)),
+      output_format_(protocol::GetOutputFormat(config.device_type, config.connection_type)),
+      period_(config.report_rate_hz ? std::chrono::nanoseconds(1000000000ull / config.report_rate_hz)
+                                    : std::chrono::nanoseconds(0)),
+      start_(Clock::now()),
+      rng_(config.seed ? config.seed : 0x9E3779B9u) {
+    // Idle controller lying flat: sticks centered, no touch, fully charged
+    DSInputState idle = {};
+    idle.stick_lx = idle.stick_ly = idle.stick_rx = idle.stick_ry = 128;
+    idle.battery_level = 100;
+    idle.accel_y = 1.0f;
+    LoadState(idle);
+}
+
+bool ControllerEmulator::IsValidConfig(const DSEmulatorConfig& config) {
+    return protocol::GetInputFormat(config.device_type, config.connection_type) != nullptr &&
+           protocol::GetOutputFormat(config.device_type, config.connection_type) != nullptr;
+}
+
+void ControllerEmulator::SetInput(const DSInputState& state) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    script_.clear();
+    LoadState(state);
+}
+
+void ControllerEmulator::LoadState(const DSInputState& state) {
+    state_ = state;
+    motion_.gyro[0] = ToRaw(state.gyro_x, GYRO_LSB_PER_DPS);
+    motion_.gyro[1] = ToRaw(state.gyro_y, GYRO_LSB_PER_DPS);
+    motion_.gyro[2] = ToRaw(state.gyro_z, GYRO_LSB_PER_DPS);
+    motion_.accel[0] = ToRaw(state.accel_x, ACCEL_LSB_PER_G);
+    motion_.accel[1] = ToRaw(state.accel_y, ACCEL_LSB_PER_G);
+    motion_.accel[2] = ToRaw(state.accel_z, ACCEL_LSB_PER_G);
+}
+
+bool ControllerEmulator::PlayScript(const DSEmulatorStep* steps, uint32_t count, bool loop) {
+    if (!steps || count == 0) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (steps[i].hold_reports == 0) {
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    script_.assign(steps, steps + count);
+    script_step_ = 0;
+    script_left_ = script_[0].hold_reports;
+    script_loop_ = loop;
+    return true;
+}
+
+void ControllerEmulator::Disconnect() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    connected_ = false;
+    wake_.notify_all();
+}
+
+void ControllerEmulator::GetStats(DSEmulatorStats* out_stats) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    *out_stats = stats_;
+}
+
+size_t ControllerEmulator::GetLastOutput(unsigned char* buffer, size_t size) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const size_t length = std::min(size, last_output_size_);
+    memcpy(buffer, last_output_, length);
+    return last_output_size_;
+}
+
+ControllerEmulator::Clock::time_point ControllerEmulator::DueTime(uint64_t report) const {
+    return start_ + period_ * static_cast<int64_t>(report);
+}
+
+bool ControllerEmulator::Chance(uint32_t per_million) {
+    if (per_million == 0) {
+        return false;
+    }
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return (rng_ % 1000000u) < per_million;
+}
+
+bool ControllerEmulator::Step() {
+    if (!connected_) {
+        return false;
+    }
+    if (config_.disconnect_after_reports != 0 && next_report_ >= config_.disconnect_after_reports) {
+        connected_ = false;
+        wake_.notify_all();
+        return false;
+    }
+
+    if (!script_.empty()) {
+        // Steps held for several reports only convert on their first
+        if (script_left_ == script_[script_step_].hold_reports) {
+            LoadState(script_[script_step_].state);
+        }
+
+        if (--script_left_ == 0) {
+            if (++script_step_ == script_.size()) {
+                script_step_ = 0;
+                if (!script_loop_) {
+                    script_.clear();    // state_ holds the last step
+                }
+            }
+            if (!script_.empty()) {
+                script_left_ = script_[script_step_].hold_reports;
+            }
+        }
+    }
+
+    // Sensor clock advances by one report period, paced or not
+    const uint32_t rate_hz = config_.report_rate_hz ? config_.report_rate_hz : EMULATOR_NOMINAL_RATE_HZ;
+    const double time_us = static_cast<double>(next_report_) * 1000000.0 / rate_hz;
+    motion_.timestamp = static_cast<uint32_t>(static_cast<uint64_t>(time_us / input_format_->timestamp_tick_us)) &
+                        input_format_->timestamp_mask;
+
+    next_report_++;
+    return true;
+}
+
+int ControllerEmulator::Read(unsigned char* buffer, size_t size, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    const Clock::time_point deadline = (timeout_ms >= 0)
+        ? Clock::now() + std::chrono::milliseconds(timeout_ms) : Clock::time_point::max();
+    const auto disconnected = [this] { return !connected_; };
+
+    for (;;) {
+        if (!connected_) {
+            return READ_ERROR;
+        }
+
+        if (period_.count() > 0) {
+            // Reports due so far; the oldest are lost once the queue is full
+            const Clock::time_point now = Clock::now();
+            const uint64_t due = static_cast<uint64_t>((now - start_) / period_) + 1;
+            while (due > next_report_ + EMULATOR_QUEUE_DEPTH && Step()) {
+                stats_.reports_overwritten++;
+            }
+
+            const Clock::time_point next_due = DueTime(next_report_);
+            if (next_due > now) {
+                if (timeout_ms == 0) {
+                    return READ_TIMEOUT;
+                }
+                if (next_due > deadline) {
+                    wake_.wait_until(lock, deadline, disconnected);
+                    return connected_ ? READ_TIMEOUT : READ_ERROR;
+                }
+                wake_.wait_until(lock, next_due, disconnected);
+                continue;
+            }
+        }
+
+        if (!Step()) {
+            return READ_ERROR;
+        }
+        if (Chance(config_.drop_per_million)) {
+            stats_.reports_dropped++;
+            continue;
+        }
+
+        unsigned char report[MAX_INPUT_REPORT_SIZE];
+        const size_t report_size = input_format_->report_size;
+        input_format_->encode(state_, motion_, static_cast<uint8_t>(next_report_ - 1), report);
+        if (input_format_->has_crc) {
+            const size_t crc_offset = report_size - 4;
+            WriteLE32(&report[crc_offset], protocol::ComputeCRC32(report, crc_offset, protocol::CRC_SEED_INPUT));
+            if (Chance(config_.crc_error_per_million)) {
+                report[crc_offset] ^= 0xFF;
+                stats_.reports_corrupted++;
+            }
+        }
+
+        stats_.reports_sent++;
+        const size_t length = std::min(size, report_size);
+        memcpy(buffer, report, length);
+        return static_cast<int>(length);
+    }
+}
+
+bool ControllerEmulator::CheckCRC(const unsigned char* buffer, size_t size) const {
+    return size > 4 && protocol::ComputeCRC32(buffer, size - 4) == ReadLE32(&buffer[size - 4]);
+}
+
+bool ControllerEmulator::Write(const unsigned char* buffer, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!connected_) {
+        return false;
+    }
+
+    const protocol::OutputFormat& format = *output_format_;
+    const bool haptics = config_.connection_type == DS_CONNECTION_BLUETOOTH &&
+                         config_.device_type != DS_DEVICE_DUALSHOCK4;
+
+    // A malformed report is still "sent"; only the counters tell
+    if (size == format.report_size && buffer[0] == format.report_id && (!format.has_crc || CheckCRC(buffer, size))) {
+        stats_.output_reports++;
+        memcpy(last_output_, buffer, size);
+        last_output_size_ = size;
+    }
+    else if (haptics && size == protocol::HAPTIC_REPORT_SIZE && buffer[0] == 0x32 && CheckCRC(buffer, size)) {
+        stats_.audio_reports++;
+    }
+    else {
+        stats_.invalid_writes++;
+    }
+    return true;
+}
+
+bool ControllerEmulator::GetFeature(unsigned char* buffer, size_t size) {
+    if (!connected_) {
+        return false;
+    }
+
+    unsigned char calibration[protocol::CALIBRATION_REPORT_MAX_SIZE];
+    const size_t calibration_size = protocol::WriteNominalCalibrationReport(config_.device_type, config_.connection_type,
+                                                                           calibration);
+    if (buffer[0] != calibration[0]) {
+        return false;
+    }
+    memcpy(buffer, calibration, std::min(size, calibration_size));
+    return true;
+}
+
+void ControllerEmulator::Flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (period_.count() == 0) {
+        return;
+    }
+
+    // Discard every report already due, as the OS queue would
+    const uint64_t due = static_cast<uint64_t>((Clock::now() - start_) / period_) + 1;
+    while (next_report_ < due && Step()) {
+        stats_.reports_overwritten++;
+    }
+}
+
+bool EmulatedTransport::Open(const std::string& path) {
+    (void)path;
+    open_ = emulator_->IsConnected();
+    return open_;
+}
+
+void EmulatedTransport::Close() {
+    open_ = false;
+}
+
+bool EmulatedTransport::IsOpen() const {
+    return open_;
+}
+
+int EmulatedTransport::Read(unsigned char* buffer, size_t size, int timeout_ms) {
+    return open_ ? emulator_->Read(buffer, size, timeout_ms) : READ_ERROR;
+}
+
+bool EmulatedTransport::Write(const unsigned char* buffer, size_t size) {
+    return open_ && emulator_->Write(buffer, size);
+}
+
+bool EmulatedTransport::GetFeature(unsigned char* buffer, size_t size) {
+    return open_ && emulator_->GetFeature(buffer, size);
+}
+
+void EmulatedTransport::Flush() {
+    if (open_) {
+        emulator_->Flush();
+    }
+}
+
+bool EmulatedTransport::Ping() {
+    return open_ && emulator_->IsConnected();
+}
+
+} // namespace hid
+} // namespace dualsense
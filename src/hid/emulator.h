@@ -0,0 +1,114 @@
+// Software Controller Emulator
+// In-process model of a DualSense / DualShock 4 that produces input reports
+// from scripted state, validates output reports and injects faults, plus the
+// transport that connects it to a Device.
+
+#pragma once
+
+#include "transport.h"
+#include "../protocol/input_parser.h"
+#include "../protocol/output_composer.h"
+#include "../../include/dualsense.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace dualsense {
+namespace hid {
+
+// Reports an emulator queues before the oldest is overwritten (like hidraw)
+constexpr uint64_t EMULATOR_QUEUE_DEPTH = 64;
+
+// Sensor clock rate used when reports are unpaced
+constexpr uint32_t EMULATOR_NOMINAL_RATE_HZ = 1000;
+
+// Controller model shared by the application (input, faults, stats) and the
+// transport reading from it. All methods are thread-safe.
+class ControllerEmulator {
+public:
+    // config must name a supported model and connection
+    explicit ControllerEmulator(const DSEmulatorConfig& config);
+
+    static bool IsValidConfig(const DSEmulatorConfig& config);
+
+    // Application side
+    void SetInput(const DSInputState& state);
+    bool PlayScript(const DSEmulatorStep* steps, uint32_t count, bool loop);
+    void Disconnect();
+    void GetStats(DSEmulatorStats* out_stats) const;
+    size_t GetLastOutput(unsigned char* buffer, size_t size) const;
+
+    // Transport side (same contract as hid::Transport)
+    bool IsConnected() const { return connected_; }
+    int Read(unsigned char* buffer, size_t size, int timeout_ms);
+    bool Write(const unsigned char* buffer, size_t size);
+    bool GetFeature(unsigned char* buffer, size_t size);
+    void Flush();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Advance the model by one report (mutex_ held); false once disconnected
+    bool Step();
+
+    // Make state the current input and convert its motion to raw (mutex_ held)
+    void LoadState(const DSInputState& state);
+
+    // Report due time (only meaningful when paced)
+    Clock::time_point DueTime(uint64_t report) const;
+
+    // True with the given probability (xorshift32, mutex_ held)
+    bool Chance(uint32_t per_million);
+
+    bool CheckCRC(const unsigned char* buffer, size_t size) const;
+
+    const DSEmulatorConfig config_;
+    const protocol::InputFormat* input_format_;
+    const protocol::OutputFormat* output_format_;
+    std::chrono::nanoseconds period_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> connected_{true};
+
+    // Model state (mutex_ held)
+    DSInputState state_ = {};
+    protocol::RawMotion motion_ = {};
+    std::vector<DSEmulatorStep> script_;
+    size_t script_step_ = 0;
+    uint32_t script_left_ = 0;
+    bool script_loop_ = false;
+    uint64_t next_report_ = 0;      // Index of the next report the model produces
+    Clock::time_point start_;
+    uint32_t rng_;
+
+    // Counters (mutex_ held) and the last valid output report
+    DSEmulatorStats stats_ = {};
+    unsigned char last_output_[protocol::HAPTIC_REPORT_SIZE] = {};
+    size_t last_output_size_ = 0;
+};
+
+// Transport over a shared emulator; Open fails once it has disconnected
+class EmulatedTransport : public Transport {
+public:
+    explicit EmulatedTransport(std::shared_ptr<ControllerEmulator> emulator) : emulator_(std::move(emulator)) {}
+
+    bool Open(const std::string& path) override;
+    void Close() override;
+    bool IsOpen() const override;
+    int Read(unsigned char* buffer, size_t size, int timeout_ms) override;
+    bool Write(const unsigned char* buffer, size_t size) override;
+    bool GetFeature(unsigned char* buffer, size_t size) override;
+    void Flush() override;
+    bool Ping() override;
+
+private:
+    std::shared_ptr<ControllerEmulator> emulator_;
+    bool open_ = false;
+};
+
+} // namespace hid
+} // namespace dualsense
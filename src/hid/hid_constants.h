@@ -74,9 +74,6 @@
 // Note: DSConnectionType, DSDeviceType, DSLedMic, DSLedPlayer, and DSLedBrightness
 // are defined in dualsense.h (public API header)
 
-// Internal device type constant (not exposed in public API)
-#define DS_DEVICE_DUALSHOCK4 2
-
 // ========================================
 // Trigger Effect Modes
 // ========================================
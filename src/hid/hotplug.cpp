@@ -0,0 +1,68 @@
+// HID Hotplug Sources (platform-independent parts)
+
+#include "hotplug.h"
+#include <algorithm>
+#include <thread>
+
+namespace dualsense {
+namespace hid {
+
+EnumerationHotplugSource::EnumerationHotplugSource(int interval_ms)
+    : interval_(interval_ms) {
+    // The first scan only records what is already there
+    std::vector<DeviceInfo> devices;
+    DetectDevices(devices);
+    for (const DeviceInfo& device : devices) {
+        known_paths_.push_back(device.path);
+    }
+    std::sort(known_paths_.begin(), known_paths_.end());
+    next_scan_ = std::chrono::steady_clock::now() + interval_;
+}
+
+bool EnumerationHotplugSource::WaitEvent(HotplugEvent* out_event, int timeout_ms) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+    while (pending_.empty()) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= next_scan_) {
+            Scan();
+            next_scan_ = now + interval_;
+            continue;
+        }
+        if (now >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_until(std::min(deadline, next_scan_));
+    }
+
+    *out_event = pending_.front();
+    pending_.pop_front();
+    return true;
+}
+
+void EnumerationHotplugSource::Scan() {
+    std::vector<DeviceInfo> devices;
+    DetectDevices(devices);
+
+    std::vector<std::string> paths;
+    for (const DeviceInfo& device : devices) {
+        paths.push_back(device.path);
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (const std::string& path : known_paths_) {
+        if (!std::binary_search(paths.begin(), paths.end(), path)) {
+            pending_.push_back({ false, path });
+        }
+    }
+    for (const std::string& path : paths) {
+        if (!std::binary_search(known_paths_.begin(), known_paths_.end(), path)) {
+            pending_.push_back({ true, path });
+        }
+    }
+
+    known_paths_.swap(paths);
+}
+
+} // namespace hid
+} // namespace dualsense
@@ -0,0 +1,51 @@
+// HID Hotplug Sources
+// Device add/remove notifications feeding the automatic reconnect watcher
+
+#pragma once
+
+#include "transport.h"
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dualsense {
+namespace hid {
+
+// A device node appeared or disappeared
+struct HotplugEvent {
+    bool added;
+    std::string path;   // Same form as DeviceInfo::path
+};
+
+// Source of hotplug events; consumed by one thread
+class HotplugSource {
+public:
+    virtual ~HotplugSource() = default;
+
+    // Wait up to timeout_ms for the next event. Returns false on timeout.
+    virtual bool WaitEvent(HotplugEvent* out_event, int timeout_ms) = 0;
+};
+
+// Portable fallback: re-enumerates periodically and reports the differences
+class EnumerationHotplugSource : public HotplugSource {
+public:
+    explicit EnumerationHotplugSource(int interval_ms);
+
+    bool WaitEvent(HotplugEvent* out_event, int timeout_ms) override;
+
+private:
+    void Scan();
+
+    std::chrono::milliseconds interval_;
+    std::chrono::steady_clock::time_point next_scan_;
+    std::vector<std::string> known_paths_;
+    std::deque<HotplugEvent> pending_;
+};
+
+// Create the native hotplug source for this platform (nullptr if unavailable)
+std::unique_ptr<HotplugSource> CreateHotplugSource();
+
+} // namespace hid
+} // namespace dualsense
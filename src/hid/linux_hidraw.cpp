@@ -0,0 +1,625 @@
+// Linux hidraw Communication Layer
+// Backend for /dev/hidraw* nodes using non-blocking fds and epoll
+
+#include "linux_hidraw.h"
+#include "capture.h"
+#include "hid_constants.h"
+#include "../../include/dualsense.h"
+#include <linux/hidraw.h>
+#include <linux/input.h>
+#include <linux/netlink.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Map a Sony product ID to DSDeviceType, or -1 if not a supported controller
+int ProductToDeviceType(uint16_t product_id) {
+    switch (product_id) {
+        case DUALSENSE_PRODUCT_ID:
+            return DS_DEVICE_DUALSENSE;
+        case DUALSENSE_EDGE_PRODUCT_ID:
+            return DS_DEVICE_DUALSENSE_EDGE;
+        case DUALSHOCK4_PRODUCT_ID:
+        case DUALSHOCK4_V2_PRODUCT_ID:
+            return DS_DEVICE_DUALSHOCK4;
+        default:
+            return -1;
+    }
+}
+
+// A hidraw node that sysfs identifies as a supported controller
+struct Candidate {
+    DeviceInfo info;
+    std::string instance;   // HID device name, e.g. "0005:054C:0CE6.0004"
+    bool verified;
+};
+
+// Controllers verified by earlier scans in this process
+// An entry is trusted while its node still belongs to the same HID device
+// instance; the kernel numbers instances per connection, so a replugged
+// controller (or a different device reusing the node) never matches.
+struct EnumerationCache {
+    std::mutex mutex;
+    std::vector<Candidate> devices;
+};
+
+EnumerationCache& GetEnumerationCache() {
+    static EnumerationCache cache;
+    return cache;
+}
+
+// Node number of "hidrawN" or ".../hidrawN"
+unsigned long HidrawNumber(const std::string& name) {
+    const size_t position = name.rfind("hidraw");
+    return (position == std::string::npos) ? 0 : strtoul(name.c_str() + position + 6, nullptr, 10);
+}
+
+// Numeric node order (hidraw2 before hidraw10)
+bool HidrawNodeLess(const std::string& a, const std::string& b) {
+    const unsigned long number_a = HidrawNumber(a);
+    const unsigned long number_b = HidrawNumber(b);
+    return (number_a != number_b) ? number_a < number_b : a < b;
+}
+
+// Identify a hidraw node from its sysfs link without opening it
+// /sys/class/hidraw/hidrawN -> ../../devices/.../BBBB:VVVV:PPPP.NNNN/hidraw/hidrawN;
+// the HID device name carries the same bus/vendor/product as HID_ID in its uevent.
+bool ReadSysfsCandidate(int sysfs_fd, const char* name, Candidate* out_candidate) {
+    char target[PATH_MAX];
+    const ssize_t length = readlinkat(sysfs_fd, name, target, sizeof(target) - 1);
+    if (length <= 0) {
+        return false;
+    }
+    target[length] = '\0';
+
+    // Nearest matching component from the end (PCI addresses look similar)
+    char* component = nullptr;
+    while (char* slash = strrchr(target, '/')) {
+        component = slash + 1;
+        unsigned int bus;
+        unsigned int vendor;
+        unsigned int product;
+        unsigned int sequence;
+        if (strlen(component) == 19 &&
+            sscanf(component, "%4x:%4x:%4x.%4x", &bus, &vendor, &product, &sequence) == 4) {
+            const int device_type = ProductToDeviceType(static_cast<uint16_t>(product));
+            if (vendor != SONY_VENDOR_ID || device_type < 0) {
+                return false;
+            }
+            out_candidate->info.device_type = device_type;
+            out_candidate->info.connection_type = (bus == BUS_BLUETOOTH) ? DS_CONNECTION_BLUETOOTH : DS_CONNECTION_USB;
+            out_candidate->instance = component;
+            return true;
+        }
+        *slash = '\0';
+    }
+    return false;
+}
+
+// The node can be opened by this process (permissions, not yet removed)
+bool VerifyCandidate(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    return true;
+}
+
+// Fallback without sysfs: open every node and ask the driver
+bool ProbeAllNodes(const std::string& dev_dir, std::vector<DeviceInfo>& out_devices) {
+    DIR* directory = opendir(dev_dir.c_str());
+    if (!directory) {
+        printf("HIDManager: Failed to open %s\n", dev_dir.c_str());
+        return false;
+    }
+
+    std::vector<std::string> candidates;
+    while (const dirent* entry = readdir(directory)) {
+        if (strncmp(entry->d_name, "hidraw", 6) == 0) {
+            candidates.push_back(dev_dir + "/" + entry->d_name);
+        }
+    }
+    closedir(directory);
+
+    // Keep enumeration order stable (hidraw0, hidraw1, ...)
+    std::sort(candidates.begin(), candidates.end(), HidrawNodeLess);
+
+    for (const auto& path : candidates) {
+        const int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        hidraw_devinfo info = {};
+        if (ioctl(fd, HIDIOCGRAWINFO, &info) == 0 &&
+            static_cast<uint16_t>(info.vendor) == SONY_VENDOR_ID) {
+
+            const int device_type = ProductToDeviceType(static_cast<uint16_t>(info.product));
+            if (device_type >= 0) {
+                DeviceInfo context = {};
+                context.path = path;
+                context.device_type = device_type;
+                context.connection_type = (info.bustype == BUS_BLUETOOTH)
+                    ? DS_CONNECTION_BLUETOOTH : DS_CONNECTION_USB;
+                out_devices.push_back(context);
+            }
+        }
+        close(fd);
+    }
+
+    return !out_devices.empty();
+}
+
+// Read-only private mapping of a whole file
+class MmapFile : public dualsense::hid::MappedFile {
+public:
+    MmapFile(void* data, size_t size) : data_(data), size_(size) {}
+    ~MmapFile() override { munmap(data_, size_); }
+
+    const unsigned char* GetData() const override { return static_cast<const unsigned char*>(data_); }
+    size_t GetSize() const override { return size_; }
+
+private:
+    void* data_;
+    size_t size_;
+};
+
+// Kernel uevent multicast group (udev's re-broadcast is group 2)
+constexpr unsigned int UEVENT_KERNEL_GROUP = 1;
+
+// Re-enumeration interval when netlink is unavailable (e.g. some containers)
+constexpr int HOTPLUG_POLL_INTERVAL_MS = 1000;
+
+} // anonymous namespace
+
+namespace dualsense {
+namespace hid {
+
+bool DetectDevices(std::vector<DeviceInfo>& out_devices) {
+    return DetectHidrawDevices("/sys/class/hidraw", "/dev", out_devices);
+}
+
+bool DetectHidrawDevices(const std::string& sysfs_dir, const std::string& dev_dir,
+                         std::vector<DeviceInfo>& out_devices) {
+    out_devices.clear();
+
+    DIR* directory = opendir(sysfs_dir.c_str());
+    if (!directory) {
+        return ProbeAllNodes(dev_dir, out_devices);
+    }
+
+    std::vector<std::string> names;
+    while (const dirent* entry = readdir(directory)) {
+        if (strncmp(entry->d_name, "hidraw", 6) == 0) {
+            names.push_back(entry->d_name);
+        }
+    }
+
+    // Keep enumeration order stable (hidraw0, hidraw1, ...)
+    std::sort(names.begin(), names.end(), HidrawNodeLess);
+
+    EnumerationCache& cache = GetEnumerationCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    // Filter by vendor/product from sysfs; only controllers are ever opened
+    std::vector<Candidate> candidates;
+    std::vector<size_t> unverified;
+    for (const std::string& name : names) {
+        Candidate candidate;
+        if (!ReadSysfsCandidate(dirfd(directory), name.c_str(), &candidate)) {
+            continue;
+        }
+        candidate.info.path = dev_dir + "/" + name;
+        candidate.verified = false;
+        for (const Candidate& entry : cache.devices) {
+            if (entry.info.path == candidate.info.path && entry.instance == candidate.instance) {
+                candidate.verified = true;
+                break;
+            }
+        }
+        if (!candidate.verified) {
+            unverified.push_back(candidates.size());
+        }
+        candidates.push_back(candidate);
+    }
+    closedir(directory);
+
+    // Open the new ones in parallel; a slow driver open should not add up
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < unverified.size(); i++) {
+        Candidate* candidate = &candidates[unverified[i]];
+        workers.emplace_back([candidate] { candidate->verified = VerifyCandidate(candidate->info.path); });
+    }
+    if (!unverified.empty()) {
+        Candidate& candidate = candidates[unverified[0]];
+        candidate.verified = VerifyCandidate(candidate.info.path);
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    bool changed = false;
+    std::vector<Candidate> verified;
+    for (const Candidate& candidate : candidates) {
+        if (candidate.verified) {
+            out_devices.push_back(candidate.info);
+            verified.push_back(candidate);
+        }
+    }
+    if (verified.size() != cache.devices.size()) {
+        changed = true;
+    }
+    for (size_t i = 0; !changed && i < verified.size(); i++) {
+        changed = verified[i].info.path != cache.devices[i].info.path ||
+                  verified[i].instance != cache.devices[i].instance;
+    }
+    if (changed) {
+        cache.devices.swap(verified);
+    }
+
+    return !out_devices.empty();
+}
+
+void ResetEnumerationCache() {
+    EnumerationCache& cache = GetEnumerationCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+
+    cache.devices.clear();
+}
+
+std::unique_ptr<Transport> CreateTransport() {
+    return std::unique_ptr<Transport>(new HidrawTransport());
+}
+
+std::string ReadUniqueId(const std::string& path) {
+    // /dev/hidrawN -> /sys/class/hidraw/hidrawN/device/uevent
+    const size_t slash = path.rfind('/');
+    const std::string uevent_path = "/sys/class/hidraw/" + path.substr(slash == std::string::npos ? 0 : slash + 1) +
+                                    "/device/uevent";
+    FILE* file = fopen(uevent_path.c_str(), "r");
+    if (!file) {
+        return std::string();
+    }
+
+    std::string unique_id;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "HID_UNIQ=", 9) == 0) {
+            unique_id = line + 9;
+            unique_id.erase(unique_id.find_last_not_of("\r\n") + 1);
+            break;
+        }
+    }
+    fclose(file);
+    return unique_id;
+}
+
+std::unique_ptr<MappedFile> MapFile(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat info = {};
+    void* data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    return std::unique_ptr<MappedFile>(new MmapFile(data, static_cast<size_t>(info.st_size)));
+}
+
+std::unique_ptr<Signal> CreateSignal() {
+    const int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        printf("HIDManager: Failed to create eventfd. Error: %s\n", strerror(errno));
+        return nullptr;
+    }
+    return std::unique_ptr<Signal>(new EventFdSignal(fd));
+}
+
+std::unique_ptr<HotplugSource> CreateHotplugSource() {
+    const int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd >= 0) {
+        sockaddr_nl address = {};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = UEVENT_KERNEL_GROUP;
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            return std::unique_ptr<HotplugSource>(new NetlinkHotplugSource(fd));
+        }
+        close(fd);
+    }
+
+    printf("HIDManager: uevent socket unavailable (%s), polling for devices\n", strerror(errno));
+    return std::unique_ptr<HotplugSource>(new EnumerationHotplugSource(HOTPLUG_POLL_INTERVAL_MS));
+}
+
+HidrawTransport::~HidrawTransport() {
+    Close();
+}
+
+bool HidrawTransport::Open(const std::string& path) {
+    Close();
+
+    fd_ = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        printf("HIDManager: Failed to open %s. Error: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        printf("HIDManager: Failed to create epoll set. Error: %s\n", strerror(errno));
+        Close();
+        return false;
+    }
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd_, &event) != 0) {
+        printf("HIDManager: Failed to register device with epoll. Error: %s\n", strerror(errno));
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void HidrawTransport::Close() {
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool HidrawTransport::IsOpen() const {
+    return fd_ >= 0;
+}
+
+int HidrawTransport::Read(unsigned char* buffer, size_t size, int timeout_ms) {
+    if (fd_ < 0) {
+        printf("HIDManager: Invalid device handle before attempting to read\n");
+        return READ_ERROR;
+    }
+
+    // A wake-up can find the queue empty again (e.g. Flush on another
+    // thread), so keep waiting until the report or the deadline
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+    for (;;) {
+        const ssize_t result = read(fd_, buffer, size);
+        if (result > 0) {
+            return static_cast<int>(result);
+        }
+        if (result == 0) {
+            return READ_ERROR;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            return READ_ERROR;
+        }
+
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            // Rounded up, so a sub-millisecond remainder still waits
+            const auto remaining = deadline - std::chrono::steady_clock::now();
+            const int64_t remaining_us = std::chrono::duration_cast<std::chrono::microseconds>(remaining).count();
+            if (remaining_us <= 0) {
+                return READ_TIMEOUT;
+            }
+            wait_ms = static_cast<int>((remaining_us + 999) / 1000);
+        }
+
+        epoll_event event = {};
+        const int ready = epoll_wait(epoll_fd_, &event, 1, wait_ms);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return READ_ERROR;
+        }
+        if (ready > 0 && (event.events & (EPOLLERR | EPOLLHUP))) {
+            return READ_ERROR;
+        }
+    }
+}
+
+bool HidrawTransport::Write(const unsigned char* buffer, size_t size) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    for (;;) {
+        const ssize_t result = write(fd_, buffer, size);
+        if (result == static_cast<ssize_t>(size)) {
+            return true;
+        }
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd pfd = { fd_, POLLOUT, 0 };
+            if (poll(&pfd, 1, 100) > 0 && !(pfd.revents & (POLLERR | POLLHUP))) {
+                continue;
+            }
+        }
+        printf("HIDManager: Failed to write output report. Size: %zu, Error: %s\n",
+               size, strerror(errno));
+        return false;
+    }
+}
+
+bool HidrawTransport::GetFeature(unsigned char* buffer, size_t size) {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    if (ioctl(fd_, HIDIOCGFEATURE(size), buffer) < 0) {
+        printf("HIDManager: Failed to get Feature 0x%02X. Error: %s\n", buffer[0], strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+void HidrawTransport::Flush() {
+    if (fd_ < 0) {
+        return;
+    }
+
+    unsigned char scratch[128];
+    while (read(fd_, scratch, sizeof(scratch)) > 0) {
+    }
+}
+
+bool HidrawTransport::Ping() {
+    if (fd_ < 0) {
+        return false;
+    }
+
+    hidraw_devinfo info = {};
+    return ioctl(fd_, HIDIOCGRAWINFO, &info) == 0;
+}
+
+EventFdSignal::~EventFdSignal() {
+    close(fd_);
+}
+
+void EventFdSignal::Notify() {
+    if (ready_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    const uint64_t one = 1;
+    ssize_t result;
+    do {
+        result = write(fd_, &one, sizeof(one));
+    } while (result < 0 && errno == EINTR);
+}
+
+bool EventFdSignal::Wait(int64_t timeout_us) {
+    pollfd entry = {};
+    entry.fd = fd_;
+    entry.events = POLLIN;
+
+    timespec timeout = {};
+    timeout.tv_sec = static_cast<time_t>(timeout_us / 1000000);
+    timeout.tv_nsec = static_cast<long>((timeout_us % 1000000) * 1000);
+
+    for (;;) {
+        const int ready = ppoll(&entry, 1, (timeout_us < 0) ? nullptr : &timeout, nullptr);
+        if (ready > 0) {
+            break;
+        }
+        if (ready == 0 || errno != EINTR) {
+            return false;
+        }
+    }
+
+    // Drain before clearing the flag: a Notify in between is skipped, which
+    // is harmless because the caller reads the newest state after this returns
+    uint64_t count;
+    while (read(fd_, &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+    ready_.store(false, std::memory_order_release);
+    return true;
+}
+
+intptr_t EventFdSignal::GetNativeHandle() const {
+    return static_cast<intptr_t>(fd_);
+}
+
+NetlinkHotplugSource::~NetlinkHotplugSource() {
+    close(fd_);
+}
+
+bool NetlinkHotplugSource::WaitEvent(HotplugEvent* out_event, int timeout_ms) {
+    char message[8192];
+
+    for (;;) {
+        const ssize_t length = recv(fd_, message, sizeof(message) - 1, 0);
+        if (length < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+
+            // One wait per call; the caller loops on timeouts
+            pollfd entry = {};
+            entry.fd = fd_;
+            entry.events = POLLIN;
+            const int ready = poll(&entry, 1, timeout_ms);
+            if (ready <= 0) {
+                return false;
+            }
+            timeout_ms = 0;
+            continue;
+        }
+        message[length] = '\0';
+
+        // "ACTION@DEVPATH\0KEY=VALUE\0KEY=VALUE\0..."
+        const char* action = nullptr;
+        const char* subsystem = nullptr;
+        const char* devname = nullptr;
+        for (ssize_t offset = static_cast<ssize_t>(strlen(message)) + 1; offset < length;
+             offset += static_cast<ssize_t>(strlen(message + offset)) + 1) {
+            const char* field = message + offset;
+            if (strncmp(field, "ACTION=", 7) == 0) {
+                action = field + 7;
+            }
+            else if (strncmp(field, "SUBSYSTEM=", 10) == 0) {
+                subsystem = field + 10;
+            }
+            else if (strncmp(field, "DEVNAME=", 8) == 0) {
+                devname = field + 8;
+            }
+        }
+
+        if (!action || !subsystem || !devname || strcmp(subsystem, "hidraw") != 0) {
+            continue;
+        }
+
+        const bool added = strcmp(action, "add") == 0;
+        if (!added && strcmp(action, "remove") != 0) {
+            continue;
+        }
+
+        // DEVNAME is relative to /dev (e.g. "hidraw3")
+        out_event->added = added;
+        out_event->path = (devname[0] == '/') ? std::string(devname) : std::string("/dev/") + devname;
+        return true;
+    }
+}
+
+} // namespace hid
+} // namespace dualsense
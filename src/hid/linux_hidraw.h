@@ -0,0 +1,69 @@
+// Linux hidraw Communication Layer
+// Backend for /dev/hidraw* nodes using non-blocking fds and epoll
+
+#pragma once
+
+#include "hotplug.h"
+#include "transport.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace dualsense {
+namespace hid {
+
+// DetectDevices on an explicit sysfs class directory and device directory
+// (/sys/class/hidraw and /dev); other roots are for benchmarks and tools
+bool DetectHidrawDevices(const std::string& sysfs_dir, const std::string& dev_dir,
+                         std::vector<DeviceInfo>& out_devices);
+
+// Linux hidraw transport
+// The fd is non-blocking; Read waits for readiness on a private epoll set.
+class HidrawTransport : public Transport {
+public:
+    HidrawTransport() = default;
+    ~HidrawTransport() override;
+
+    bool Open(const std::string& path) override;
+    void Close() override;
+    bool IsOpen() const override;
+    int Read(unsigned char* buffer, size_t size, int timeout_ms) override;
+    bool Write(const unsigned char* buffer, size_t size) override;
+    bool GetFeature(unsigned char* buffer, size_t size) override;
+    void Flush() override;
+    bool Ping() override;
+
+private:
+    int fd_ = -1;
+    int epoll_fd_ = -1;
+};
+
+// eventfd-backed signal; ready_ skips the write while already signaled
+class EventFdSignal : public Signal {
+public:
+    explicit EventFdSignal(int fd) : fd_(fd) {}
+    ~EventFdSignal() override;
+
+    void Notify() override;
+    bool Wait(int64_t timeout_us) override;
+    intptr_t GetNativeHandle() const override;
+
+private:
+    int fd_;
+    std::atomic<bool> ready_{false};
+};
+
+// Kernel uevents over NETLINK_KOBJECT_UEVENT, filtered to hidraw nodes
+class NetlinkHotplugSource : public HotplugSource {
+public:
+    explicit NetlinkHotplugSource(int fd) : fd_(fd) {}
+    ~NetlinkHotplugSource() override;
+
+    bool WaitEvent(HotplugEvent* out_event, int timeout_ms) override;
+
+private:
+    int fd_;
+};
+
+} // namespace hid
+} // namespace dualsense
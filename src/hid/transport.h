@@ -0,0 +1,96 @@
+// HID Transport Interface
+// Platform-independent access to a single HID device (open/read/write/feature/close)
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Device discovered during enumeration
+struct DeviceInfo {
+    std::string path;       // Platform device path (UTF-8)
+    int device_type;        // DSDeviceType
+    int connection_type;    // DSConnectionType
+};
+
+namespace dualsense {
+namespace hid {
+
+// Result of Transport::Read when no report arrived before the timeout
+constexpr int READ_TIMEOUT = 0;
+
+// Result of Transport::Read on I/O failure
+constexpr int READ_ERROR = -1;
+
+// Abstract HID transport
+// One instance owns one open device. Read and Write may be called
+// concurrently from different threads; Open and Close may not.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    // Open device by path
+    virtual bool Open(const std::string& path) = 0;
+
+    // Close device (safe to call when not open)
+    virtual void Close() = 0;
+
+    // Check whether a device is currently open
+    virtual bool IsOpen() const = 0;
+
+    // Read one input report
+    // timeout_ms < 0 blocks, 0 polls. Returns bytes read, READ_TIMEOUT or READ_ERROR.
+    virtual int Read(unsigned char* buffer, size_t size, int timeout_ms) = 0;
+
+    // Write output report
+    virtual bool Write(const unsigned char* buffer, size_t size) = 0;
+
+    // Get feature report (buffer[0] holds the report ID)
+    virtual bool GetFeature(unsigned char* buffer, size_t size) = 0;
+
+    // Discard any input reports queued by the OS
+    virtual void Flush() = 0;
+
+    // Ping device to check connection status
+    virtual bool Ping() = 0;
+};
+
+// Waitable notification that an application can also watch in its own
+// event loop (eventfd on Linux, manual-reset event on Windows)
+class Signal {
+public:
+    virtual ~Signal() = default;
+
+    // Make the signal ready (any thread; no system call if already ready)
+    virtual void Notify() = 0;
+
+    // Wait until ready, then clear it. timeout_us < 0 blocks, 0 polls.
+    // Returns false on timeout.
+    virtual bool Wait(int64_t timeout_us) = 0;
+
+    // fd (Linux) or HANDLE (Windows) that is readable/signaled while ready
+    virtual intptr_t GetNativeHandle() const = 0;
+};
+
+// Detect all connected DualSense devices (platform backend)
+bool DetectDevices(std::vector<DeviceInfo>& out_devices);
+
+// Forget controllers remembered by earlier scans in this process, so the
+// next DetectDevices probes every candidate again
+void ResetEnumerationCache();
+
+// Create the native transport for this platform
+std::unique_ptr<Transport> CreateTransport();
+
+// Unique ID the OS reports for a device path (Bluetooth address or serial
+// number, as HID_UNIQ on Linux); empty if there is none
+std::string ReadUniqueId(const std::string& path);
+
+// Create the native signal for this platform (nullptr on failure)
+std::unique_ptr<Signal> CreateSignal();
+
+} // namespace hid
+} // namespace dualsense
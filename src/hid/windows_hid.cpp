@@ -3,13 +3,60 @@
 // Ref: https://github.com/rafaelvaloto/WindowsDualsenseUnreal
 
 #include "windows_hid.h"
+#include "capture.h"
 #include "hid_constants.h"
+#include "hotplug.h"
 #include "../../include/dualsense.h"
 #include <hidsdi.h>
 #include <setupapi.h>
 #include <cstdio>
 #include <cstring>
 
+namespace {
+
+std::string NarrowPath(const wchar_t* path) {
+    const int size = WideCharToMultiByte(CP_UTF8, 0, path, -1, nullptr, 0, nullptr, nullptr);
+    if (size <= 1) {
+        return std::string();
+    }
+    std::string result(static_cast<size_t>(size - 1), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, path, -1, &result[0], size, nullptr, nullptr);
+    return result;
+}
+
+std::wstring WidenPath(const std::string& path) {
+    const int size = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (size <= 1) {
+        return std::wstring();
+    }
+    std::wstring result(static_cast<size_t>(size - 1), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &result[0], size);
+    return result;
+}
+
+// Read-only view of a whole file
+class ViewOfFile : public dualsense::hid::MappedFile {
+public:
+    ViewOfFile(HANDLE mapping, const void* data, size_t size) : mapping_(mapping), data_(data), size_(size) {}
+    ~ViewOfFile() override {
+        UnmapViewOfFile(data_);
+        CloseHandle(mapping_);
+    }
+
+    const unsigned char* GetData() const override { return static_cast<const unsigned char*>(data_); }
+    size_t GetSize() const override { return size_; }
+
+private:
+    HANDLE mapping_;
+    const void* data_;
+    size_t size_;
+};
+
+// Re-enumeration interval of the hotplug source
+constexpr int HOTPLUG_POLL_INTERVAL_MS = 1000;
+
+} // anonymous namespace
+
 namespace dualsense {
 namespace hid {
 
@@ -85,7 +132,7 @@ bool DetectDevices(std::vector<DeviceInfo>& out_devices) {
 
                             if (!already_added) {
                                 DeviceInfo context = {};
-                                context.path = path_str;
+                                context.path = NarrowPath(path_str.c_str());
                                 device_paths.push_back(path_str);
 
                                 // Determine device type
@@ -107,11 +154,6 @@ bool DetectDevices(std::vector<DeviceInfo>& out_devices) {
                                     path_str.find(L"bth") != std::wstring::npos ||
                                     path_str.find(L"BTHENUM") != std::wstring::npos) {
                                     context.connection_type = DS_CONNECTION_BLUETOOTH;
-
-                                    // Configure Bluetooth features
-                                    if (!ConfigureBluetoothFeatures(temp_device_handle)) {
-                                        printf("HIDManager: Warning - Failed to configure Bluetooth features\n");
-                                    }
                                 }
 
                                 out_devices.push_back(context);
@@ -132,115 +174,236 @@ bool DetectDevices(std::vector<DeviceInfo>& out_devices) {
     return !out_devices.empty();
 }
 
-HANDLE OpenDevice(const std::wstring& path) {
-    HANDLE device_handle = CreateFileW(
-        path.c_str(),
+std::string ReadUniqueId(const std::string& path) {
+    // No access rights needed for the HID strings
+    const HANDLE handle = CreateFileW(WidenPath(path).c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                      nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return std::string();
+    }
+
+    WCHAR serial[128] = {};
+    const bool found = HidD_GetSerialNumberString(handle, serial, sizeof(serial)) != FALSE;
+    CloseHandle(handle);
+    return found ? NarrowPath(serial) : std::string();
+}
+
+void ResetEnumerationCache() {
+    // Windows enumeration is not cached
+}
+
+std::unique_ptr<Transport> CreateTransport() {
+    return std::unique_ptr<Transport>(new WindowsTransport());
+}
+
+std::unique_ptr<MappedFile> MapFile(const std::string& path) {
+    const HANDLE file = CreateFileW(WidenPath(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+
+    LARGE_INTEGER size = {};
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(file);
+    if (!mapping) {
+        return nullptr;
+    }
+
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    return std::unique_ptr<MappedFile>(new ViewOfFile(mapping, data, static_cast<size_t>(size.QuadPart)));
+}
+
+std::unique_ptr<Signal> CreateSignal() {
+    HANDLE event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!event) {
+        printf("HIDManager: Failed to create event. Error: %lu\n", GetLastError());
+        return nullptr;
+    }
+    return std::unique_ptr<Signal>(new EventSignal(event));
+}
+
+std::unique_ptr<HotplugSource> CreateHotplugSource() {
+    // Device notifications need a window or a service handle; a short
+    // enumeration poll serves a library without either
+    return std::unique_ptr<HotplugSource>(new EnumerationHotplugSource(HOTPLUG_POLL_INTERVAL_MS));
+}
+
+WindowsTransport::~WindowsTransport() {
+    Close();
+}
+
+bool WindowsTransport::Open(const std::string& path) {
+    Close();
+
+    handle_ = CreateFileW(
+        WidenPath(path).c_str(),
         GENERIC_READ | GENERIC_WRITE,
         FILE_SHARE_READ | FILE_SHARE_WRITE,
         nullptr,
         OPEN_EXISTING,
-        NULL,
+        FILE_FLAG_OVERLAPPED,
         nullptr);
 
-    if (device_handle == INVALID_HANDLE_VALUE) {
+    if (handle_ == INVALID_HANDLE_VALUE) {
         printf("HIDManager: Failed to open device handle. Error: %lu\n", GetLastError());
-        return INVALID_HANDLE_VALUE;
+        return false;
     }
 
-    return device_handle;
+    read_event_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    write_event_ = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!read_event_ || !write_event_) {
+        printf("HIDManager: Failed to create I/O events. Error: %lu\n", GetLastError());
+        Close();
+        return false;
+    }
+
+    return true;
 }
 
-void CloseDevice(HANDLE handle) {
-    if (handle != INVALID_HANDLE_VALUE) {
-        CloseHandle(handle);
+void WindowsTransport::Close() {
+    if (handle_ != INVALID_HANDLE_VALUE) {
+        CancelIoEx(handle_, nullptr);
+        CloseHandle(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+    }
+    if (read_event_) {
+        CloseHandle(read_event_);
+        read_event_ = nullptr;
+    }
+    if (write_event_) {
+        CloseHandle(write_event_);
+        write_event_ = nullptr;
     }
 }
 
-bool ReadInputReport(HANDLE handle, unsigned char* buffer, size_t size, unsigned long* bytes_read) {
-    if (handle == INVALID_HANDLE_VALUE) {
+bool WindowsTransport::IsOpen() const {
+    return handle_ != INVALID_HANDLE_VALUE;
+}
+
+int WindowsTransport::Read(unsigned char* buffer, size_t size, int timeout_ms) {
+    if (handle_ == INVALID_HANDLE_VALUE) {
         printf("HIDManager: Invalid device handle before attempting to read\n");
-        return false;
+        return READ_ERROR;
     }
 
-    // Flush any old data
-    HidD_FlushQueue(handle);
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = read_event_;
+    ResetEvent(read_event_);
 
     DWORD read = 0;
-    if (!ReadFile(handle, buffer, static_cast<DWORD>(size), &read, nullptr)) {
-        if (bytes_read) *bytes_read = 0;
-        return false;
+    if (!ReadFile(handle_, buffer, static_cast<DWORD>(size), &read, &overlapped)) {
+        if (GetLastError() != ERROR_IO_PENDING) {
+            return READ_ERROR;
+        }
+
+        const DWORD wait = WaitForSingleObject(read_event_,
+            (timeout_ms < 0) ? INFINITE : static_cast<DWORD>(timeout_ms));
+
+        if (wait == WAIT_TIMEOUT) {
+            // The read may still complete between the timeout and the cancel
+            CancelIoEx(handle_, &overlapped);
+            if (!GetOverlappedResult(handle_, &overlapped, &read, TRUE)) {
+                return (GetLastError() == ERROR_OPERATION_ABORTED) ? READ_TIMEOUT : READ_ERROR;
+            }
+            return static_cast<int>(read);
+        }
+
+        if (wait != WAIT_OBJECT_0 || !GetOverlappedResult(handle_, &overlapped, &read, FALSE)) {
+            return READ_ERROR;
+        }
     }
 
-    if (bytes_read) *bytes_read = read;
-    return true;
+    return static_cast<int>(read);
 }
 
-bool WriteOutputReport(HANDLE handle, const unsigned char* buffer, size_t size) {
-    if (handle == INVALID_HANDLE_VALUE) {
+bool WindowsTransport::Write(const unsigned char* buffer, size_t size) {
+    if (handle_ == INVALID_HANDLE_VALUE) {
         return false;
     }
 
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = write_event_;
+    ResetEvent(write_event_);
+
     DWORD bytes_written = 0;
-    if (!WriteFile(handle, buffer, static_cast<DWORD>(size), &bytes_written, nullptr)) {
-        printf("HIDManager: Failed to write output report. Size: %zu, Error: %lu\n",
-               size, GetLastError());
-        return false;
+    if (!WriteFile(handle_, buffer, static_cast<DWORD>(size), &bytes_written, &overlapped)) {
+        if (GetLastError() != ERROR_IO_PENDING ||
+            !GetOverlappedResult(handle_, &overlapped, &bytes_written, TRUE)) {
+            printf("HIDManager: Failed to write output report. Size: %zu, Error: %lu\n",
+                   size, GetLastError());
+            return false;
+        }
     }
 
     return true;
 }
 
-bool PingDevice(HANDLE handle) {
-    if (handle == INVALID_HANDLE_VALUE) {
+bool WindowsTransport::GetFeature(unsigned char* buffer, size_t size) {
+    if (handle_ == INVALID_HANDLE_VALUE) {
         return false;
     }
 
-    FILE_STANDARD_INFO info{};
-    if (!GetFileInformationByHandleEx(handle, FileStandardInfo, &info, sizeof(info))) {
+    if (!HidD_GetFeature(handle_, buffer, static_cast<ULONG>(size))) {
+        printf("HIDManager: Failed to get Feature 0x%02X. Error: %lu\n", buffer[0], GetLastError());
         return false;
     }
 
     return true;
 }
 
-bool ConfigureBluetoothFeatures(HANDLE device_handle) {
-    // Feature Report 0x05 - Enables advanced Bluetooth features
-    unsigned char feature_buffer[41];
-    memset(feature_buffer, 0, sizeof(feature_buffer));
-    feature_buffer[0] = 0x05;
+void WindowsTransport::Flush() {
+    if (handle_ != INVALID_HANDLE_VALUE) {
+        HidD_FlushQueue(handle_);
+    }
+}
 
-    if (!HidD_GetFeature(device_handle, feature_buffer, 41)) {
-        const DWORD error = GetLastError();
-        printf("HIDManager: Failed to get Feature 0x05. Error: %lu\n", error);
+bool WindowsTransport::Ping() {
+    if (handle_ == INVALID_HANDLE_VALUE) {
         return false;
     }
 
-    return true;
-}
-
-bool WriteAudioHaptic(HANDLE handle, const unsigned char* buffer, size_t size) {
-    if (!handle || handle == INVALID_HANDLE_VALUE) {
+    FILE_STANDARD_INFO info{};
+    if (!GetFileInformationByHandleEx(handle_, FileStandardInfo, &info, sizeof(info))) {
         return false;
     }
 
-    DWORD bytes_written = 0;
-    constexpr size_t expected_size = 142;
+    return true;
+}
+
+EventSignal::~EventSignal() {
+    CloseHandle(event_);
+}
 
-    if (size != expected_size) {
-        printf("HIDManager: Warning - Audio haptic buffer size is %zu, expected %zu\n",
-               size, expected_size);
+void EventSignal::Notify() {
+    if (!ready_.exchange(true, std::memory_order_acq_rel)) {
+        SetEvent(event_);
     }
+}
 
-    if (!WriteFile(handle, buffer, static_cast<DWORD>(size), &bytes_written, nullptr)) {
-        const DWORD error = GetLastError();
-        if (error != ERROR_IO_PENDING) {
-            printf("HIDManager: Failed to send audio haptics. Error: %lu\n", error);
-        }
+bool EventSignal::Wait(int64_t timeout_us) {
+    // Millisecond resolution: round up so a short timeout still waits
+    const DWORD timeout_ms = (timeout_us < 0) ? INFINITE : static_cast<DWORD>((timeout_us + 999) / 1000);
+    if (WaitForSingleObject(event_, timeout_ms) != WAIT_OBJECT_0) {
         return false;
     }
 
+    // Same ordering as the eventfd version: reset the event, then the flag
+    ResetEvent(event_);
+    ready_.store(false, std::memory_order_release);
     return true;
 }
 
+intptr_t EventSignal::GetNativeHandle() const {
+    return reinterpret_cast<intptr_t>(event_);
+}
+
 } // namespace hid
 } // namespace dualsense
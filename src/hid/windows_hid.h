@@ -4,43 +4,49 @@
 
 #pragma once
 
+#include "transport.h"
 #include <Windows.h>
-#include <string>
-#include <vector>
-
-// Forward declarations
-struct DeviceInfo {
-    std::wstring path;
-    int device_type;        // DSDeviceType
-    int connection_type;    // DSConnectionType
-};
+#include <atomic>
 
 namespace dualsense {
 namespace hid {
 
-// Detect all connected DualSense devices
-bool DetectDevices(std::vector<DeviceInfo>& out_devices);
-
-// Open device handle
-HANDLE OpenDevice(const std::wstring& path);
-
-// Close device handle
-void CloseDevice(HANDLE handle);
-
-// Read input report from device
-bool ReadInputReport(HANDLE handle, unsigned char* buffer, size_t size, unsigned long* bytes_read);
-
-// Write output report to device
-bool WriteOutputReport(HANDLE handle, const unsigned char* buffer, size_t size);
+// Windows HID transport (CreateFileW/ReadFile/WriteFile/HidD_*)
+// The handle is opened for overlapped I/O so reads can time out.
+class WindowsTransport : public Transport {
+public:
+    WindowsTransport() = default;
+    ~WindowsTransport() override;
+
+    bool Open(const std::string& path) override;
+    void Close() override;
+    bool IsOpen() const override;
+    int Read(unsigned char* buffer, size_t size, int timeout_ms) override;
+    bool Write(const unsigned char* buffer, size_t size) override;
+    bool GetFeature(unsigned char* buffer, size_t size) override;
+    void Flush() override;
+    bool Ping() override;
+
+private:
+    HANDLE handle_ = INVALID_HANDLE_VALUE;
+    HANDLE read_event_ = nullptr;
+    HANDLE write_event_ = nullptr;
+};
 
-// Ping device to check connection status
-bool PingDevice(HANDLE handle);
+// Manual-reset event signal; ready_ skips SetEvent while already signaled
+class EventSignal : public Signal {
+public:
+    explicit EventSignal(HANDLE event) : event_(event) {}
+    ~EventSignal() override;
 
-// Configure Bluetooth features (feature report 0x05)
-bool ConfigureBluetoothFeatures(HANDLE handle);
+    void Notify() override;
+    bool Wait(int64_t timeout_us) override;
+    intptr_t GetNativeHandle() const override;
 
-// Write audio haptic data (Bluetooth only)
-bool WriteAudioHaptic(HANDLE handle, const unsigned char* buffer, size_t size);
+private:
+    HANDLE event_;
+    std::atomic<bool> ready_{false};
+};
 
 } // namespace hid
 } // namespace dualsense
@@ -0,0 +1,277 @@
+// CRC32 Implementation for DualSense Bluetooth Protocol
+// Slice-by-16, PCLMULQDQ folding and ARMv8 CRC32 variants with runtime dispatch.
+// Folding constants: "Fast CRC Computation for Generic Polynomials Using
+// PCLMULQDQ Instruction" (Intel), as used by zlib/Chromium crc32_simd.c.
+//
+// All variants run the standard reflected CRC32 on the complemented value:
+// CRC_TABLE[i] == STANDARD[i ^ 0xFF] ^ 0xFF000000, so the DualSense result
+// for seed s equals ~crc32_update(~s, data).
+
+#include "crc32.h"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DS_CRC32_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#define DS_CRC32_ARMV8 1
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+
+namespace dualsense {
+namespace protocol {
+
+namespace {
+
+// Reflected CRC32 polynomial
+constexpr uint32_t CRC32_POLY = 0xEDB88320;
+
+// SLICE_TABLES[k][i]: CRC of byte i followed by k zero bytes
+constexpr std::array<std::array<uint32_t, 256>, 16> MakeSliceTables() {
+    std::array<std::array<uint32_t, 256>, 16> tables{};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLY : (crc >> 1);
+        }
+        tables[0][i] = crc;
+    }
+    for (size_t k = 1; k < 16; k++) {
+        for (size_t i = 0; i < 256; i++) {
+            const uint32_t prev = tables[k - 1][i];
+            tables[k][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr std::array<std::array<uint32_t, 256>, 16> SLICE_TABLES = MakeSliceTables();
+
+static_assert((SLICE_TABLES[0][0x00] ^ 0xFF000000u) == CRC_TABLE[0xFF], "CRC_TABLE is not the complemented standard table");
+static_assert((SLICE_TABLES[0][0xFF] ^ 0xFF000000u) == CRC_TABLE[0x00], "CRC_TABLE is not the complemented standard table");
+static_assert((SLICE_TABLES[0][0xE5] ^ 0xFF000000u) == CRC_TABLE[0x1A], "CRC_TABLE is not the complemented standard table");
+
+// Standard CRC32 update (crc is the running, non-inverted register)
+uint32_t UpdateSlice16(uint32_t crc, const unsigned char* data, size_t length) {
+    const auto& t = SLICE_TABLES;
+
+    while (length >= 16) {
+        crc = t[15][data[0] ^ (crc & 0xFF)] ^
+              t[14][data[1] ^ ((crc >> 8) & 0xFF)] ^
+              t[13][data[2] ^ ((crc >> 16) & 0xFF)] ^
+              t[12][data[3] ^ (crc >> 24)] ^
+              t[11][data[4]] ^ t[10][data[5]] ^ t[9][data[6]] ^ t[8][data[7]] ^
+              t[7][data[8]] ^ t[6][data[9]] ^ t[5][data[10]] ^ t[4][data[11]] ^
+              t[3][data[12]] ^ t[2][data[13]] ^ t[1][data[14]] ^ t[0][data[15]];
+        data += 16;
+        length -= 16;
+    }
+
+    while (length--) {
+        crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#ifdef DS_CRC32_X86
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DS_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#else
+#define DS_TARGET_PCLMUL
+#endif
+
+// Fold length bytes (length >= 64, multiple of 16) with carry-less multiplies
+DS_TARGET_PCLMUL
+uint32_t FoldPclmul(uint32_t crc, const unsigned char* data, size_t length) {
+    alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+    alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+    alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+    alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+    x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+    x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+    data += 64;
+    length -= 64;
+
+    // Fold four 128-bit lanes in parallel
+    while (length >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30)));
+
+        data += 64;
+        length -= 64;
+    }
+
+    // Fold the four lanes into one
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // Remaining 16-byte blocks
+    while (length >= 16) {
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        data += 16;
+        length -= 16;
+    }
+
+    // 128 -> 64 bits
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+uint32_t UpdatePclmul(uint32_t crc, const unsigned char* data, size_t length) {
+    // Folding needs at least one 64-byte block; 74/138-byte reports fold 64/128
+    if (length >= 64) {
+        const size_t folded = length & ~static_cast<size_t>(15);
+        crc = FoldPclmul(crc, data, folded);
+        data += folded;
+        length -= folded;
+    }
+    return UpdateSlice16(crc, data, length);
+}
+
+bool HasPclmul() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) && (info[2] & (1 << 19));    // PCLMULQDQ, SSE4.1
+#else
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+#endif // DS_CRC32_X86
+
+#ifdef DS_CRC32_ARMV8
+
+#if defined(__clang__)
+#define DS_TARGET_CRC __attribute__((target("crc")))
+#else
+#define DS_TARGET_CRC __attribute__((target("+crc")))
+#endif
+
+DS_TARGET_CRC
+uint32_t UpdateArmv8(uint32_t crc, const unsigned char* data, size_t length) {
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32d(crc, word);
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = __crc32b(crc, *data++);
+    }
+    return crc;
+}
+
+bool HasArmv8Crc() {
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+#endif // DS_CRC32_ARMV8
+
+using CRC32Update = uint32_t (*)(uint32_t crc, const unsigned char* data, size_t length);
+
+struct CRC32Implementation {
+    CRC32Update update;
+    const char* name;
+};
+
+CRC32Implementation DetectImplementation() {
+#ifdef DS_CRC32_X86
+    if (HasPclmul()) {
+        return { &UpdatePclmul, "pclmul" };
+    }
+#endif
+#ifdef DS_CRC32_ARMV8
+    if (HasArmv8Crc()) {
+        return { &UpdateArmv8, "armv8" };
+    }
+#endif
+    return { &UpdateSlice16, "slice16" };
+}
+
+const CRC32Implementation& SelectedImplementation() {
+    static const CRC32Implementation selected = DetectImplementation();
+    return selected;
+}
+
+} // anonymous namespace
+
+uint32_t ComputeCRC32Slice16(const unsigned char* buffer, size_t length, uint32_t seed) {
+    return ~UpdateSlice16(~seed, buffer, length);
+}
+
+uint32_t ComputeCRC32(const unsigned char* buffer, size_t length, uint32_t seed) {
+    return ~SelectedImplementation().update(~seed, buffer, length);
+}
+
+const char* GetCRC32Implementation() {
+    return SelectedImplementation().name;
+}
+
+} // namespace protocol
+} // namespace dualsense
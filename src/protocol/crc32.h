@@ -1,6 +1,9 @@
 // CRC32 Implementation for DualSense Bluetooth Protocol
 // Migrated from PlayStationOutputComposer.cpp (lines 240-282)
 // Ref: https://github.com/rafaelvaloto/WindowsDualsenseUnreal
+//
+// This is the standard reflected CRC32 (poly 0xEDB88320) with the report
+// prefix byte (0xA2 output / 0xA1 input) folded into the seed.
 
 #pragma once
 
@@ -13,6 +16,9 @@ namespace protocol {
 // CRC32 seed value used by DualSense
 constexpr uint32_t CRC_SEED = 0xeada2d49;
 
+// CRC32 seed value for Bluetooth input reports (0xA1 prefix)
+constexpr uint32_t CRC_SEED_INPUT = 0x73d37cf3;
+
 // CRC32 hash table (256 entries)
 constexpr uint32_t CRC_TABLE[256] = {
     0xd202ef8d, 0xa505df1b, 0x3c0c8ea1, 0x4b0bbe37, 0xd56f2b94, 0xa2681b02, 0x3b614ab8, 0x4c667a2e,
@@ -49,14 +55,25 @@ constexpr uint32_t CRC_TABLE[256] = {
     0x616495a3, 0x1663a535, 0x8f6af48f, 0xf86dc419, 0x660951ba, 0x110e612c, 0x88073096, 0xFF000000
 };
 
-// Compute CRC32 checksum for DualSense Bluetooth packets
-inline uint32_t ComputeCRC32(const unsigned char* buffer, size_t length) {
-    uint32_t result = CRC_SEED;
+// Reference implementation (one table lookup per byte)
+inline uint32_t ComputeCRC32Bytewise(const unsigned char* buffer, size_t length, uint32_t seed = CRC_SEED) {
+    uint32_t result = seed;
     for (size_t i = 0; i < length; i++) {
         result = CRC_TABLE[static_cast<unsigned char>(result) ^ buffer[i]] ^ (result >> 8);
     }
     return result;
 }
 
+// Portable slice-by-16 implementation (bit-exact with ComputeCRC32Bytewise)
+uint32_t ComputeCRC32Slice16(const unsigned char* buffer, size_t length, uint32_t seed = CRC_SEED);
+
+// Compute CRC32 checksum for DualSense Bluetooth packets
+// Dispatches once at runtime to PCLMULQDQ (x86), CRC32 instructions (ARMv8)
+// or slice-by-16; every variant is bit-exact with ComputeCRC32Bytewise.
+uint32_t ComputeCRC32(const unsigned char* buffer, size_t length, uint32_t seed = CRC_SEED);
+
+// Name of the implementation selected by ComputeCRC32
+const char* GetCRC32Implementation();
+
 } // namespace protocol
 } // namespace dualsense
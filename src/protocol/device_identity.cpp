@@ -0,0 +1,63 @@
+// Controller Identity
+
+#include "device_identity.h"
+#include "../../include/dualsense.h"
+#include <cctype>
+
+namespace dualsense {
+namespace protocol {
+
+namespace {
+
+constexpr unsigned char PAIRING_INFO_REPORT_ID_DUALSENSE = 0x09;
+constexpr size_t PAIRING_INFO_REPORT_SIZE_DUALSENSE = 20;
+constexpr unsigned char PAIRING_INFO_REPORT_ID_DS4 = 0x12;
+constexpr size_t PAIRING_INFO_REPORT_SIZE_DS4 = 16;
+
+// Both reports hold the address in bytes 1-6, least significant byte first
+std::string FormatAddress(const unsigned char* address) {
+    static const char digits[] = "0123456789abcdef";
+    std::string identity;
+    for (int i = 5; i >= 0; i--) {
+        identity += digits[address[i] >> 4];
+        identity += digits[address[i] & 0x0F];
+    }
+    return identity;
+}
+
+} // anonymous namespace
+
+std::string ReadDeviceIdentity(hid::Transport& transport, const std::string& path, int device_type,
+                               int connection_type) {
+    // DS4 over Bluetooth has no pairing info report; the OS knows the address
+    const bool ds4 = device_type == DS_DEVICE_DUALSHOCK4;
+    if (!ds4 || connection_type == DS_CONNECTION_USB) {
+        unsigned char report[PAIRING_INFO_REPORT_SIZE_DUALSENSE] = {};
+        report[0] = ds4 ? PAIRING_INFO_REPORT_ID_DS4 : PAIRING_INFO_REPORT_ID_DUALSENSE;
+        const size_t size = ds4 ? PAIRING_INFO_REPORT_SIZE_DS4 : PAIRING_INFO_REPORT_SIZE_DUALSENSE;
+        if (transport.GetFeature(report, size)) {
+            const std::string identity = FormatAddress(&report[1]);
+            if (identity != "000000000000") {
+                return identity;
+            }
+        }
+    }
+
+    return NormalizeIdentity(hid::ReadUniqueId(path));
+}
+
+std::string NormalizeIdentity(const std::string& unique_id) {
+    std::string identity;
+    for (char c : unique_id) {
+        if (std::isxdigit(static_cast<unsigned char>(c))) {
+            identity += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        else if (c != ':' && c != '-') {
+            return std::string();
+        }
+    }
+    return (identity.size() == 12) ? identity : std::string();
+}
+
+} // namespace protocol
+} // namespace dualsense
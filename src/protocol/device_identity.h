@@ -0,0 +1,25 @@
+// Controller Identity
+// Tells controllers of the same model apart by their Bluetooth address, so a
+// reconnecting controller gets its own handle back
+// Pairing info layout: https://github.com/torvalds/linux/blob/master/drivers/hid/hid-playstation.c
+
+#pragma once
+
+#include "../hid/transport.h"
+#include <string>
+
+namespace dualsense {
+namespace protocol {
+
+// Bluetooth address as 12 lowercase hex digits, empty if unknown
+// Read from the pairing info feature report (DualSense 0x09, DS4 over USB
+// 0x12), else from the unique ID the OS reports for path.
+std::string ReadDeviceIdentity(hid::Transport& transport, const std::string& path, int device_type,
+                               int connection_type);
+
+// OS unique ID ("aa:bb:cc:dd:ee:ff", "aabbccddeeff") in the same form; empty
+// unless it holds exactly 12 hex digits
+std::string NormalizeIdentity(const std::string& unique_id);
+
+} // namespace protocol
+} // namespace dualsense
@@ -0,0 +1,410 @@
+// PCM to Audio Haptic Resampler
+
+#include "haptic_resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define DS_FIR_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define DS_FIR_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace dualsense {
+namespace protocol {
+
+namespace {
+
+// Passband edge and transition width of the anti-aliasing filter
+constexpr double CUTOFF_HZ = 1200.0;
+constexpr double TRANSITION_HZ = 600.0;
+
+// Blackman window transition width in bins (width = K * rate / length)
+constexpr double BLACKMAN_WIDTH = 5.5;
+
+// Limits on the rational ratio and filter length
+constexpr uint32_t MAX_PHASES = 64;
+constexpr size_t MAX_TAPS = 1024;
+
+// Input frames accepted per refill of the history buffer
+constexpr size_t CHUNK_FRAMES = 1024;
+
+constexpr double PI = 3.14159265358979323846;
+
+uint32_t Gcd(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        const uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+void DotProductScalar(const float* coeffs, const float* left, const float* right,
+                      size_t taps, float* out_left, float* out_right) {
+    float sum_left[4] = {};
+    float sum_right[4] = {};
+    for (size_t i = 0; i < taps; i += 4) {
+        for (size_t j = 0; j < 4; j++) {
+            sum_left[j] += coeffs[i + j] * left[i + j];
+            sum_right[j] += coeffs[i + j] * right[i + j];
+        }
+    }
+    *out_left = (sum_left[0] + sum_left[1]) + (sum_left[2] + sum_left[3]);
+    *out_right = (sum_right[0] + sum_right[1]) + (sum_right[2] + sum_right[3]);
+}
+
+#ifdef DS_FIR_X86
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DS_TARGET_SSE __attribute__((target("sse2")))
+#define DS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define DS_TARGET_SSE
+#define DS_TARGET_AVX2
+#endif
+
+DS_TARGET_SSE
+float HorizontalSum(__m128 v) {
+    const __m128 high = _mm_movehl_ps(v, v);
+    const __m128 pair = _mm_add_ps(v, high);
+    const __m128 odd = _mm_shuffle_ps(pair, pair, 0x55);
+    return _mm_cvtss_f32(_mm_add_ss(pair, odd));
+}
+
+DS_TARGET_SSE
+void DotProductSse(const float* coeffs, const float* left, const float* right,
+                   size_t taps, float* out_left, float* out_right) {
+    __m128 sum_left0 = _mm_setzero_ps();
+    __m128 sum_left1 = _mm_setzero_ps();
+    __m128 sum_right0 = _mm_setzero_ps();
+    __m128 sum_right1 = _mm_setzero_ps();
+    for (size_t i = 0; i < taps; i += 8) {
+        const __m128 c0 = _mm_loadu_ps(coeffs + i);
+        const __m128 c1 = _mm_loadu_ps(coeffs + i + 4);
+        sum_left0 = _mm_add_ps(sum_left0, _mm_mul_ps(c0, _mm_loadu_ps(left + i)));
+        sum_left1 = _mm_add_ps(sum_left1, _mm_mul_ps(c1, _mm_loadu_ps(left + i + 4)));
+        sum_right0 = _mm_add_ps(sum_right0, _mm_mul_ps(c0, _mm_loadu_ps(right + i)));
+        sum_right1 = _mm_add_ps(sum_right1, _mm_mul_ps(c1, _mm_loadu_ps(right + i + 4)));
+    }
+    *out_left = HorizontalSum(_mm_add_ps(sum_left0, sum_left1));
+    *out_right = HorizontalSum(_mm_add_ps(sum_right0, sum_right1));
+}
+
+DS_TARGET_AVX2
+void DotProductAvx2(const float* coeffs, const float* left, const float* right,
+                    size_t taps, float* out_left, float* out_right) {
+    __m256 sum_left = _mm256_setzero_ps();
+    __m256 sum_right = _mm256_setzero_ps();
+    for (size_t i = 0; i < taps; i += 8) {
+        const __m256 c = _mm256_loadu_ps(coeffs + i);
+        sum_left = _mm256_fmadd_ps(c, _mm256_loadu_ps(left + i), sum_left);
+        sum_right = _mm256_fmadd_ps(c, _mm256_loadu_ps(right + i), sum_right);
+    }
+    const __m128 left4 = _mm_add_ps(_mm256_castps256_ps128(sum_left), _mm256_extractf128_ps(sum_left, 1));
+    const __m128 right4 = _mm_add_ps(_mm256_castps256_ps128(sum_right), _mm256_extractf128_ps(sum_right, 1));
+    *out_left = HorizontalSum(left4);
+    *out_right = HorizontalSum(right4);
+}
+
+bool HasSse() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;    // SSE2 is part of x86-64
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+bool HasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool os_avx = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(info, 7, 0);
+    return fma && os_avx && (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif // DS_FIR_X86
+
+#ifdef DS_FIR_NEON
+
+void DotProductNeon(const float* coeffs, const float* left, const float* right,
+                    size_t taps, float* out_left, float* out_right) {
+    float32x4_t sum_left0 = vdupq_n_f32(0.0f);
+    float32x4_t sum_left1 = vdupq_n_f32(0.0f);
+    float32x4_t sum_right0 = vdupq_n_f32(0.0f);
+    float32x4_t sum_right1 = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < taps; i += 8) {
+        const float32x4_t c0 = vld1q_f32(coeffs + i);
+        const float32x4_t c1 = vld1q_f32(coeffs + i + 4);
+        sum_left0 = vfmaq_f32(sum_left0, c0, vld1q_f32(left + i));
+        sum_left1 = vfmaq_f32(sum_left1, c1, vld1q_f32(left + i + 4));
+        sum_right0 = vfmaq_f32(sum_right0, c0, vld1q_f32(right + i));
+        sum_right1 = vfmaq_f32(sum_right1, c1, vld1q_f32(right + i + 4));
+    }
+    *out_left = vaddvq_f32(vaddq_f32(sum_left0, sum_left1));
+    *out_right = vaddvq_f32(vaddq_f32(sum_right0, sum_right1));
+}
+
+#endif // DS_FIR_NEON
+
+inline float ToFloat(float sample) {
+    return sample;
+}
+
+inline float ToFloat(int16_t sample) {
+    return static_cast<float>(sample) * (1.0f / 32768.0f);
+}
+
+} // anonymous namespace
+
+bool IsFirKernelSupported(FirKernel kernel) {
+    switch (kernel) {
+    case FirKernel::Scalar:
+        return true;
+#ifdef DS_FIR_X86
+    case FirKernel::Sse:
+        return HasSse();
+    case FirKernel::Avx2:
+        return HasAvx2();
+#endif
+#ifdef DS_FIR_NEON
+    case FirKernel::Neon:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+FirKernel GetBestFirKernel() {
+    static const FirKernel best = [] {
+        const FirKernel preference[] = { FirKernel::Avx2, FirKernel::Neon, FirKernel::Sse };
+        for (FirKernel kernel : preference) {
+            if (IsFirKernelSupported(kernel)) {
+                return kernel;
+            }
+        }
+        return FirKernel::Scalar;
+    }();
+    return best;
+}
+
+const char* GetFirKernelName(FirKernel kernel) {
+    switch (kernel) {
+    case FirKernel::Sse: return "sse";
+    case FirKernel::Avx2: return "avx2";
+    case FirKernel::Neon: return "neon";
+    default: return "scalar";
+    }
+}
+
+bool HapticResampler::Configure(uint32_t input_rate, uint32_t channels, float gain) {
+    taps_ = 0;
+
+    if ((channels != 1 && channels != 2) || input_rate < HAPTIC_SAMPLE_RATE || !(gain >= 0.0f)) {
+        return false;
+    }
+
+    const uint32_t divisor = Gcd(HAPTIC_SAMPLE_RATE, input_rate);
+    const uint32_t interpolation = HAPTIC_SAMPLE_RATE / divisor;
+    const uint32_t decimation = input_rate / divisor;
+    if (interpolation > MAX_PHASES) {
+        return false;
+    }
+
+    // Taps per phase for the requested transition width, rounded up for SIMD
+    size_t taps = static_cast<size_t>(std::ceil(BLACKMAN_WIDTH * input_rate / TRANSITION_HZ));
+    taps = std::min(MAX_TAPS, (taps + 7) & ~static_cast<size_t>(7));
+
+    // Windowed-sinc prototype at the upsampled rate L * input_rate
+    const size_t length = taps * interpolation;
+    const double cutoff = CUTOFF_HZ / (static_cast<double>(input_rate) * interpolation);
+    const double center = (static_cast<double>(length) - 1.0) / 2.0;
+    std::vector<double> prototype(length);
+    double sum = 0.0;
+    for (size_t n = 0; n < length; n++) {
+        const double x = static_cast<double>(n) - center;
+        const double sinc = (x == 0.0) ? 2.0 * cutoff : std::sin(2.0 * PI * cutoff * x) / (PI * x);
+        const double w = 2.0 * PI * static_cast<double>(n) / (static_cast<double>(length) - 1.0);
+        const double window = 0.42 - 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+        prototype[n] = sinc * window;
+        sum += prototype[n];
+    }
+
+    // Split into phases: y[k] = sum_j h[p + jL] * x[base - j]; store oldest first
+    // and scale by L so each phase has unity DC gain
+    coeffs_.assign(interpolation * taps, 0.0f);
+    for (uint32_t phase = 0; phase < interpolation; phase++) {
+        for (size_t j = 0; j < taps; j++) {
+            const double h = prototype[phase + j * interpolation] * interpolation / sum;
+            coeffs_[phase * taps + (taps - 1 - j)] = static_cast<float>(h);
+        }
+    }
+
+    channels_ = channels;
+    interpolation_ = interpolation;
+    decimation_ = decimation;
+    scale_ = gain * 127.0f;
+    left_.assign(taps - 1 + CHUNK_FRAMES, 0.0f);
+    right_.assign(taps - 1 + CHUNK_FRAMES, 0.0f);
+    if (!dot_) {
+        SetKernel(GetBestFirKernel());
+    }
+    taps_ = taps;
+
+    Reset();
+    return true;
+}
+
+void HapticResampler::Reset() {
+    if (taps_ == 0) {
+        return;
+    }
+
+    // Start with a silent history so the first output needs one input sample
+    std::fill(left_.begin(), left_.end(), 0.0f);
+    std::fill(right_.begin(), right_.end(), 0.0f);
+    buffered_ = taps_ - 1;
+    base_ = taps_ - 1;
+    phase_ = 0;
+    dither_state_ = 0x12345678;
+}
+
+void HapticResampler::SetKernel(FirKernel kernel) {
+    switch (kernel) {
+#ifdef DS_FIR_X86
+    case FirKernel::Sse:
+        dot_ = &DotProductSse;
+        break;
+    case FirKernel::Avx2:
+        dot_ = &DotProductAvx2;
+        break;
+#endif
+#ifdef DS_FIR_NEON
+    case FirKernel::Neon:
+        dot_ = &DotProductNeon;
+        break;
+#endif
+    default:
+        dot_ = &DotProductScalar;
+        break;
+    }
+}
+
+size_t HapticResampler::Process(const float* input, size_t frame_count,
+                                int8_t* output, size_t max_output_frames, size_t* out_frames) {
+    return ProcessImpl(input, frame_count, output, max_output_frames, out_frames);
+}
+
+size_t HapticResampler::Process(const int16_t* input, size_t frame_count,
+                                int8_t* output, size_t max_output_frames, size_t* out_frames) {
+    return ProcessImpl(input, frame_count, output, max_output_frames, out_frames);
+}
+
+template <typename Sample>
+size_t HapticResampler::ProcessImpl(const Sample* input, size_t frame_count,
+                                    int8_t* output, size_t max_output_frames, size_t* out_frames) {
+    size_t consumed = 0;
+    size_t produced = 0;
+
+    if (taps_ != 0) {
+        for (;;) {
+            produced += Drain(output + produced * 2, max_output_frames - produced);
+            if (produced == max_output_frames || consumed == frame_count) {
+                break;
+            }
+
+            // Deinterleave the next chunk into the planar history
+            const size_t count = std::min(left_.size() - buffered_, frame_count - consumed);
+            if (count == 0) {
+                break;
+            }
+
+            const Sample* frames = input + consumed * channels_;
+            float* left = &left_[buffered_];
+            float* right = &right_[buffered_];
+            if (channels_ == 2) {
+                for (size_t i = 0; i < count; i++) {
+                    left[i] = ToFloat(frames[i * 2]);
+                    right[i] = ToFloat(frames[i * 2 + 1]);
+                }
+            }
+            else {
+                for (size_t i = 0; i < count; i++) {
+                    left[i] = ToFloat(frames[i]);
+                }
+                memcpy(right, left, count * sizeof(float));
+            }
+
+            buffered_ += count;
+            consumed += count;
+        }
+    }
+
+    *out_frames = produced;
+    return consumed;
+}
+
+size_t HapticResampler::Drain(int8_t* output, size_t max_output_frames) {
+    size_t produced = 0;
+
+    while (produced < max_output_frames && base_ < buffered_) {
+        const size_t first = base_ + 1 - taps_;
+        float left;
+        float right;
+        dot_(&coeffs_[phase_ * taps_], &left_[first], &right_[first], taps_, &left, &right);
+
+        output[produced * 2] = Quantize(left);
+        output[produced * 2 + 1] = Quantize(right);
+        produced++;
+
+        phase_ += decimation_;
+        base_ += phase_ / interpolation_;
+        phase_ %= interpolation_;
+    }
+
+    // Drop input no future output can reach
+    const size_t shift = std::min(base_ + 1 - taps_, buffered_);
+    if (shift > 0) {
+        memmove(left_.data(), left_.data() + shift, (buffered_ - shift) * sizeof(float));
+        memmove(right_.data(), right_.data() + shift, (buffered_ - shift) * sizeof(float));
+        buffered_ -= shift;
+        base_ -= shift;
+    }
+
+    return produced;
+}
+
+int8_t HapticResampler::Quantize(float value) {
+    // TPDF dither: sum of two uniform variables, +-1 LSB peak
+    uint32_t state = dither_state_;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    const float r1 = static_cast<float>(state & 0xFFFF) * (1.0f / 65536.0f);
+    const float r2 = static_cast<float>(state >> 16) * (1.0f / 65536.0f);
+    dither_state_ = state;
+
+    const float scaled = std::floor(value * scale_ + (r1 - r2) + 0.5f);
+    return static_cast<int8_t>(std::min(127.0f, std::max(-128.0f, scaled)));
+}
+
+} // namespace protocol
+} // namespace dualsense
@@ -0,0 +1,92 @@
+// PCM to Audio Haptic Resampler
+// Converts float/int16 PCM at common audio rates into the 3 kHz stereo int8
+// sample stream carried by Bluetooth haptic reports.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace dualsense {
+namespace protocol {
+
+// Haptic stream rate (stereo frames per second)
+constexpr uint32_t HAPTIC_SAMPLE_RATE = 3000;
+
+// Dot-product kernels for the FIR filter
+enum class FirKernel : uint8_t {
+    Scalar,
+    Sse,
+    Avx2,
+    Neon
+};
+
+// Check whether a kernel can run on this CPU
+bool IsFirKernelSupported(FirKernel kernel);
+
+// Fastest kernel supported on this CPU
+FirKernel GetBestFirKernel();
+
+// Kernel name for logs and benchmarks
+const char* GetFirKernelName(FirKernel kernel);
+
+// Polyphase FIR resampler (input_rate -> 3 kHz) with gain and TPDF-dithered
+// 8-bit quantization. Rational ratio L/M = 3000/input_rate; each output sample
+// is one dot product against the coefficients of its phase, so the cost is
+// taps per output sample rather than per input sample.
+class HapticResampler {
+public:
+    // Configure for interleaved input with 1 (mono) or 2 (stereo) channels
+    // Resets filter history. Returns false for unsupported rates/channels.
+    bool Configure(uint32_t input_rate, uint32_t channels, float gain);
+
+    // Clear filter history and dither state (configuration is kept)
+    void Reset();
+
+    // Select the dot-product kernel (must be supported)
+    void SetKernel(FirKernel kernel);
+
+    bool IsConfigured() const { return taps_ != 0; }
+    uint32_t GetChannels() const { return channels_; }
+
+    // Convert interleaved input into stereo int8 frames
+    // Writes at most max_output_frames frames to output and stores the count
+    // in *out_frames. Returns input frames consumed; input that was consumed
+    // but not yet needed for an output stays buffered for the next call.
+    size_t Process(const float* input, size_t frame_count,
+                   int8_t* output, size_t max_output_frames, size_t* out_frames);
+    size_t Process(const int16_t* input, size_t frame_count,
+                   int8_t* output, size_t max_output_frames, size_t* out_frames);
+
+private:
+    template <typename Sample>
+    size_t ProcessImpl(const Sample* input, size_t frame_count,
+                       int8_t* output, size_t max_output_frames, size_t* out_frames);
+    size_t Drain(int8_t* output, size_t max_output_frames);
+    int8_t Quantize(float value);
+
+    using DotProduct2 = void (*)(const float* coeffs, const float* left, const float* right,
+                                 size_t taps, float* out_left, float* out_right);
+
+    // Ratio and filter
+    uint32_t channels_ = 0;
+    uint32_t interpolation_ = 1;    // L
+    uint32_t decimation_ = 1;       // M
+    size_t taps_ = 0;               // Taps per phase (multiple of 8)
+    float scale_ = 0.0f;            // gain * 127
+    std::vector<float> coeffs_;     // [phase][tap], taps stored oldest sample first
+    DotProduct2 dot_ = nullptr;
+
+    // Planar input history (taps_ - 1 samples of history + one chunk)
+    std::vector<float> left_;
+    std::vector<float> right_;
+    size_t buffered_ = 0;
+    size_t base_ = 0;               // Newest input sample used by the next output
+    uint32_t phase_ = 0;
+
+    uint32_t dither_state_ = 0x12345678;
+};
+
+} // namespace protocol
+} // namespace dualsense
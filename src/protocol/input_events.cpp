@@ -0,0 +1,144 @@
+// Input Edge Events
+
+#include "input_events.h"
+#include <algorithm>
+#include <cmath>
+
+namespace dualsense {
+namespace protocol {
+
+namespace {
+
+DSEvent MakeEvent(const DSInputState& state, uint32_t sequence, DSEventType type) {
+    DSEvent event = {};
+    event.timestamp_us = state.sensor_timestamp_us;
+    event.sequence = sequence;
+    event.type = static_cast<uint8_t>(type);
+    return event;
+}
+
+DSEvent MakeTouchEvent(const DSInputState& state, uint32_t sequence, DSEventType type,
+                       uint8_t slot, const DSTouchPoint& touch) {
+    DSEvent event = MakeEvent(state, sequence, type);
+    event.touch_slot = slot;
+    event.touch_id = touch.id;
+    event.touch_x = touch.x;
+    event.touch_y = touch.y;
+    return event;
+}
+
+size_t DiffTouch(const DSInputState& current, uint32_t sequence, uint8_t slot,
+                 const DSTouchPoint& before, const DSTouchPoint& after, DSEvent* out) {
+    size_t count = 0;
+
+    // A new finger ID in an active slot is a lift followed by a new touch
+    const bool same_finger = before.is_active && after.is_active && before.id == after.id;
+
+    if (before.is_active && !same_finger) {
+        out[count++] = MakeTouchEvent(current, sequence, DS_EVENT_TOUCH_END, slot, before);
+    }
+    if (after.is_active && !same_finger) {
+        out[count++] = MakeTouchEvent(current, sequence, DS_EVENT_TOUCH_BEGIN, slot, after);
+    }
+    else if (same_finger && (before.x != after.x || before.y != after.y)) {
+        out[count++] = MakeTouchEvent(current, sequence, DS_EVENT_TOUCH_MOVE, slot, after);
+    }
+
+    return count;
+}
+
+void GetAxes(const DSInputState& state, uint8_t out[DS_AXIS_COUNT]) {
+    out[DS_AXIS_LEFT_X] = state.stick_lx;
+    out[DS_AXIS_LEFT_Y] = state.stick_ly;
+    out[DS_AXIS_RIGHT_X] = state.stick_rx;
+    out[DS_AXIS_RIGHT_Y] = state.stick_ry;
+    out[DS_AXIS_L2] = state.trigger_l2;
+    out[DS_AXIS_R2] = state.trigger_r2;
+}
+
+// Distance of a stick from center (0-181)
+uint8_t StickDistance(uint8_t x, uint8_t y) {
+    const int dx = x - 128;
+    const int dy = y - 128;
+    return static_cast<uint8_t>(std::lround(std::sqrt(static_cast<float>(dx * dx + dy * dy))));
+}
+
+} // anonymous namespace
+
+uint32_t GetButtonMask(const DSInputState& state) {
+    const bool buttons[DS_BUTTON_COUNT] = {
+        state.button_cross, state.button_circle, state.button_square, state.button_triangle,
+        state.button_l1, state.button_r1, state.button_l2_digital, state.button_r2_digital,
+        state.button_l3, state.button_r3,
+        state.button_dpad_up, state.button_dpad_down, state.button_dpad_left, state.button_dpad_right,
+        state.button_create, state.button_options, state.button_ps, state.button_mute, state.button_touchpad,
+        state.button_fn1, state.button_fn2, state.button_paddle_left, state.button_paddle_right,
+    };
+
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < DS_BUTTON_COUNT; i++) {
+        mask |= static_cast<uint32_t>(buttons[i]) << i;
+    }
+    return mask;
+}
+
+size_t DiffInputStates(const DSInputState& previous, const DSInputState& current,
+                       uint32_t sequence, DSEvent* out) {
+    size_t count = 0;
+
+    const uint32_t before = GetButtonMask(previous);
+    const uint32_t after = GetButtonMask(current);
+    uint32_t changed = before ^ after;
+    while (changed != 0) {
+        uint32_t button = 0;
+        while (!(changed & (1u << button))) {
+            button++;
+        }
+        changed &= changed - 1;
+
+        DSEvent event = MakeEvent(current, sequence, (after & (1u << button)) ? DS_EVENT_BUTTON_DOWN : DS_EVENT_BUTTON_UP);
+        event.button = static_cast<uint8_t>(button);
+        out[count++] = event;
+    }
+
+    count += DiffTouch(current, sequence, 0, previous.touch1, current.touch1, out + count);
+    count += DiffTouch(current, sequence, 1, previous.touch2, current.touch2, out + count);
+    return count;
+}
+
+void StartAggregate(const DSInputState& state, DSInputAggregate* out) {
+    *out = DSInputAggregate{};
+    out->buttons_held = GetButtonMask(state);
+    GetAxes(state, out->axis_min);
+    GetAxes(state, out->axis_max);
+    out->stick_peak[0] = StickDistance(state.stick_lx, state.stick_ly);
+    out->stick_peak[1] = StickDistance(state.stick_rx, state.stick_ry);
+}
+
+void AccumulateAggregate(const DSInputState& previous, const DSInputState& current, DSInputAggregate* aggregate) {
+    const uint32_t buttons = GetButtonMask(current);
+    uint32_t pressed = buttons & ~GetButtonMask(previous);
+    while (pressed != 0) {
+        uint32_t button = 0;
+        while (!(pressed & (1u << button))) {
+            button++;
+        }
+        pressed &= pressed - 1;
+        aggregate->press_count[button]++;
+    }
+
+    uint8_t axes[DS_AXIS_COUNT];
+    GetAxes(current, axes);
+    for (size_t axis = 0; axis < DS_AXIS_COUNT; axis++) {
+        aggregate->axis_min[axis] = std::min(aggregate->axis_min[axis], axes[axis]);
+        aggregate->axis_max[axis] = std::max(aggregate->axis_max[axis], axes[axis]);
+    }
+    aggregate->stick_peak[0] = std::max(aggregate->stick_peak[0], StickDistance(current.stick_lx, current.stick_ly));
+    aggregate->stick_peak[1] = std::max(aggregate->stick_peak[1], StickDistance(current.stick_rx, current.stick_ry));
+
+    aggregate->buttons_held |= buttons;
+    aggregate->reports++;
+}
+
+} // namespace protocol
+} // namespace dualsense
@@ -0,0 +1,32 @@
+// Input Edge Events
+// Button press/release and touch begin/move/end derived from consecutive input states
+
+#pragma once
+
+#include "../../include/dualsense.h"
+#include <stddef.h>
+#include <stdint.h>
+
+namespace dualsense {
+namespace protocol {
+
+// Upper bound on events produced by one report (every button plus two
+// touch slots, each of which may end one finger and begin another)
+constexpr size_t MAX_EVENTS_PER_REPORT = DS_BUTTON_COUNT + 4;
+
+// Pack the digital buttons of a state into a mask (bit = DSButton)
+uint32_t GetButtonMask(const DSInputState& state);
+
+// Write the edges between two states to out (room for MAX_EVENTS_PER_REPORT)
+// Events carry the timestamp of current and the given report sequence number.
+size_t DiffInputStates(const DSInputState& previous, const DSInputState& current,
+                       uint32_t sequence, DSEvent* out);
+
+// Start an aggregate describing state alone (no reports folded in yet)
+void StartAggregate(const DSInputState& state, DSInputAggregate* out);
+
+// Fold current into an aggregate; presses are edges against previous
+void AccumulateAggregate(const DSInputState& previous, const DSInputState& current, DSInputAggregate* aggregate);
+
+} // namespace protocol
+} // namespace dualsense
@@ -0,0 +1,100 @@
+// Packed Input State
+
+#include "input_packing.h"
+#include "input_events.h"
+#include <algorithm>
+#include <cmath>
+
+namespace dualsense {
+namespace protocol {
+
+static_assert(sizeof(DSPackedInputState) == 64, "DSPackedInputState must stay 64 bytes");
+static_assert(alignof(DSPackedInputState) == 32, "DSPackedInputState must be 32-byte aligned");
+static_assert(alignof(DSInputStateSoA) == 32, "DSInputStateSoA must be 32-byte aligned");
+
+namespace {
+
+// 0-255 around 128 to the full int16 range, exact at both ends and center
+int16_t PackStick(uint8_t value) {
+    const int centered = value - 128;
+    return static_cast<int16_t>((centered < 0) ? centered * 256 : centered * 32767 / 127);
+}
+
+int16_t PackTrigger(uint8_t value) {
+    return static_cast<int16_t>((value * 32767 + 127) / 255);
+}
+
+int16_t PackFixed(float value, float scale) {
+    const float packed = std::round(value * scale);
+    return static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, packed)));
+}
+
+} // anonymous namespace
+
+void PackInputState(const DSInputState& state, DSPackedInputState* out) {
+    *out = DSPackedInputState{};
+    out->buttons = GetButtonMask(state);
+
+    out->left_x = PackStick(state.stick_lx);
+    out->left_y = PackStick(state.stick_ly);
+    out->right_x = PackStick(state.stick_rx);
+    out->right_y = PackStick(state.stick_ry);
+    out->l2 = PackTrigger(state.trigger_l2);
+    out->r2 = PackTrigger(state.trigger_r2);
+
+    out->gyro[0] = PackFixed(state.gyro_x, DS_PACKED_GYRO_SCALE);
+    out->gyro[1] = PackFixed(state.gyro_y, DS_PACKED_GYRO_SCALE);
+    out->gyro[2] = PackFixed(state.gyro_z, DS_PACKED_GYRO_SCALE);
+    out->accel[0] = PackFixed(state.accel_x, DS_PACKED_ACCEL_SCALE);
+    out->accel[1] = PackFixed(state.accel_y, DS_PACKED_ACCEL_SCALE);
+    out->accel[2] = PackFixed(state.accel_z, DS_PACKED_ACCEL_SCALE);
+    out->orientation[0] = PackFixed(state.orientation_w, 32767.0f);
+    out->orientation[1] = PackFixed(state.orientation_x, 32767.0f);
+    out->orientation[2] = PackFixed(state.orientation_y, 32767.0f);
+    out->orientation[3] = PackFixed(state.orientation_z, 32767.0f);
+
+    out->touch_x[0] = state.touch1.x;
+    out->touch_y[0] = state.touch1.y;
+    out->touch_x[1] = state.touch2.x;
+    out->touch_y[1] = state.touch2.y;
+    out->touch_id[0] = state.touch1.id;
+    out->touch_id[1] = state.touch2.id;
+
+    out->battery_level = static_cast<uint8_t>(std::max<int8_t>(state.battery_level, 0));
+    out->flags = static_cast<uint8_t>((state.battery_charging ? DS_PACKED_CHARGING : 0) |
+                                      (state.touch1.is_active ? DS_PACKED_TOUCH1_ACTIVE : 0) |
+                                      (state.touch2.is_active ? DS_PACKED_TOUCH2_ACTIVE : 0));
+    out->sensor_timestamp_us = state.sensor_timestamp_us;
+}
+
+void StorePackedColumn(const DSPackedInputState& state, size_t column, DSInputStateSoA* out) {
+    out->buttons[column] = state.buttons;
+    out->left_x[column] = state.left_x;
+    out->left_y[column] = state.left_y;
+    out->right_x[column] = state.right_x;
+    out->right_y[column] = state.right_y;
+    out->l2[column] = state.l2;
+    out->r2[column] = state.r2;
+    out->gyro_x[column] = state.gyro[0];
+    out->gyro_y[column] = state.gyro[1];
+    out->gyro_z[column] = state.gyro[2];
+    out->accel_x[column] = state.accel[0];
+    out->accel_y[column] = state.accel[1];
+    out->accel_z[column] = state.accel[2];
+    out->orientation_w[column] = state.orientation[0];
+    out->orientation_x[column] = state.orientation[1];
+    out->orientation_y[column] = state.orientation[2];
+    out->orientation_z[column] = state.orientation[3];
+    out->touch1_x[column] = state.touch_x[0];
+    out->touch1_y[column] = state.touch_y[0];
+    out->touch2_x[column] = state.touch_x[1];
+    out->touch2_y[column] = state.touch_y[1];
+    out->touch1_id[column] = state.touch_id[0];
+    out->touch2_id[column] = state.touch_id[1];
+    out->battery_level[column] = state.battery_level;
+    out->flags[column] = state.flags;
+    out->sensor_timestamp_us[column] = state.sensor_timestamp_us;
+}
+
+} // namespace protocol
+} // namespace dualsense
@@ -0,0 +1,19 @@
+// Packed Input State
+// Fixed-layout, fixed-point form of DSInputState and its structure-of-arrays columns
+
+#pragma once
+
+#include "../../include/dualsense.h"
+#include <stddef.h>
+
+namespace dualsense {
+namespace protocol {
+
+// Convert a state to the packed layout
+void PackInputState(const DSInputState& state, DSPackedInputState* out);
+
+// Write a packed state into column `column` of a structure-of-arrays snapshot
+void StorePackedColumn(const DSPackedInputState& state, size_t column, DSInputStateSoA* out);
+
+} // namespace protocol
+} // namespace dualsense
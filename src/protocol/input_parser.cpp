@@ -0,0 +1,366 @@
+// DualSense / DualShock 4 Input Report Decoder
+// Report layouts: https://github.com/torvalds/linux/blob/master/drivers/hid/hid-playstation.c
+
+#include "input_parser.h"
+#include "../hid/hid_constants.h"
+#include <array>
+#include <cstring>
+
+namespace dualsense {
+namespace protocol {
+
+namespace {
+
+// Number of digital buttons described by a layout table
+constexpr size_t BUTTON_COUNT = 19;
+
+// One digital button: DSInputState field <- report[byte] & mask
+// A zero mask marks a button the model does not have (always false).
+struct ButtonField {
+    bool DSInputState::* field;
+    uint8_t byte;
+    uint8_t mask;
+};
+
+enum class BatteryFormat : uint8_t {
+    DualSense,
+    DualShock4
+};
+
+// Compile-time description of one input report layout
+// All offsets are absolute byte positions in the raw report (report ID at 0).
+struct InputLayout {
+    uint8_t report_id;
+    uint8_t report_size;
+    uint8_t stick_lx;
+    uint8_t stick_ly;
+    uint8_t stick_rx;
+    uint8_t stick_ry;
+    uint8_t trigger_l2;
+    uint8_t trigger_r2;
+    uint8_t dpad;           // Low nibble holds the hat switch
+    uint8_t touch1;
+    uint8_t touch2;
+    uint8_t status;
+    uint8_t gyro;           // 3 x int16 (pitch, yaw, roll)
+    uint8_t accel;          // 3 x int16 (x, y, z)
+    uint8_t timestamp;
+    uint8_t timestamp_size; // 4 = DualSense (1/3 us ticks), 2 = DS4 (16/3 us ticks)
+    uint8_t sequence;       // Report counter byte
+    uint8_t sequence_shift; // Counter bits start here (DS4 shares the byte with buttons)
+    BatteryFormat battery;
+    ButtonField buttons[BUTTON_COUNT];
+};
+
+// Both families share the first three button bytes:
+//   b0: hat | square | cross | circle | triangle
+//   b1: L1 | R1 | L2 | R2 | create/share | options | L3 | R3
+//   b2: PS | touchpad | mute | (Edge) Fn1 | Fn2 | paddle left | paddle right
+constexpr InputLayout MakeLayout(uint8_t report_id, uint8_t report_size, uint8_t base,
+                                 bool dualshock4, bool edge) {
+    const uint8_t b0 = base + (dualshock4 ? 4 : 7);
+    const uint8_t b1 = b0 + 1;
+    const uint8_t b2 = b0 + 2;
+    const uint8_t edge_mask = edge ? 0xFF : 0x00;
+
+    return InputLayout{
+        report_id,
+        report_size,
+        static_cast<uint8_t>(base + 0),
+        static_cast<uint8_t>(base + 1),
+        static_cast<uint8_t>(base + 2),
+        static_cast<uint8_t>(base + 3),
+        static_cast<uint8_t>(base + (dualshock4 ? 7 : 4)),
+        static_cast<uint8_t>(base + (dualshock4 ? 8 : 5)),
+        b0,
+        static_cast<uint8_t>(base + (dualshock4 ? 34 : 32)),
+        static_cast<uint8_t>(base + (dualshock4 ? 38 : 36)),
+        static_cast<uint8_t>(base + (dualshock4 ? 29 : 52)),
+        static_cast<uint8_t>(base + (dualshock4 ? 12 : 15)),
+        static_cast<uint8_t>(base + (dualshock4 ? 18 : 21)),
+        static_cast<uint8_t>(base + (dualshock4 ? 9 : 27)),
+        static_cast<uint8_t>(dualshock4 ? 2 : 4),
+        static_cast<uint8_t>(dualshock4 ? b2 : base + 6),
+        static_cast<uint8_t>(dualshock4 ? 2 : 0),
+        dualshock4 ? BatteryFormat::DualShock4 : BatteryFormat::DualSense,
+        {
+            { &DSInputState::button_square, b0, BTN_SQUARE },
+            { &DSInputState::button_cross, b0, BTN_CROSS },
+            { &DSInputState::button_circle, b0, BTN_CIRCLE },
+            { &DSInputState::button_triangle, b0, BTN_TRIANGLE },
+            { &DSInputState::button_l1, b1, BTN_LEFT_SHOULDER },
+            { &DSInputState::button_r1, b1, BTN_RIGHT_SHOULDER },
+            { &DSInputState::button_l2_digital, b1, BTN_LEFT_TRIGGER },
+            { &DSInputState::button_r2_digital, b1, BTN_RIGHT_TRIGGER },
+            { &DSInputState::button_create, b1, BTN_SELECT },
+            { &DSInputState::button_options, b1, BTN_START },
+            { &DSInputState::button_l3, b1, BTN_LEFT_STICK },
+            { &DSInputState::button_r3, b1, BTN_RIGHT_STICK },
+            { &DSInputState::button_ps, b2, BTN_PLAYSTATION_LOGO },
+            { &DSInputState::button_touchpad, b2, BTN_PAD_BUTTON },
+            // DS4 reuses the upper bits of b2 as a frame counter
+            { &DSInputState::button_mute, b2, static_cast<uint8_t>(dualshock4 ? 0 : BTN_MIC_BUTTON) },
+            { &DSInputState::button_fn1, b2, static_cast<uint8_t>(BTN_FN1 & edge_mask) },
+            { &DSInputState::button_fn2, b2, static_cast<uint8_t>(BTN_FN2 & edge_mask) },
+            { &DSInputState::button_paddle_left, b2, static_cast<uint8_t>(BTN_PADDLE_LEFT & edge_mask) },
+            { &DSInputState::button_paddle_right, b2, static_cast<uint8_t>(BTN_PADDLE_RIGHT & edge_mask) },
+        }
+    };
+}
+
+// DualSense: USB report 0x01 (payload at 1), BT report 0x31 (payload at 2)
+constexpr InputLayout DUALSENSE_USB = MakeLayout(0x01, 64, 1, false, false);
+constexpr InputLayout DUALSENSE_BT = MakeLayout(0x31, 78, 2, false, false);
+constexpr InputLayout DUALSENSE_EDGE_USB = MakeLayout(0x01, 64, 1, false, true);
+constexpr InputLayout DUALSENSE_EDGE_BT = MakeLayout(0x31, 78, 2, false, true);
+
+// DualShock 4: USB report 0x01 (payload at 1), BT report 0x11 (payload at 3)
+constexpr InputLayout DUALSHOCK4_USB = MakeLayout(0x01, 64, 1, true, false);
+constexpr InputLayout DUALSHOCK4_BT = MakeLayout(0x11, 78, 3, true, false);
+
+// Hat switch (0=N, clockwise, 8+=released) to BTN_DPAD_* mask
+constexpr uint8_t DPAD_FROM_HAT[16] = {
+    BTN_DPAD_UP,
+    BTN_DPAD_UP | BTN_DPAD_RIGHT,
+    BTN_DPAD_RIGHT,
+    BTN_DPAD_DOWN | BTN_DPAD_RIGHT,
+    BTN_DPAD_DOWN,
+    BTN_DPAD_DOWN | BTN_DPAD_LEFT,
+    BTN_DPAD_LEFT,
+    BTN_DPAD_UP | BTN_DPAD_LEFT,
+    0, 0, 0, 0, 0, 0, 0, 0
+};
+
+// BTN_DPAD_* mask to hat switch (inverse of DPAD_FROM_HAT, 8 = released)
+constexpr std::array<uint8_t, 16> MakeHatTable() {
+    std::array<uint8_t, 16> table = {};
+    for (size_t mask = 0; mask < table.size(); mask++) {
+        table[mask] = 8;
+        for (uint8_t hat = 0; hat < 8; hat++) {
+            if (DPAD_FROM_HAT[hat] == mask) {
+                table[mask] = hat;
+            }
+        }
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, 16> HAT_FROM_DPAD = MakeHatTable();
+
+// Battery status byte to (level, charging), precomputed for all 256 values
+struct BatteryInfo {
+    int8_t level;
+    bool charging;
+};
+
+constexpr BatteryInfo DecodeBatteryStatus(BatteryFormat format, uint8_t status) {
+    const int data = status & 0x0F;
+    const int partial = (data * 10 + 5 < 100) ? data * 10 + 5 : 100;
+
+    if (format == BatteryFormat::DualSense) {
+        // High nibble: 0=discharging, 1=charging, 2=full, other=error
+        switch (status >> 4) {
+            case 0x0: return { static_cast<int8_t>(partial), false };
+            case 0x1: return { static_cast<int8_t>(partial), true };
+            case 0x2: return { 100, false };
+            default: return { 0, false };
+        }
+    }
+
+    // DualShock 4: bit 4 = cable connected, level 0-10 (11 = full on cable)
+    if (status & 0x10) {
+        if (data < 10) return { static_cast<int8_t>(data * 10 + 5), true };
+        if (data <= 11) return { 100, false };
+        return { 0, false };
+    }
+    return { static_cast<int8_t>(partial), false };
+}
+
+constexpr std::array<BatteryInfo, 256> MakeBatteryTable(BatteryFormat format) {
+    std::array<BatteryInfo, 256> table = {};
+    for (size_t i = 0; i < table.size(); i++) {
+        table[i] = DecodeBatteryStatus(format, static_cast<uint8_t>(i));
+    }
+    return table;
+}
+
+constexpr std::array<BatteryInfo, 256> BATTERY_DUALSENSE = MakeBatteryTable(BatteryFormat::DualSense);
+constexpr std::array<BatteryInfo, 256> BATTERY_DUALSHOCK4 = MakeBatteryTable(BatteryFormat::DualShock4);
+
+// Level (0-100) and charging flag to a status byte, in the device's 10% steps
+uint8_t EncodeBatteryStatus(BatteryFormat format, int level, bool charging) {
+    const int data = (level <= 0) ? 0 : (level >= 100) ? 10 : level / 10;
+    if (format == BatteryFormat::DualSense) {
+        return static_cast<uint8_t>(data | (charging ? 0x10 : 0x00));
+    }
+    // DualShock 4 only reports charging while the cable is connected
+    return static_cast<uint8_t>((charging && data < 10) ? (data | 0x10) : data);
+}
+
+inline int16_t ReadLE16(const unsigned char* data) {
+    return static_cast<int16_t>(static_cast<uint16_t>(data[0] | (data[1] << 8)));
+}
+
+inline uint32_t ReadLE32(const unsigned char* data) {
+    return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+           (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// Table-generated decoder; every offset and mask is a compile-time constant
+template <const InputLayout& Layout>
+void DecodeInput(const unsigned char* report, DSInputState* out_state, RawMotion* out_motion) {
+    DSInputState state = {};
+
+    state.stick_lx = report[Layout.stick_lx];
+    state.stick_ly = report[Layout.stick_ly];
+    state.stick_rx = report[Layout.stick_rx];
+    state.stick_ry = report[Layout.stick_ry];
+    state.trigger_l2 = report[Layout.trigger_l2];
+    state.trigger_r2 = report[Layout.trigger_r2];
+
+    for (const ButtonField& button : Layout.buttons) {
+        state.*button.field = (report[button.byte] & button.mask) != 0;
+    }
+
+    const uint8_t dpad = DPAD_FROM_HAT[report[Layout.dpad] & 0x0F];
+    state.button_dpad_up = (dpad & BTN_DPAD_UP) != 0;
+    state.button_dpad_down = (dpad & BTN_DPAD_DOWN) != 0;
+    state.button_dpad_left = (dpad & BTN_DPAD_LEFT) != 0;
+    state.button_dpad_right = (dpad & BTN_DPAD_RIGHT) != 0;
+
+    const auto& battery_table = (Layout.battery == BatteryFormat::DualSense)
+        ? BATTERY_DUALSENSE : BATTERY_DUALSHOCK4;
+    const BatteryInfo battery = battery_table[report[Layout.status]];
+    state.battery_level = battery.level;
+    state.battery_charging = battery.charging;
+
+    state.touch1 = ParseTouchPoint(report, Layout.touch1);
+    state.touch2 = ParseTouchPoint(report, Layout.touch2);
+
+    for (int axis = 0; axis < 3; axis++) {
+        out_motion->gyro[axis] = ReadLE16(&report[Layout.gyro + axis * 2]);
+        out_motion->accel[axis] = ReadLE16(&report[Layout.accel + axis * 2]);
+    }
+    out_motion->timestamp = (Layout.timestamp_size == 4)
+        ? ReadLE32(&report[Layout.timestamp])
+        : static_cast<uint16_t>(ReadLE16(&report[Layout.timestamp]));
+
+    *out_state = state;
+}
+
+inline void WriteLE16(unsigned char* data, int16_t value) {
+    data[0] = static_cast<unsigned char>(value);
+    data[1] = static_cast<unsigned char>(static_cast<uint16_t>(value) >> 8);
+}
+
+inline void WriteLE32(unsigned char* data, uint32_t value) {
+    data[0] = static_cast<unsigned char>(value);
+    data[1] = static_cast<unsigned char>(value >> 8);
+    data[2] = static_cast<unsigned char>(value >> 16);
+    data[3] = static_cast<unsigned char>(value >> 24);
+}
+
+inline uint32_t EncodeTouchPoint(const DSTouchPoint& touch) {
+    return (static_cast<uint32_t>(touch.id) & TOUCH_ID_MASK) |
+           (touch.is_active ? 0u : static_cast<uint32_t>(TOUCH_DOWN_BIT)) |
+           ((static_cast<uint32_t>(touch.x) << TOUCH_X_SHIFT) & TOUCH_X_MASK) |
+           ((static_cast<uint32_t>(touch.y) << TOUCH_Y_SHIFT) & TOUCH_Y_MASK);
+}
+
+// Inverse of DecodeInput from the same table (CRC left to the caller)
+template <const InputLayout& Layout>
+void EncodeInput(const DSInputState& state, const RawMotion& motion, uint8_t sequence, unsigned char* report) {
+    memset(report, 0, Layout.report_size);
+    report[0] = Layout.report_id;
+    if (Layout.report_id == 0x11) {
+        report[1] = 0xC0;   // DS4 BT: HID + CRC flags
+    }
+
+    report[Layout.stick_lx] = state.stick_lx;
+    report[Layout.stick_ly] = state.stick_ly;
+    report[Layout.stick_rx] = state.stick_rx;
+    report[Layout.stick_ry] = state.stick_ry;
+    report[Layout.trigger_l2] = state.trigger_l2;
+    report[Layout.trigger_r2] = state.trigger_r2;
+
+    const unsigned int dpad = (state.button_dpad_up ? BTN_DPAD_UP : 0) |
+                              (state.button_dpad_down ? BTN_DPAD_DOWN : 0) |
+                              (state.button_dpad_left ? BTN_DPAD_LEFT : 0) |
+                              (state.button_dpad_right ? BTN_DPAD_RIGHT : 0);
+    report[Layout.dpad] = HAT_FROM_DPAD[dpad];
+
+    for (const ButtonField& button : Layout.buttons) {
+        if (state.*button.field) {
+            report[button.byte] |= button.mask;
+        }
+    }
+    report[Layout.sequence] |= static_cast<uint8_t>(sequence << Layout.sequence_shift);
+
+    report[Layout.status] = EncodeBatteryStatus(Layout.battery, state.battery_level, state.battery_charging);
+
+    WriteLE32(&report[Layout.touch1], EncodeTouchPoint(state.touch1));
+    WriteLE32(&report[Layout.touch2], EncodeTouchPoint(state.touch2));
+
+    for (int axis = 0; axis < 3; axis++) {
+        WriteLE16(&report[Layout.gyro + axis * 2], motion.gyro[axis]);
+        WriteLE16(&report[Layout.accel + axis * 2], motion.accel[axis]);
+    }
+    if (Layout.timestamp_size == 4) {
+        WriteLE32(&report[Layout.timestamp], motion.timestamp);
+    }
+    else {
+        WriteLE16(&report[Layout.timestamp], static_cast<int16_t>(motion.timestamp));
+    }
+}
+
+// Sensor clock: DualSense 32-bit in 1/3 us ticks, DS4 16-bit in 16/3 us ticks
+// Report counter: DualSense 8 bits, DS4 the upper 6 bits of its byte
+#define DS_FORMAT(layout, bluetooth) \
+    { &DecodeInput<layout>, &EncodeInput<layout>, layout.report_id, layout.report_size, \
+      (layout.timestamp_size == 4) ? 0xFFFFFFFFu : 0xFFFFu, \
+      (layout.timestamp_size == 4) ? (1.0f / 3.0f) : (16.0f / 3.0f), \
+      bluetooth, layout.sequence, layout.sequence_shift, \
+      static_cast<uint8_t>(0xFF >> layout.sequence_shift) }
+
+constexpr InputFormat INPUT_FORMATS[3][2] = {
+    // DS_DEVICE_DUALSENSE
+    { DS_FORMAT(DUALSENSE_USB, false), DS_FORMAT(DUALSENSE_BT, true) },
+    // DS_DEVICE_DUALSENSE_EDGE
+    { DS_FORMAT(DUALSENSE_EDGE_USB, false), DS_FORMAT(DUALSENSE_EDGE_BT, true) },
+    // DS_DEVICE_DUALSHOCK4
+    { DS_FORMAT(DUALSHOCK4_USB, false), DS_FORMAT(DUALSHOCK4_BT, true) },
+};
+
+#undef DS_FORMAT
+
+} // anonymous namespace
+
+const InputFormat* GetInputFormat(int device_type, int connection_type) {
+    if (device_type < DS_DEVICE_DUALSENSE || device_type > DS_DEVICE_DUALSHOCK4) {
+        return nullptr;
+    }
+    if (connection_type != DS_CONNECTION_USB && connection_type != DS_CONNECTION_BLUETOOTH) {
+        return nullptr;
+    }
+    return &INPUT_FORMATS[device_type][connection_type];
+}
+
+// Reference: orig/WindowsDualsense_ds5w/Private/Core/DualSense/DualSenseLibrary.cpp:260-305
+DSTouchPoint ParseTouchPoint(const unsigned char* hid_input, size_t offset) {
+    DSTouchPoint touch = {};
+
+    // Read 4 bytes as 32-bit integer (little-endian)
+    uint32_t raw;
+    memcpy(&raw, &hid_input[offset], sizeof(raw));
+
+    // Extract fields using bit manipulation
+    touch.id = (raw & TOUCH_ID_MASK) % 10;
+    touch.is_active = (raw & TOUCH_DOWN_BIT) == 0;  // 0=down, 1=up
+    touch.x = static_cast<uint16_t>((raw & TOUCH_X_MASK) >> TOUCH_X_SHIFT);
+    touch.y = static_cast<uint16_t>((raw & TOUCH_Y_MASK) >> TOUCH_Y_SHIFT);
+
+    return touch;
+}
+
+} // namespace protocol
+} // namespace dualsense
@@ -0,0 +1,55 @@
+// DualSense / DualShock 4 Input Report Decoder
+// Decoders are generated from constexpr layout tables, one per model and transport
+
+#pragma once
+
+#include "../../include/dualsense.h"
+#include <stddef.h>
+#include <stdint.h>
+
+namespace dualsense {
+namespace protocol {
+
+// Raw IMU sample as sent by the device (before calibration)
+struct RawMotion {
+    int16_t gyro[3];        // Pitch, yaw, roll
+    int16_t accel[3];       // X, Y, Z
+    uint32_t timestamp;     // Sensor clock ticks (wraps, see InputFormat)
+};
+
+// Decode a raw input report (report ID at byte 0) into the public input state
+// Motion fields of out_state are left zero; the raw sample goes to out_motion.
+using InputDecoder = void (*)(const unsigned char* report, DSInputState* out_state, RawMotion* out_motion);
+
+// Encode the public input state and a raw motion sample into a report of
+// report_size bytes (inverse of InputDecoder; the Bluetooth CRC is not
+// written). sequence is the report counter (6 bits on DS4).
+using InputEncoder = void (*)(const DSInputState& state, const RawMotion& motion, uint8_t sequence, unsigned char* report);
+
+// Input report format for one model/transport pair
+struct InputFormat {
+    InputDecoder decode;
+    InputEncoder encode;
+    uint8_t report_id;
+    uint8_t report_size;
+    uint32_t timestamp_mask;    // Valid bits of RawMotion::timestamp
+    float timestamp_tick_us;    // Microseconds per sensor clock tick
+    bool has_crc;               // Last 4 bytes are a CRC32 seeded with 0xA1 (Bluetooth)
+    uint8_t sequence_offset;    // Byte holding the report counter
+    uint8_t sequence_shift;     // Counter bits start here
+    uint8_t sequence_mask;      // Counter bits after shifting (0xFF DualSense, 0x3F DS4)
+};
+
+// Report counter of a raw report (wraps at sequence_mask)
+inline uint8_t ReadSequence(const InputFormat& format, const unsigned char* report) {
+    return static_cast<uint8_t>((report[format.sequence_offset] >> format.sequence_shift) & format.sequence_mask);
+}
+
+// Select the input format for a device (nullptr if unsupported)
+const InputFormat* GetInputFormat(int device_type, int connection_type);
+
+// Parse a single touch point from HID input buffer
+DSTouchPoint ParseTouchPoint(const unsigned char* hid_input, size_t offset);
+
+} // namespace protocol
+} // namespace dualsense
@@ -0,0 +1,122 @@
+// Input Report Sequence Tracking
+
+#include "input_sequence.h"
+#include <algorithm>
+#include <cmath>
+
+namespace dualsense {
+namespace protocol {
+
+namespace {
+
+// Weight of a new sample in the smoothed device period
+constexpr float DEVICE_INTERVAL_SMOOTHING = 1.0f / 16.0f;
+
+// Steps this short cannot hide a counter wrap, so they also measure the period
+constexpr uint32_t DEVICE_INTERVAL_MAX_REPORTS = 4;
+
+// A report can only be older than the previous one by this much (and must
+// arrive within it); anything else is newer, past a clock wrap
+constexpr float REORDER_WINDOW_US = 50000.0f;
+
+} // anonymous namespace
+
+void SequenceTracker::Reset() {
+    has_previous_ = false;
+    device_interval_us_ = 0.0f;
+}
+
+SequenceStep SequenceTracker::Track(const InputFormat& format, const unsigned char* report, uint32_t timestamp,
+                                    int64_t arrival_us) {
+    SequenceStep step = {};
+    const uint8_t sequence = ReadSequence(format, report);
+
+    if (!has_previous_) {
+        step.result = SequenceResult::First;
+        has_previous_ = true;
+        sequence_ = sequence;
+        timestamp_ = timestamp;
+        arrival_us_ = arrival_us;
+        return step;
+    }
+
+    // Both counters wrap; the DS4 clock every ~350 ms, so a stall can make a
+    // newer report look older. Only a short step back with the host clock
+    // also saying "just now" is a reordered report.
+    const uint32_t counter_step = static_cast<uint32_t>(sequence - sequence_) & format.sequence_mask;
+    const uint32_t clock_ticks = (timestamp - timestamp_) & format.timestamp_mask;
+    const bool clock_running = clock_ticks != 0;
+    const float clock_span_us = (static_cast<float>(format.timestamp_mask) + 1.0f) * format.timestamp_tick_us;
+    const float host_us = static_cast<float>(arrival_us - arrival_us_);
+
+    const float back_us = static_cast<float>(format.timestamp_mask + 1u - clock_ticks) * format.timestamp_tick_us;
+    const bool duplicate = !clock_running && counter_step == 0;
+    const bool reordered = clock_running ? back_us <= REORDER_WINDOW_US && host_us < REORDER_WINDOW_US
+                                         : counter_step > format.sequence_mask / 2u;
+    if (duplicate || reordered) {
+        // Keep comparing against the newest report seen
+        step.result = duplicate ? SequenceResult::Duplicate : SequenceResult::Reordered;
+        step.device_interval_us = static_cast<uint32_t>(std::lround(device_interval_us_));
+        return step;
+    }
+
+    // The clock wraps too. Host time says roughly how often, but it also holds
+    // the time reports waited in the OS queue, so once the period is known the
+    // report counter picks between the neighbouring wrap counts.
+    float device_us = static_cast<float>(clock_ticks) * format.timestamp_tick_us;
+    if (clock_running && host_us > device_us + clock_span_us / 2.0f) {
+        const float host_wraps = std::round((host_us - device_us) / clock_span_us);
+        float wraps = host_wraps;
+        if (device_interval_us_ > 0.0f) {
+            uint32_t best_distance = UINT32_MAX;
+            for (float candidate = std::max(host_wraps - 1.0f, 0.0f); candidate <= host_wraps + 1.0f; candidate++) {
+                const float candidate_us = device_us + candidate * clock_span_us;
+                const uint32_t candidate_step = static_cast<uint32_t>(std::lround(candidate_us / device_interval_us_)) &
+                                                format.sequence_mask;
+                const uint32_t ahead = (candidate_step - counter_step) & format.sequence_mask;
+                const uint32_t distance = std::min(ahead, format.sequence_mask + 1u - ahead);
+                if (distance < best_distance) {
+                    best_distance = distance;
+                    wraps = candidate;
+                }
+            }
+        }
+        device_us += wraps * clock_span_us;
+    }
+
+    // The counter is short (64 reports on DS4); past that only the clock can tell
+    uint32_t reports = counter_step;
+    if (clock_running && device_interval_us_ > 0.0f) {
+        const uint32_t clock_reports = static_cast<uint32_t>(std::lround(device_us / device_interval_us_));
+        if (clock_reports > format.sequence_mask || counter_step == 0) {
+            reports = clock_reports;
+        }
+    }
+    if (reports == 0) {
+        reports = 1;
+    }
+
+    step.result = SequenceResult::InOrder;
+    step.missing = reports - 1;
+
+    if (clock_running) {
+        if (reports <= DEVICE_INTERVAL_MAX_REPORTS) {
+            const float sample_us = device_us / static_cast<float>(reports);
+            device_interval_us_ = (device_interval_us_ > 0.0f)
+                ? device_interval_us_ + (sample_us - device_interval_us_) * DEVICE_INTERVAL_SMOOTHING
+                : sample_us;
+        }
+
+        step.has_jitter = true;
+        step.jitter_us = static_cast<uint32_t>(std::lround(std::fabs(host_us - device_us)));
+    }
+    step.device_interval_us = static_cast<uint32_t>(std::lround(device_interval_us_));
+
+    sequence_ = sequence;
+    timestamp_ = timestamp;
+    arrival_us_ = arrival_us;
+    return step;
+}
+
+} // namespace protocol
+} // namespace dualsense
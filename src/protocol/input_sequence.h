@@ -0,0 +1,50 @@
+// Input Report Sequence Tracking
+// Follows the report counter and sensor clock of consecutive input reports
+// to tell lost, repeated and out-of-order reports apart, and compares the
+// host arrival spacing with the device's own spacing (transport jitter)
+
+#pragma once
+
+#include "input_parser.h"
+#include <stdint.h>
+
+namespace dualsense {
+namespace protocol {
+
+enum class SequenceResult : uint8_t {
+    First,          // No previous report to compare with
+    InOrder,        // Next report, possibly after a gap
+    Duplicate,      // Same counter and sensor time as the previous report
+    Reordered       // Older than the previous report (not tracked further)
+};
+
+struct SequenceStep {
+    SequenceResult result;
+    uint32_t missing;               // Reports lost before this one (InOrder)
+    bool has_jitter;                // jitter_us is valid (InOrder)
+    uint32_t jitter_us;             // |host interval - device interval| since the previous report
+    uint32_t device_interval_us;    // Smoothed device report period (0 until measured)
+};
+
+// One instance per device, fed from the input path only
+class SequenceTracker {
+public:
+    // Forget the previous report and the measured period (new connection)
+    void Reset();
+
+    // Classify a validated report; arrival_us is the host steady clock, which
+    // also tells how often the sensor clock wrapped during a stall
+    // Until the period has been measured, a gap longer than the counter range
+    // (64 reports on DS4) is undercounted by whole wraps.
+    SequenceStep Track(const InputFormat& format, const unsigned char* report, uint32_t timestamp, int64_t arrival_us);
+
+private:
+    bool has_previous_ = false;
+    uint8_t sequence_ = 0;
+    uint32_t timestamp_ = 0;
+    int64_t arrival_us_ = 0;
+    float device_interval_us_ = 0.0f;
+};
+
+} // namespace protocol
+} // namespace dualsense
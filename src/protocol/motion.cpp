@@ -0,0 +1,277 @@
+// IMU Calibration and Orientation Fusion
+
+#include "motion.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace dualsense {
+namespace protocol {
+
+namespace {
+
+// Feature report sizes (including report ID)
+constexpr size_t CALIBRATION_REPORT_SIZE = CALIBRATION_REPORT_MAX_SIZE;
+constexpr size_t CALIBRATION_REPORT_SIZE_DS4_USB = 37;
+
+constexpr float DEG_TO_RAD = 3.14159265358979f / 180.0f;
+
+// Largest sensor-clock step that is integrated (longer gaps are skipped)
+constexpr float MAX_STEP_S = 0.1f;
+
+// Proportional gain pulling the gyro-integrated attitude towards gravity
+constexpr float FUSION_KP = 0.5f;
+
+// Accelerometer is trusted for tilt correction only near 1 g
+constexpr float ACCEL_TRUST_G = 0.25f;
+
+// Stillness detection for online gyro bias estimation
+constexpr float STILL_GYRO_DPS = 4.0f;
+constexpr float STILL_ACCEL_G = 0.05f;
+constexpr float STILL_SETTLE_S = 0.5f;
+constexpr float BIAS_TIME_CONSTANT_S = 2.0f;
+
+inline int16_t ReadLE16(const unsigned char* data) {
+    return static_cast<int16_t>(static_cast<uint16_t>(data[0] | (data[1] << 8)));
+}
+
+inline void WriteLE16(unsigned char* data, int16_t value) {
+    data[0] = static_cast<unsigned char>(value);
+    data[1] = static_cast<unsigned char>(static_cast<uint16_t>(value) >> 8);
+}
+
+} // anonymous namespace
+
+size_t PrepareCalibrationReport(int device_type, int connection_type, unsigned char* buffer) {
+    const bool ds4_usb = (device_type == DS_DEVICE_DUALSHOCK4 && connection_type == DS_CONNECTION_USB);
+
+    buffer[0] = ds4_usb ? 0x02 : 0x05;
+    return ds4_usb ? CALIBRATION_REPORT_SIZE_DS4_USB : CALIBRATION_REPORT_SIZE;
+}
+
+size_t WriteNominalCalibrationReport(int device_type, int connection_type, unsigned char* buffer) {
+    const bool ds4_usb = (device_type == DS_DEVICE_DUALSHOCK4 && connection_type == DS_CONNECTION_USB);
+    const size_t size = PrepareCalibrationReport(device_type, connection_type, buffer);
+    memset(&buffer[1], 0, size - 1);
+
+    // Gyro: zero bias, +/-16384 LSB at +/-1000 deg/s
+    for (int axis = 0; axis < 3; axis++) {
+        const size_t plus = ds4_usb ? 7 + axis * 2 : 7 + axis * 4;
+        const size_t minus = ds4_usb ? 13 + axis * 2 : 9 + axis * 4;
+        WriteLE16(&buffer[plus], 16384);
+        WriteLE16(&buffer[minus], -16384);
+    }
+    WriteLE16(&buffer[19], 1000);
+    WriteLE16(&buffer[21], 1000);
+
+    // Accelerometer: +/-8192 LSB at +/-1 g
+    for (int axis = 0; axis < 3; axis++) {
+        WriteLE16(&buffer[23 + axis * 4], 8192);
+        WriteLE16(&buffer[25 + axis * 4], -8192);
+    }
+    return size;
+}
+
+bool ReadImuCalibration(hid::Transport& transport, int device_type, int connection_type,
+                        ImuCalibration* out_calibration) {
+    *out_calibration = ImuCalibration();
+
+    const bool ds4_usb = (device_type == DS_DEVICE_DUALSHOCK4 && connection_type == DS_CONNECTION_USB);
+
+    unsigned char buffer[CALIBRATION_REPORT_SIZE] = {};
+    const size_t size = PrepareCalibrationReport(device_type, connection_type, buffer);
+
+    if (!transport.GetFeature(buffer, size)) {
+        printf("MotionProcessor: Failed to read calibration report 0x%02X\n", buffer[0]);
+        return false;
+    }
+
+    const int gyro_bias[3] = { ReadLE16(&buffer[1]), ReadLE16(&buffer[3]), ReadLE16(&buffer[5]) };
+    int gyro_plus[3];
+    int gyro_minus[3];
+
+    if (ds4_usb) {
+        // DS4 USB orders all plus values before all minus values
+        gyro_plus[0] = ReadLE16(&buffer[7]);
+        gyro_plus[1] = ReadLE16(&buffer[9]);
+        gyro_plus[2] = ReadLE16(&buffer[11]);
+        gyro_minus[0] = ReadLE16(&buffer[13]);
+        gyro_minus[1] = ReadLE16(&buffer[15]);
+        gyro_minus[2] = ReadLE16(&buffer[17]);
+    }
+    else {
+        gyro_plus[0] = ReadLE16(&buffer[7]);
+        gyro_minus[0] = ReadLE16(&buffer[9]);
+        gyro_plus[1] = ReadLE16(&buffer[11]);
+        gyro_minus[1] = ReadLE16(&buffer[13]);
+        gyro_plus[2] = ReadLE16(&buffer[15]);
+        gyro_minus[2] = ReadLE16(&buffer[17]);
+    }
+
+    const int gyro_speed_2x = ReadLE16(&buffer[19]) + ReadLE16(&buffer[21]);
+
+    for (int axis = 0; axis < 3; axis++) {
+        const int denom = std::abs(gyro_plus[axis] - gyro_bias[axis]) +
+                          std::abs(gyro_minus[axis] - gyro_bias[axis]);
+        if (denom == 0 || gyro_speed_2x == 0) {
+            printf("MotionProcessor: Invalid gyro calibration, using nominal scale\n");
+            continue;
+        }
+        out_calibration->gyro_bias[axis] = static_cast<float>(gyro_bias[axis]);
+        out_calibration->gyro_scale[axis] = static_cast<float>(gyro_speed_2x) / static_cast<float>(denom);
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        const int plus = ReadLE16(&buffer[23 + axis * 4]);
+        const int minus = ReadLE16(&buffer[25 + axis * 4]);
+        const int range_2g = plus - minus;
+        if (range_2g == 0) {
+            printf("MotionProcessor: Invalid accelerometer calibration, using nominal scale\n");
+            continue;
+        }
+        out_calibration->accel_bias[axis] = static_cast<float>(plus) - static_cast<float>(range_2g) / 2.0f;
+        out_calibration->accel_scale[axis] = 2.0f / static_cast<float>(range_2g);
+    }
+
+    return true;
+}
+
+void MotionProcessor::Reset() {
+    q_[0] = 1.0f;
+    q_[1] = q_[2] = q_[3] = 0.0f;
+    has_orientation_ = false;
+
+    gyro_bias_[0] = gyro_bias_[1] = gyro_bias_[2] = 0.0f;
+    still_time_s_ = 0.0f;
+
+    has_timestamp_ = false;
+    last_timestamp_ = 0;
+    elapsed_ticks_ = 0;
+}
+
+void MotionProcessor::SetCalibration(const ImuCalibration& calibration) {
+    calibration_ = calibration;
+}
+
+void MotionProcessor::Process(const RawMotion& raw, const InputFormat& format, DSInputState* out_state) {
+    // Integration step from the device sensor clock (immune to host scheduling jitter)
+    float dt = 0.0f;
+    if (has_timestamp_) {
+        const uint32_t delta = (raw.timestamp - last_timestamp_) & format.timestamp_mask;
+        elapsed_ticks_ += delta;
+        dt = static_cast<float>(delta) * format.timestamp_tick_us * 1e-6f;
+        if (dt > MAX_STEP_S) {
+            dt = 0.0f;
+        }
+    }
+    has_timestamp_ = true;
+    last_timestamp_ = raw.timestamp;
+
+    float gyro[3];
+    float accel[3];
+    for (int axis = 0; axis < 3; axis++) {
+        gyro[axis] = (raw.gyro[axis] - calibration_.gyro_bias[axis]) * calibration_.gyro_scale[axis];
+        accel[axis] = (raw.accel[axis] - calibration_.accel_bias[axis]) * calibration_.accel_scale[axis];
+    }
+
+    const float accel_norm = std::sqrt(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+
+    // Online gyro bias: when the controller rests, the remaining rate is bias
+    const float rest_rate = std::fmax(std::fabs(gyro[0] - gyro_bias_[0]),
+        std::fmax(std::fabs(gyro[1] - gyro_bias_[1]), std::fabs(gyro[2] - gyro_bias_[2])));
+
+    if (rest_rate < STILL_GYRO_DPS && std::fabs(accel_norm - 1.0f) < STILL_ACCEL_G) {
+        still_time_s_ += dt;
+        if (still_time_s_ >= STILL_SETTLE_S) {
+            const float alpha = dt / BIAS_TIME_CONSTANT_S;
+            for (int axis = 0; axis < 3; axis++) {
+                gyro_bias_[axis] += alpha * (gyro[axis] - gyro_bias_[axis]);
+            }
+        }
+    }
+    else {
+        still_time_s_ = 0.0f;
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        gyro[axis] -= gyro_bias_[axis];
+    }
+
+    float& qw = q_[0];
+    float& qx = q_[1];
+    float& qy = q_[2];
+    float& qz = q_[3];
+
+    if (!has_orientation_ && accel_norm > 0.0f) {
+        // Seed attitude with the shortest rotation taking measured gravity to world +Y
+        const float ax = accel[0] / accel_norm;
+        const float ay = accel[1] / accel_norm;
+        const float az = accel[2] / accel_norm;
+        if (ay > -0.999f) {
+            qw = 1.0f + ay;
+            qx = -az;
+            qy = 0.0f;
+            qz = ax;
+        }
+        else {
+            qw = 0.0f;
+            qx = 1.0f;
+            qy = 0.0f;
+            qz = 0.0f;
+        }
+        has_orientation_ = true;
+    }
+    else if (dt > 0.0f) {
+        float wx = gyro[0] * DEG_TO_RAD;
+        float wy = gyro[1] * DEG_TO_RAD;
+        float wz = gyro[2] * DEG_TO_RAD;
+
+        if (std::fabs(accel_norm - 1.0f) < ACCEL_TRUST_G) {
+            // Error between measured and estimated gravity (both in device frame)
+            const float ax = accel[0] / accel_norm;
+            const float ay = accel[1] / accel_norm;
+            const float az = accel[2] / accel_norm;
+            const float vx = 2.0f * (qx * qy + qw * qz);
+            const float vy = 1.0f - 2.0f * (qx * qx + qz * qz);
+            const float vz = 2.0f * (qy * qz - qw * qx);
+            wx += FUSION_KP * (ay * vz - az * vy);
+            wy += FUSION_KP * (az * vx - ax * vz);
+            wz += FUSION_KP * (ax * vy - ay * vx);
+        }
+
+        // q += 0.5 * q * (0, w) * dt
+        const float half_dt = 0.5f * dt;
+        const float dw = -qx * wx - qy * wy - qz * wz;
+        const float dx = qw * wx + qy * wz - qz * wy;
+        const float dy = qw * wy - qx * wz + qz * wx;
+        const float dz = qw * wz + qx * wy - qy * wx;
+        qw += dw * half_dt;
+        qx += dx * half_dt;
+        qy += dy * half_dt;
+        qz += dz * half_dt;
+    }
+
+    const float q_norm = std::sqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+    if (q_norm > 0.0f) {
+        qw /= q_norm;
+        qx /= q_norm;
+        qy /= q_norm;
+        qz /= q_norm;
+    }
+
+    out_state->gyro_x = gyro[0];
+    out_state->gyro_y = gyro[1];
+    out_state->gyro_z = gyro[2];
+    out_state->accel_x = accel[0];
+    out_state->accel_y = accel[1];
+    out_state->accel_z = accel[2];
+    out_state->orientation_w = qw;
+    out_state->orientation_x = qx;
+    out_state->orientation_y = qy;
+    out_state->orientation_z = qz;
+    out_state->sensor_timestamp_us = static_cast<uint64_t>(
+        static_cast<double>(elapsed_ticks_) * format.timestamp_tick_us);
+}
+
+} // namespace protocol
+} // namespace dualsense
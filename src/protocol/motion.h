@@ -0,0 +1,70 @@
+// IMU Calibration and Orientation Fusion
+// Calibration layout: https://github.com/torvalds/linux/blob/master/drivers/hid/hid-playstation.c
+
+#pragma once
+
+#include "input_parser.h"
+#include "../hid/transport.h"
+#include "../../include/dualsense.h"
+#include <stdint.h>
+
+namespace dualsense {
+namespace protocol {
+
+// Per-axis linear calibration: value = (raw - bias) * scale
+struct ImuCalibration {
+    float gyro_bias[3] = { 0.0f, 0.0f, 0.0f };
+    float gyro_scale[3] = { 2000.0f / 32768.0f, 2000.0f / 32768.0f, 2000.0f / 32768.0f };   // deg/s per LSB
+    float accel_bias[3] = { 0.0f, 0.0f, 0.0f };
+    float accel_scale[3] = { 1.0f / 8192.0f, 1.0f / 8192.0f, 1.0f / 8192.0f };             // g per LSB
+};
+
+// Set buffer[0] to the ID of the calibration feature report and return its
+// size (including the ID); buffer must hold CALIBRATION_REPORT_MAX_SIZE bytes
+constexpr size_t CALIBRATION_REPORT_MAX_SIZE = 41;
+size_t PrepareCalibrationReport(int device_type, int connection_type, unsigned char* buffer);
+
+// Fill a calibration report whose scales equal ImuCalibration's nominal ones
+// (as served by the emulator) and return its size
+size_t WriteNominalCalibrationReport(int device_type, int connection_type, unsigned char* buffer);
+
+// Read the factory calibration feature report and parse it into out_calibration
+// DualSense and DS4 over BT use report 0x05, which also switches BT into full
+// input reports; DS4 over USB uses report 0x02. Nominal scales are kept on failure.
+bool ReadImuCalibration(hid::Transport& transport, int device_type, int connection_type,
+                        ImuCalibration* out_calibration);
+
+// Calibrates raw IMU samples and fuses them into an orientation quaternion
+// Runs once per input report with fixed cost (complementary/Mahony filter).
+// The integration step comes from the device sensor clock and gyro bias is
+// re-estimated whenever the controller is held still.
+class MotionProcessor {
+public:
+    // Reset filter state (orientation, bias, clock)
+    void Reset();
+
+    // Set calibration used for subsequent samples
+    void SetCalibration(const ImuCalibration& calibration);
+
+    // Process one sample and fill the motion fields of out_state
+    void Process(const RawMotion& raw, const InputFormat& format, DSInputState* out_state);
+
+private:
+    ImuCalibration calibration_;
+
+    // Orientation (device to world, world +Y = up)
+    float q_[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    bool has_orientation_ = false;
+
+    // Online gyro bias estimate (deg/s) and how long the device has been still
+    float gyro_bias_[3] = { 0.0f, 0.0f, 0.0f };
+    float still_time_s_ = 0.0f;
+
+    // Sensor clock unwrapping
+    bool has_timestamp_ = false;
+    uint32_t last_timestamp_ = 0;
+    uint64_t elapsed_ticks_ = 0;
+};
+
+} // namespace protocol
+} // namespace dualsense
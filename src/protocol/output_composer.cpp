@@ -4,220 +4,275 @@
 
 #include "output_composer.h"
 #include "crc32.h"
-#include "../hid/windows_hid.h"
 #include "../hid/hid_constants.h"
 #include "../../include/dualsense.h"
+#include <array>
 #include <cstring>
-#include <cstdio>
 
 namespace dualsense {
 namespace protocol {
 
-void OutputDualShock(DeviceContext* device_context) {
-    const OutputContext* hid_out = &device_context->output;
+namespace {
 
-    size_t padding = (device_context->connection_type == DS_CONNECTION_BLUETOOTH) ? 2 : 1;
-    device_context->buffer_output[0] = (device_context->connection_type == DS_CONNECTION_BLUETOOTH) ? 0x11 : 0x05;
+// Largest output report (DualSense/DS4 over Bluetooth, CRC included)
+constexpr size_t MAX_OUTPUT_REPORT_SIZE = 78;
 
-    if (device_context->connection_type == DS_CONNECTION_BLUETOOTH) {
-        device_context->buffer_output[1] = 0xc0;
-    }
+using ReportTemplate = std::array<unsigned char, MAX_OUTPUT_REPORT_SIZE>;
 
-    unsigned char* output = &device_context->buffer_output[padding];
+// Pre-filled DualSense report: report ID, BT header and constant flag bytes
+// USB report 0x02 (payload at 1), BT report 0x31 (payload at 2)
+constexpr ReportTemplate MakeDualSenseTemplate(bool bluetooth) {
+    ReportTemplate report{};
+    const size_t payload = bluetooth ? 2 : 1;
+    report[0] = bluetooth ? 0x31 : 0x02;
+    if (bluetooth) {
+        report[1] = 0x02;
+    }
+    report[payload + 38] = 0x07;
+    report[payload + 41] = 0x02;
+    return report;
+}
 
-    if (device_context->connection_type == DS_CONNECTION_BLUETOOTH) {
-        output[0] = 0x20;
-        output[1] = 0x07;
+// Pre-filled DualShock 4 report: USB report 0x05, BT report 0x11
+constexpr ReportTemplate MakeDualShockTemplate(bool bluetooth) {
+    ReportTemplate report{};
+    if (bluetooth) {
+        report[0] = 0x11;
+        report[1] = 0xc0;
+        report[2] = 0x20;
+        report[3] = 0x07;
     }
     else {
-        output[0] = 0xff;
+        report[0] = 0x05;
+        report[1] = 0xff;
     }
+    return report;
+}
 
-    output[3 + (padding - 1)] = hid_out->rumbles.left;
-    output[4 + (padding - 1)] = hid_out->rumbles.right;
-    output[5 + (padding - 1)] = hid_out->lightbar.r;
-    output[6 + (padding - 1)] = hid_out->lightbar.g;
-    output[7 + (padding - 1)] = hid_out->lightbar.b;
-    output[8 + (padding - 1)] = hid_out->flash_lightbar.bright_time;
-    output[9 + (padding - 1)] = hid_out->flash_lightbar.toggle_time;
+constexpr ReportTemplate DUALSENSE_TEMPLATES[2] = { MakeDualSenseTemplate(false), MakeDualSenseTemplate(true) };
+constexpr ReportTemplate DUALSHOCK_TEMPLATES[2] = { MakeDualShockTemplate(false), MakeDualShockTemplate(true) };
 
-    if (device_context->connection_type == DS_CONNECTION_BLUETOOTH) {
-        const uint32_t crc_checksum = ComputeCRC32(device_context->buffer_output, 74);
-        device_context->buffer_output[0x4A] = static_cast<unsigned char>((crc_checksum & 0x000000FF) >> 0);
-        device_context->buffer_output[0x4B] = static_cast<unsigned char>((crc_checksum & 0x0000FF00) >> 8);
-        device_context->buffer_output[0x4C] = static_cast<unsigned char>((crc_checksum & 0x00FF0000) >> 16);
-        device_context->buffer_output[0x4D] = static_cast<unsigned char>((crc_checksum & 0xFF000000) >> 24);
+// Bytes composed before the CRC (USB reports have none)
+constexpr size_t ComposedSize(size_t report_size, bool bluetooth) {
+    return bluetooth ? report_size - 4 : report_size;
+}
+
+template <bool Bluetooth>
+size_t ComposeDualSense(const OutputContext& hid_out, unsigned char* buffer) {
+    constexpr size_t REPORT_SIZE = Bluetooth ? 78 : 74;
+    constexpr size_t PAYLOAD = Bluetooth ? 2 : 1;
+
+    memcpy(buffer, DUALSENSE_TEMPLATES[Bluetooth].data(), ComposedSize(REPORT_SIZE, Bluetooth));
+
+    unsigned char* output = &buffer[PAYLOAD];
+
+    output[0] = hid_out.feature.vibration_mode;
+    output[1] = hid_out.feature.feature_mode;
+    output[2] = hid_out.rumbles.left;
+    output[3] = hid_out.rumbles.right;
+    output[4] = hid_out.audio.headset_volume;
+    output[5] = hid_out.audio.speaker_volume;
+    output[6] = hid_out.audio.mic_volume;
+    output[7] = hid_out.audio.mode;
+    output[8] = hid_out.mic_light.mode;
+    output[9] = hid_out.audio.mic_status;
+    output[36] = (hid_out.feature.trigger_softness_level << 4) | (hid_out.feature.soft_rumble_reduce & 0x0F);
+    output[42] = hid_out.player_led.brightness;
+    output[43] = hid_out.player_led.led;
+    output[44] = hid_out.lightbar.r;
+    output[45] = hid_out.lightbar.g;
+    output[46] = hid_out.lightbar.b;
+
+    if (hid_out.override_trigger_bytes) {
+        memcpy(&output[10], hid_out.override_trigger_right, 10);
+        memcpy(&output[21], hid_out.override_trigger_left, 10);
+    }
+    else {
+        SetTriggerEffects(&output[10], hid_out.right_trigger);
+        SetTriggerEffects(&output[21], hid_out.left_trigger);
     }
 
-    hid::WriteOutputReport(device_context->handle, device_context->buffer_output,
-        (device_context->connection_type == DS_CONNECTION_BLUETOOTH) ? 78 : 32);
+    return REPORT_SIZE;
 }
 
-void OutputDualSense(DeviceContext* device_context) {
-    const size_t padding = (device_context->connection_type == DS_CONNECTION_BLUETOOTH) ? 2 : 1;
-    device_context->buffer_output[0] = (device_context->connection_type == DS_CONNECTION_BLUETOOTH) ? 0x31 : 0x02;
+template <bool Bluetooth>
+size_t ComposeDualShock(const OutputContext& hid_out, unsigned char* buffer) {
+    constexpr size_t REPORT_SIZE = Bluetooth ? 78 : 32;
+    constexpr size_t RUMBLE = Bluetooth ? 6 : 4;
 
-    if (device_context->connection_type == DS_CONNECTION_BLUETOOTH) {
-        device_context->buffer_output[1] = 0x02;
+    memcpy(buffer, DUALSHOCK_TEMPLATES[Bluetooth].data(), ComposedSize(REPORT_SIZE, Bluetooth));
+
+    buffer[RUMBLE + 0] = hid_out.rumbles.left;
+    buffer[RUMBLE + 1] = hid_out.rumbles.right;
+    buffer[RUMBLE + 2] = hid_out.lightbar.r;
+    buffer[RUMBLE + 3] = hid_out.lightbar.g;
+    buffer[RUMBLE + 4] = hid_out.lightbar.b;
+    buffer[RUMBLE + 5] = hid_out.flash_lightbar.bright_time;
+    buffer[RUMBLE + 6] = hid_out.flash_lightbar.toggle_time;
+
+    return REPORT_SIZE;
+}
+
+// Pre-filled haptic report 0x32 (layout from community research, e.g. SAxense):
+//   [1]      sequence << 4
+//   [2..10]  sub-packet 0x11 (sized), 7 bytes of control data
+//   [11..76] sub-packet 0x12 (sized), 64 samples
+//   [138]    CRC32
+constexpr size_t HAPTIC_SEQUENCE = 1;
+constexpr size_t HAPTIC_SAMPLES = 13;
+
+using HapticTemplate = std::array<unsigned char, HAPTIC_REPORT_SIZE>;
+
+constexpr HapticTemplate MakeHapticTemplate() {
+    HapticTemplate report{};
+    report[0] = 0x32;
+    report[2] = 0x80 | 0x11;
+    report[3] = 7;
+    report[4] = 0xFE;
+    report[9] = 0xFF;
+    report[11] = 0x80 | 0x12;
+    report[12] = static_cast<unsigned char>(HAPTIC_SAMPLES_PER_REPORT);
+    return report;
+}
+
+constexpr HapticTemplate HAPTIC_TEMPLATE = MakeHapticTemplate();
+
+#define DS_OUTPUT_FORMAT(composer, templates, size, bluetooth) \
+    { &composer<bluetooth>, templates[bluetooth][0], size, bluetooth }
+
+// Indexed by [DSDeviceType][DSConnectionType]
+constexpr OutputFormat OUTPUT_FORMATS[3][2] = {
+    // DS_DEVICE_DUALSENSE
+    { DS_OUTPUT_FORMAT(ComposeDualSense, DUALSENSE_TEMPLATES, 74, false),
+      DS_OUTPUT_FORMAT(ComposeDualSense, DUALSENSE_TEMPLATES, 78, true) },
+    // DS_DEVICE_DUALSENSE_EDGE
+    { DS_OUTPUT_FORMAT(ComposeDualSense, DUALSENSE_TEMPLATES, 74, false),
+      DS_OUTPUT_FORMAT(ComposeDualSense, DUALSENSE_TEMPLATES, 78, true) },
+    // DS_DEVICE_DUALSHOCK4
+    { DS_OUTPUT_FORMAT(ComposeDualShock, DUALSHOCK_TEMPLATES, 32, false),
+      DS_OUTPUT_FORMAT(ComposeDualShock, DUALSHOCK_TEMPLATES, 78, true) },
+};
+
+#undef DS_OUTPUT_FORMAT
+
+void WriteCRC32(unsigned char* buffer, size_t crc_offset) {
+    const uint32_t crc_checksum = ComputeCRC32(buffer, crc_offset);
+    buffer[crc_offset + 0] = static_cast<unsigned char>((crc_checksum & 0x000000FF) >> 0);
+    buffer[crc_offset + 1] = static_cast<unsigned char>((crc_checksum & 0x0000FF00) >> 8);
+    buffer[crc_offset + 2] = static_cast<unsigned char>((crc_checksum & 0x00FF0000) >> 16);
+    buffer[crc_offset + 3] = static_cast<unsigned char>((crc_checksum & 0xFF000000) >> 24);
+}
+
+void ComposeAndWrite(DeviceContext* device_context) {
+    const OutputFormat* format = GetOutputFormat(device_context->device_type, device_context->connection_type);
+    if (!format) {
+        return;
     }
+    format->compose(device_context->output, device_context->buffer_output);
+    FinalizeOutputReport(*format, device_context->buffer_output);
+    device_context->transport->Write(device_context->buffer_output, format->report_size);
+}
 
-    OutputContext* hid_out = &device_context->output;
-    unsigned char* output = &device_context->buffer_output[padding];
-
-    output[0] = hid_out->feature.vibration_mode;
-    output[1] = hid_out->feature.feature_mode;
-    output[2] = hid_out->rumbles.left;
-    output[3] = hid_out->rumbles.right;
-    output[4] = hid_out->audio.headset_volume;
-    output[5] = hid_out->audio.speaker_volume;
-    output[6] = hid_out->audio.mic_volume;
-    output[7] = hid_out->audio.mode;
-    output[9] = hid_out->audio.mic_status;
-    output[8] = hid_out->mic_light.mode;
-    output[36] = (hid_out->feature.trigger_softness_level << 4) | (hid_out->feature.soft_rumble_reduce & 0x0F);
-    output[38] = 0x07;
-    output[41] = 0x02;
-    output[42] = hid_out->player_led.brightness;
-    output[43] = hid_out->player_led.led;
-    output[44] = hid_out->lightbar.r;
-    output[45] = hid_out->lightbar.g;
-    output[46] = hid_out->lightbar.b;
-
-    if (device_context->override_trigger_bytes) {
-        memcpy(&output[10], device_context->override_trigger_right, 10);
-        memcpy(&output[21], device_context->override_trigger_left, 10);
+} // anonymous namespace
+
+const OutputFormat* GetOutputFormat(int device_type, int connection_type) {
+    if (device_type < DS_DEVICE_DUALSENSE || device_type > DS_DEVICE_DUALSHOCK4) {
+        return nullptr;
     }
-    else {
-        SetTriggerEffects(&output[10], hid_out->right_trigger);
-        SetTriggerEffects(&output[21], hid_out->left_trigger);
+    if (connection_type != DS_CONNECTION_USB && connection_type != DS_CONNECTION_BLUETOOTH) {
+        return nullptr;
     }
+    return &OUTPUT_FORMATS[device_type][connection_type];
+}
 
-    if (device_context->connection_type == DS_CONNECTION_BLUETOOTH) {
-        const uint32_t crc_checksum = ComputeCRC32(device_context->buffer_output, 74);
-        device_context->buffer_output[0x4A] = static_cast<unsigned char>((crc_checksum & 0x000000FF) >> 0);
-        device_context->buffer_output[0x4B] = static_cast<unsigned char>((crc_checksum & 0x0000FF00) >> 8);
-        device_context->buffer_output[0x4C] = static_cast<unsigned char>((crc_checksum & 0x00FF0000) >> 16);
-        device_context->buffer_output[0x4D] = static_cast<unsigned char>((crc_checksum & 0xFF000000) >> 24);
+void FinalizeOutputReport(const OutputFormat& format, unsigned char* buffer) {
+    if (format.has_crc) {
+        WriteCRC32(buffer, format.report_size - 4);
     }
+}
+
+void OutputDualShock(DeviceContext* device_context) {
+    ComposeAndWrite(device_context);
+}
 
-    size_t output_length = (device_context->connection_type == DS_CONNECTION_BLUETOOTH) ? 78 : 74;
-    hid::WriteOutputReport(device_context->handle, device_context->buffer_output, output_length);
+void OutputDualSense(DeviceContext* device_context) {
+    ComposeAndWrite(device_context);
 }
 
-void SetTriggerEffects(unsigned char* trigger, HapticTriggers& effect) {
-    trigger[0x0] = effect.mode;
+void SetTriggerEffects(unsigned char* trigger, const HapticTriggers& effect) {
+    const TriggerStrengths& strengths = effect.strengths;
 
-    if (effect.mode == 0x01) { // Continuous Resistance
-        trigger[0x1] = static_cast<unsigned char>((effect.strengths.active_zones >> 0) & 0xFF);
-        trigger[0x2] = static_cast<unsigned char>((effect.strengths.strength_zones >> 0) & 0xFF);
-    }
+    switch (effect.mode) {
+    case 0x01: // Continuous Resistance
+        trigger[0x0] = effect.mode;
+        trigger[0x1] = static_cast<unsigned char>(strengths.active_zones & 0xFF);
+        trigger[0x2] = static_cast<unsigned char>(strengths.strength_zones & 0xFF);
+        break;
 
-    if (effect.mode == 0x21) { // Resistance
+    case 0x21: // Resistance
+        trigger[0x0] = effect.mode;
         trigger[0x1] = 0xf0;
         trigger[0x2] = 0x03;
-        trigger[0x3] = 0x00;
-        trigger[0x5] = effect.strengths.compose[2];
-        trigger[0x6] = effect.strengths.compose[3];
-        trigger[0x7] = 0x0;
-        trigger[0x8] = 0x0;
-        trigger[0x9] = 0x0;
-    }
+        trigger[0x5] = strengths.compose[2];
+        trigger[0x6] = strengths.compose[3];
+        break;
 
-    if (effect.mode == 0x22 || effect.mode == 0x02) { // Bow
-        trigger[0x1] = effect.strengths.compose[0];
-        trigger[0x2] = effect.strengths.compose[1];
-        trigger[0x3] = effect.strengths.compose[2];
-        trigger[0x4] = 0x0;
-        trigger[0x5] = 0x0;
-        trigger[0x6] = 0x0;
-        trigger[0x7] = 0x0;
-        trigger[0x8] = 0x0;
-        trigger[0x9] = 0x0;
-    }
+    case 0x02: // Bow
+    case 0x22:
+        trigger[0x0] = effect.mode;
+        memcpy(&trigger[0x1], &strengths.compose[0], 3);
+        break;
 
-    if (effect.mode == 0x23) { // Galloping
-        trigger[0x1] = effect.strengths.compose[0];
-        trigger[0x2] = effect.strengths.compose[1];
-        trigger[0x3] = effect.strengths.compose[2];
-        trigger[0x4] = effect.strengths.compose[3];
-        trigger[0x5] = 0x00;
-        trigger[0x6] = 0x00;
-        trigger[0x7] = 0x00;
-        trigger[0x8] = 0x00;
-        trigger[0x9] = 0x00;
-    }
+    case 0x23: // Galloping
+        trigger[0x0] = effect.mode;
+        memcpy(&trigger[0x1], &strengths.compose[0], 4);
+        break;
 
-    if (effect.mode == 0x25) { // Weapon
-        trigger[0x1] = static_cast<unsigned char>((effect.strengths.active_zones >> 0) & 0xFF);
-        trigger[0x2] = static_cast<unsigned char>((effect.strengths.active_zones >> 8) & 0xFF);
+    case 0x25: // Weapon
+        trigger[0x0] = effect.mode;
+        trigger[0x1] = static_cast<unsigned char>(strengths.active_zones & 0xFF);
+        trigger[0x2] = static_cast<unsigned char>((strengths.active_zones >> 8) & 0xFF);
         for (int i = 0; i < 8; ++i) {
-            trigger[0x3 + i] = static_cast<unsigned char>((effect.strengths.strength_zones >> (8 * i)) & 0xFF);
+            trigger[0x3 + i] = static_cast<unsigned char>((strengths.strength_zones >> (8 * i)) & 0xFF);
         }
-    }
+        break;
 
-    if (effect.mode == 0x26) { // Automatic Gun
-        trigger[0x1] = effect.strengths.compose[0];
-        trigger[0x2] = effect.strengths.compose[1];
-        trigger[0x3] = effect.strengths.compose[2];
-        trigger[0x4] = effect.strengths.compose[3];
-        trigger[0x5] = effect.strengths.compose[4];
-        trigger[0x6] = effect.strengths.compose[5];
-        trigger[0x7] = 0x0;
-        trigger[0x8] = 0x0;
-        trigger[0x9] = effect.strengths.compose[9];
-    }
+    case 0x26: // Automatic Gun
+        trigger[0x0] = effect.mode;
+        memcpy(&trigger[0x1], &strengths.compose[0], 6);
+        trigger[0x9] = strengths.compose[9];
+        break;
 
-    if (effect.mode == 0x27) { // Machine Advanced
-        trigger[0x1] = effect.strengths.compose[0]; // Start_Zone
-        trigger[0x2] = effect.strengths.compose[1]; // Behavior_Flag
-        trigger[0x3] = effect.strengths.compose[2]; // Force_Amplitude
-        trigger[0x4] = effect.strengths.compose[3]; // Period
-        trigger[0x5] = effect.strengths.compose[4]; // Frequency
-        trigger[0x6] = 0x00;
-        trigger[0x7] = 0x00;
-        trigger[0x8] = 0x00;
-        trigger[0x9] = 0x00;
-    }
+    case 0x27: // Machine Advanced (start zone, behavior flag, amplitude, period, frequency)
+        trigger[0x0] = effect.mode;
+        memcpy(&trigger[0x1], &strengths.compose[0], 5);
+        break;
 
-    if (effect.mode == 0xFF) { // Custom Mode effect
-        trigger[0x0] = effect.strengths.compose[0];
-        trigger[0x1] = effect.strengths.compose[1];
-        trigger[0x2] = effect.strengths.compose[2];
-        trigger[0x3] = effect.strengths.compose[3];
-        trigger[0x4] = effect.strengths.compose[4];
-        trigger[0x5] = effect.strengths.compose[5];
-        trigger[0x6] = effect.strengths.compose[6];
-        trigger[0x7] = effect.strengths.compose[7];
-        trigger[0x8] = effect.strengths.compose[8];
-        trigger[0x9] = effect.strengths.compose[9];
-    }
+    case 0xFF: // Custom Mode effect
+        memcpy(&trigger[0x0], &strengths.compose[0], 10);
+        break;
 
-    if (effect.mode == 0x0) { // Reset
-        trigger[0x1] = 0x0;
-        trigger[0x2] = 0x0;
-        trigger[0x3] = 0x0;
-        trigger[0x4] = 0x0;
-        trigger[0x5] = 0x0;
-        trigger[0x6] = 0x0;
-        trigger[0x7] = 0x0;
-        trigger[0x8] = 0x0;
-        trigger[0x9] = 0x0;
+    default: // 0x00 Reset and unknown modes only carry the mode byte
+        trigger[0x0] = effect.mode;
+        break;
     }
 }
 
+void ComposeHapticReport(const int8_t* samples, uint8_t sequence, unsigned char* report) {
+    memcpy(report, HAPTIC_TEMPLATE.data(), HAPTIC_REPORT_SIZE - 4);
+    report[HAPTIC_SEQUENCE] = static_cast<unsigned char>((sequence & 0x0F) << 4);
+    memcpy(&report[HAPTIC_SAMPLES], samples, HAPTIC_SAMPLES_PER_REPORT);
+    WriteCRC32(report, HAPTIC_REPORT_SIZE - 4);
+}
+
 void SendAudioHapticAdvanced(DeviceContext* device_context) {
     if (!device_context) {
         return;
     }
 
     if (device_context->connection_type == DS_CONNECTION_BLUETOOTH) {
-        constexpr size_t crc_offset = 138;
-        const uint32_t crc_checksum = ComputeCRC32(device_context->buffer_audio, crc_offset);
-        device_context->buffer_audio[crc_offset + 0] = static_cast<unsigned char>((crc_checksum & 0x000000FF) >> 0);
-        device_context->buffer_audio[crc_offset + 1] = static_cast<unsigned char>((crc_checksum & 0x0000FF00) >> 8);
-        device_context->buffer_audio[crc_offset + 2] = static_cast<unsigned char>((crc_checksum & 0x00FF0000) >> 16);
-        device_context->buffer_audio[crc_offset + 3] = static_cast<unsigned char>((crc_checksum & 0xFF000000) >> 24);
-        hid::WriteAudioHaptic(device_context->handle, device_context->buffer_audio, 142);
+        WriteCRC32(device_context->buffer_audio, 138);
+        device_context->transport->Write(device_context->buffer_audio, 142);
     }
 }
 
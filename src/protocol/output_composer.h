@@ -5,10 +5,31 @@
 #pragma once
 
 #include "../core/device_context.h"
+#include <stddef.h>
+#include <stdint.h>
 
 namespace dualsense {
 namespace protocol {
 
+// Compose an output report into buffer (CRC not yet applied)
+// Only reads hid_out, so it can run on a snapshot outside the device lock.
+// Returns the report length.
+using OutputComposer = size_t (*)(const OutputContext& hid_out, unsigned char* buffer);
+
+// Output report format for one model/transport pair
+struct OutputFormat {
+    OutputComposer compose;
+    uint8_t report_id;
+    uint8_t report_size;    // Bytes sent, including the CRC
+    bool has_crc;           // Last 4 bytes are a CRC32 seeded with 0xA2 (Bluetooth)
+};
+
+// Select the output format for a device (nullptr if unsupported)
+const OutputFormat* GetOutputFormat(int device_type, int connection_type);
+
+// Append the Bluetooth CRC to a composed output report (no-op over USB)
+void FinalizeOutputReport(const OutputFormat& format, unsigned char* buffer);
+
 // Compose and write DualSense output report
 void OutputDualSense(DeviceContext* device_context);
 
@@ -16,10 +37,19 @@ void OutputDualSense(DeviceContext* device_context);
 void OutputDualShock(DeviceContext* device_context);
 
 // Set trigger effect parameters
-void SetTriggerEffects(unsigned char* trigger_bytes, HapticTriggers& effect);
+// trigger_bytes must start zeroed (composers patch a zeroed report template).
+void SetTriggerEffects(unsigned char* trigger_bytes, const HapticTriggers& effect);
 
 // Send audio haptic data (Bluetooth only)
 void SendAudioHapticAdvanced(DeviceContext* device_context);
 
+// Bluetooth audio haptic report 0x32: stereo interleaved int8 samples at 3 kHz
+constexpr size_t HAPTIC_REPORT_SIZE = 142;
+constexpr size_t HAPTIC_SAMPLES_PER_REPORT = 64;    // 32 stereo frames (~10.7 ms)
+
+// Compose a complete haptic report (CRC included) from one packet of samples
+// sequence is a 4-bit counter incremented per report.
+void ComposeHapticReport(const int8_t* samples, uint8_t sequence, unsigned char* report);
+
 } // namespace protocol
 } // namespace dualsense
@@ -0,0 +1,129 @@
+// Analog Response Curves
+
+#include "response_curve.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace dualsense {
+namespace protocol {
+
+namespace {
+
+// Shape of the curve between the thresholds, t in 0-1
+float Shape(const DSResponseCurve& curve, float t) {
+    if (curve.point_count < 2) {
+        return std::pow(t, curve.exponent);
+    }
+
+    const float position = t * static_cast<float>(curve.point_count - 1);
+    const uint32_t index = std::min(static_cast<uint32_t>(position), curve.point_count - 2);
+    const float fraction = position - static_cast<float>(index);
+    return curve.points[index] + (curve.points[index + 1] - curve.points[index]) * fraction;
+}
+
+} // anonymous namespace
+
+DSResponseCurve DefaultResponseCurve() {
+    DSResponseCurve curve = {};
+    curve.outer_threshold = 1.0f;
+    curve.exponent = 1.0f;
+    return curve;
+}
+
+bool IsValidResponseCurve(const DSResponseCurve& curve) {
+    // Written so that NaN fails every check
+    if (!(curve.deadzone >= 0.0f && curve.deadzone < curve.outer_threshold && curve.outer_threshold <= 1.0f)) {
+        return false;
+    }
+    if (!(curve.anti_deadzone >= 0.0f && curve.anti_deadzone < 1.0f)) {
+        return false;
+    }
+    if (curve.point_count > DS_CURVE_MAX_POINTS) {
+        return false;
+    }
+    if (curve.point_count >= 2) {
+        for (uint32_t i = 0; i < curve.point_count; i++) {
+            if (!(curve.points[i] >= 0.0f && curve.points[i] <= 1.0f)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return curve.exponent > 0.0f && std::isfinite(curve.exponent);
+}
+
+bool IsIdentityResponseCurve(const DSResponseCurve& curve) {
+    return curve.deadzone == 0.0f && curve.outer_threshold == 1.0f && curve.anti_deadzone == 0.0f &&
+           curve.point_count < 2 && curve.exponent == 1.0f;
+}
+
+float EvaluateResponseCurve(const DSResponseCurve& curve, float magnitude) {
+    if (magnitude <= curve.deadzone) {
+        return 0.0f;
+    }
+    if (magnitude >= curve.outer_threshold) {
+        return 1.0f;
+    }
+
+    const float t = (magnitude - curve.deadzone) / (curve.outer_threshold - curve.deadzone);
+    return curve.anti_deadzone + (1.0f - curve.anti_deadzone) * Shape(curve, t);
+}
+
+StickTable::StickTable() {
+    Compile(DSStickResponse{ DS_DEADZONE_AXIAL, DefaultResponseCurve() });
+}
+
+void StickTable::Compile(const DSStickResponse& response) {
+    const DSResponseCurve& curve = response.curve;
+
+    for (uint32_t value = 0; value < 256; value++) {
+        const float axis = LinearStickAxis(static_cast<uint8_t>(value));
+        axial_[value] = std::copysign(EvaluateResponseCurve(curve, std::fabs(axis)), axis);
+    }
+    identity_ = response.shape != DS_DEADZONE_RADIAL && IsIdentityResponseCurve(curve);
+
+    if (response.shape != DS_DEADZONE_RADIAL) {
+        radial_scale_.clear();
+        radial_scale_.shrink_to_fit();
+        return;
+    }
+
+    // Output = half units * scale, where scale maps the (clamped) distance
+    // through the curve; each bin is evaluated at its center
+    radial_scale_.resize(RADIAL_TABLE_SIZE);
+    for (size_t index = 0; index < RADIAL_TABLE_SIZE; index++) {
+        const float squared = static_cast<float>((index << RADIAL_TABLE_SHIFT) + (1u << (RADIAL_TABLE_SHIFT - 1)));
+        const float distance = std::sqrt(squared) / 255.0f;
+        radial_scale_[index] = EvaluateResponseCurve(curve, std::min(distance, 1.0f)) / (distance * 255.0f);
+    }
+}
+
+TriggerTable::TriggerTable() {
+    Compile(DefaultResponseCurve());
+}
+
+void TriggerTable::Compile(const DSResponseCurve& curve) {
+    for (uint32_t value = 0; value < 256; value++) {
+        table_[value] = EvaluateResponseCurve(curve, LinearTrigger(static_cast<uint8_t>(value)));
+    }
+    identity_ = IsIdentityResponseCurve(curve);
+}
+
+void AnalogTables::SetStick(uint32_t stick, StickTable table) {
+    sticks_[stick] = std::move(table);
+    UpdateIdentity();
+}
+
+void AnalogTables::SetTrigger(uint32_t trigger, const TriggerTable& table) {
+    triggers_[trigger] = table;
+    UpdateIdentity();
+}
+
+void AnalogTables::UpdateIdentity() {
+    identity_ = sticks_[0].IsIdentity() && sticks_[1].IsIdentity() &&
+                triggers_[0].IsIdentity() && triggers_[1].IsIdentity();
+}
+
+} // namespace protocol
+} // namespace dualsense
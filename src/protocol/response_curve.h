@@ -0,0 +1,122 @@
+// Analog Response Curves
+// Deadzones and response curves compiled into lookup tables, so applying
+// them to a report is a handful of loads and multiplies
+
+#pragma once
+
+#include "../../include/dualsense.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace dualsense {
+namespace protocol {
+
+// Radial table: indexed by the squared distance from center in half units
+// (2 * value - 255 per axis), coarsened by this shift (bins of 16)
+constexpr uint32_t RADIAL_TABLE_SHIFT = 4;
+constexpr size_t RADIAL_TABLE_SIZE = ((2u * 255u * 255u) >> RADIAL_TABLE_SHIFT) + 1;
+
+// Linear, no deadzone
+DSResponseCurve DefaultResponseCurve();
+
+// Whether a curve's parameters are in range
+bool IsValidResponseCurve(const DSResponseCurve& curve);
+
+// Evaluate a (valid) curve at magnitude 0-1
+float EvaluateResponseCurve(const DSResponseCurve& curve, float magnitude);
+
+// Linear with no deadzones, so the output is the input magnitude
+bool IsIdentityResponseCurve(const DSResponseCurve& curve);
+
+// Raw values as the default response outputs them
+inline float LinearStickAxis(uint8_t value) {
+    return static_cast<float>(2 * static_cast<int>(value) - 255) / 255.0f;
+}
+inline float LinearTrigger(uint8_t value) {
+    return static_cast<float>(value) / 255.0f;
+}
+
+// Compiled response of one stick
+class StickTable {
+public:
+    StickTable();
+
+    // response must be valid (see IsValidResponseCurve)
+    void Compile(const DSStickResponse& response);
+
+    // Outputs LinearStickAxis of each axis
+    bool IsIdentity() const { return identity_; }
+
+    void Apply(uint8_t x, uint8_t y, float* out_x, float* out_y) const {
+        if (radial_scale_.empty()) {
+            *out_x = axial_[x];
+            *out_y = axial_[y];
+            return;
+        }
+        const int half_x = 2 * x - 255;
+        const int half_y = 2 * y - 255;
+        const float scale = radial_scale_[static_cast<uint32_t>(half_x * half_x + half_y * half_y) >> RADIAL_TABLE_SHIFT];
+        *out_x = static_cast<float>(half_x) * scale;
+        *out_y = static_cast<float>(half_y) * scale;
+    }
+
+private:
+    float axial_[256];                  // Axial: output per raw axis value
+    std::vector<float> radial_scale_;   // Radial: factor for half units (empty when axial)
+    bool identity_;
+};
+
+// Compiled response of one trigger
+class TriggerTable {
+public:
+    TriggerTable();
+
+    // curve must be valid (see IsValidResponseCurve)
+    void Compile(const DSResponseCurve& curve);
+
+    float Apply(uint8_t value) const { return table_[value]; }
+
+    // Outputs LinearTrigger
+    bool IsIdentity() const { return identity_; }
+
+private:
+    float table_[256];
+    bool identity_;
+};
+
+// Compiled response of both sticks and both triggers of a device
+// Published whole and never modified afterwards, so the input path can read
+// one without a lock while a setter builds its replacement.
+class AnalogTables {
+public:
+    void SetStick(uint32_t stick, StickTable table);
+    void SetTrigger(uint32_t trigger, const TriggerTable& table);
+
+    // Sticks and triggers of state (sensor_timestamp_us is left alone)
+    void Apply(const DSInputState& state, DSAnalogState* out) const {
+        if (identity_) {
+            out->left_x = LinearStickAxis(state.stick_lx);
+            out->left_y = LinearStickAxis(state.stick_ly);
+            out->right_x = LinearStickAxis(state.stick_rx);
+            out->right_y = LinearStickAxis(state.stick_ry);
+            out->l2 = LinearTrigger(state.trigger_l2);
+            out->r2 = LinearTrigger(state.trigger_r2);
+            return;
+        }
+        sticks_[0].Apply(state.stick_lx, state.stick_ly, &out->left_x, &out->left_y);
+        sticks_[1].Apply(state.stick_rx, state.stick_ry, &out->right_x, &out->right_y);
+        out->l2 = triggers_[0].Apply(state.trigger_l2);
+        out->r2 = triggers_[1].Apply(state.trigger_r2);
+    }
+
+private:
+    void UpdateIdentity();
+
+    StickTable sticks_[2];
+    TriggerTable triggers_[2];
+    bool identity_ = true;      // All four at the default: Apply skips the tables
+};
+
+} // namespace protocol
+} // namespace dualsense
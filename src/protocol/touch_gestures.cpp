@@ -0,0 +1,261 @@
+// Touchpad Gesture Recognition
+
+#include "touch_gestures.h"
+#include <algorithm>
+#include <cmath>
+
+namespace dualsense {
+namespace protocol {
+
+namespace {
+
+// Distances in touchpad units (the DualSense pad is 1920 wide, about 30 per mm)
+constexpr float TAP_MAX_TRAVEL = 60.0f;
+constexpr uint64_t TAP_MAX_DURATION_US = 250000;
+constexpr uint64_t DOUBLE_TAP_MAX_GAP_US = 300000;     // First tap lifted to second touch
+constexpr float DOUBLE_TAP_MAX_DISTANCE = 150.0f;
+constexpr float SWIPE_MIN_DISTANCE = 200.0f;
+constexpr float SWIPE_MIN_SPEED = 1000.0f;             // Units per second at lift
+constexpr float TWO_FINGER_SLOP = 60.0f;               // Spread or midpoint travel that starts a pinch/scroll
+
+// Velocity: smoothed over position changes with this time constant; a finger
+// whose position has not changed for VELOCITY_HOLD_US counts as stopped
+constexpr float VELOCITY_TIME_CONSTANT_US = 12000.0f;
+constexpr uint64_t VELOCITY_HOLD_US = 40000;
+
+uint32_t DurationUs(uint64_t from_us, uint64_t to_us) {
+    return (to_us > from_us) ? static_cast<uint32_t>(std::min<uint64_t>(to_us - from_us, UINT32_MAX)) : 0;
+}
+
+} // anonymous namespace
+
+void GestureRecognizer::Reset() {
+    *this = GestureRecognizer();
+}
+
+size_t GestureRecognizer::Process(const DSInputState& state, uint32_t sequence, DSGestureEvent* out) {
+    const uint64_t now_us = state.sensor_timestamp_us;
+    const DSTouchPoint* points[2] = { &state.touch1, &state.touch2 };
+    size_t count = 0;
+
+    // A slot whose finger left, or was replaced by another finger between reports
+    bool lifted[2];
+    for (size_t i = 0; i < 2; i++) {
+        lifted[i] = fingers_[i].active && (!points[i]->is_active || points[i]->id != fingers_[i].id);
+    }
+
+    if (lifted[0] || lifted[1]) {
+        // Reported from the last positions of both fingers
+        if (two_finger_ == TwoFinger::Pinch || two_finger_ == TwoFinger::Scroll) {
+            TwoFingerGesture(DS_GESTURE_PHASE_END, now_us, &out[count++]);
+        }
+        if (two_finger_ != TwoFinger::None) {
+            two_finger_ = TwoFinger::Finished;
+        }
+        for (size_t i = 0; i < 2; i++) {
+            if (!lifted[i]) {
+                continue;
+            }
+            if (session_fingers_ == 1 && LiftGesture(fingers_[i], now_us, &out[count])) {
+                count++;
+            }
+            fingers_[i].active = false;
+        }
+    }
+
+    bool moved = false;
+    uint8_t active = 0;
+    for (size_t i = 0; i < 2; i++) {
+        if (!points[i]->is_active) {
+            continue;
+        }
+        if (fingers_[i].active) {
+            moved |= Move(fingers_[i], *points[i], now_us);
+        }
+        else {
+            Begin(fingers_[i], *points[i], now_us);
+        }
+        active++;
+    }
+
+    if (active == 0) {
+        session_fingers_ = 0;
+        two_finger_ = TwoFinger::None;
+    }
+    session_fingers_ = std::max(session_fingers_, active);
+
+    if (active == 2) {
+        const Finger& a = fingers_[0];
+        const Finger& b = fingers_[1];
+        const float mid_x = (a.x + b.x) * 0.5f;
+        const float mid_y = (a.y + b.y) * 0.5f;
+        const float distance = std::hypot(b.x - a.x, b.y - a.y);
+
+        if (two_finger_ == TwoFinger::None) {
+            two_finger_ = TwoFinger::Pending;
+            two_finger_start_us_ = now_us;
+            base_distance_ = distance;
+            base_x_ = mid_x;
+            base_y_ = mid_y;
+            has_tap_ = false;
+        }
+        else if (two_finger_ == TwoFinger::Pending) {
+            // Decided once, by whichever changed more: spread or midpoint
+            const float spread = std::fabs(distance - base_distance_);
+            const float travel = std::hypot(mid_x - base_x_, mid_y - base_y_);
+            if (std::max(spread, travel) >= TWO_FINGER_SLOP) {
+                two_finger_ = (spread > travel) ? TwoFinger::Pinch : TwoFinger::Scroll;
+                last_x_ = base_x_;
+                last_y_ = base_y_;
+                TwoFingerGesture(DS_GESTURE_PHASE_BEGIN, now_us, &out[count++]);
+            }
+        }
+        else if (moved && (two_finger_ == TwoFinger::Pinch || two_finger_ == TwoFinger::Scroll)) {
+            TwoFingerGesture(DS_GESTURE_PHASE_UPDATE, now_us, &out[count++]);
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        out[i].timestamp_us = now_us;
+        out[i].sequence = sequence;
+    }
+    return count;
+}
+
+void GestureRecognizer::Begin(Finger& finger, const DSTouchPoint& point, uint64_t now_us) {
+    finger = Finger{};
+    finger.active = true;
+    finger.id = point.id;
+    finger.x = finger.start_x = static_cast<float>(point.x);
+    finger.y = finger.start_y = static_cast<float>(point.y);
+    finger.start_us = now_us;
+    finger.moved_us = now_us;
+}
+
+bool GestureRecognizer::Move(Finger& finger, const DSTouchPoint& point, uint64_t now_us) {
+    const float x = static_cast<float>(point.x);
+    const float y = static_cast<float>(point.y);
+    if (x == finger.x && y == finger.y) {
+        return false;
+    }
+
+    // Measured between position changes, so a touch sensor that updates
+    // slower than the report rate does not read as stop-and-go
+    const uint64_t elapsed_us = now_us - finger.moved_us;
+    if (now_us <= finger.moved_us || elapsed_us > VELOCITY_HOLD_US) {
+        // Resting before this (or no clock): the start of the motion is unknown
+        finger.has_velocity = false;
+        finger.velocity_x = 0.0f;
+        finger.velocity_y = 0.0f;
+    }
+    else {
+        const float dt_us = static_cast<float>(elapsed_us);
+        const float sample_x = (x - finger.x) * 1e6f / dt_us;
+        const float sample_y = (y - finger.y) * 1e6f / dt_us;
+        if (finger.has_velocity) {
+            const float weight = dt_us / (VELOCITY_TIME_CONSTANT_US + dt_us);
+            finger.velocity_x += (sample_x - finger.velocity_x) * weight;
+            finger.velocity_y += (sample_y - finger.velocity_y) * weight;
+        }
+        else {
+            finger.velocity_x = sample_x;
+            finger.velocity_y = sample_y;
+            finger.has_velocity = true;
+        }
+    }
+
+    finger.x = x;
+    finger.y = y;
+    finger.moved_us = now_us;
+    const float dx = x - finger.start_x;
+    const float dy = y - finger.start_y;
+    finger.travel_sq = std::max(finger.travel_sq, dx * dx + dy * dy);
+    return true;
+}
+
+void GestureRecognizer::VelocityAt(const Finger& finger, uint64_t now_us, float* out_x, float* out_y) {
+    const bool moving = finger.has_velocity && now_us - finger.moved_us <= VELOCITY_HOLD_US;
+    *out_x = moving ? finger.velocity_x : 0.0f;
+    *out_y = moving ? finger.velocity_y : 0.0f;
+}
+
+bool GestureRecognizer::LiftGesture(const Finger& finger, uint64_t now_us, DSGestureEvent* out) {
+    const float dx = finger.x - finger.start_x;
+    const float dy = finger.y - finger.start_y;
+    const uint32_t duration_us = DurationUs(finger.start_us, now_us);
+    float velocity_x;
+    float velocity_y;
+    VelocityAt(finger, now_us, &velocity_x, &velocity_y);
+
+    uint8_t type;
+    if (finger.travel_sq <= TAP_MAX_TRAVEL * TAP_MAX_TRAVEL && duration_us <= TAP_MAX_DURATION_US) {
+        const bool double_tap = has_tap_ && finger.start_us >= tap_us_ &&
+                                finger.start_us - tap_us_ <= DOUBLE_TAP_MAX_GAP_US &&
+                                std::hypot(finger.x - tap_x_, finger.y - tap_y_) <= DOUBLE_TAP_MAX_DISTANCE;
+        type = double_tap ? DS_GESTURE_DOUBLE_TAP : DS_GESTURE_TAP;
+        // A third tap starts over rather than making another double tap
+        has_tap_ = !double_tap;
+        tap_us_ = now_us;
+        tap_x_ = finger.x;
+        tap_y_ = finger.y;
+    }
+    else if (dx * dx + dy * dy >= SWIPE_MIN_DISTANCE * SWIPE_MIN_DISTANCE &&
+             velocity_x * velocity_x + velocity_y * velocity_y >= SWIPE_MIN_SPEED * SWIPE_MIN_SPEED) {
+        type = DS_GESTURE_SWIPE;
+        has_tap_ = false;
+    }
+    else {
+        has_tap_ = false;
+        return false;
+    }
+
+    *out = DSGestureEvent{};
+    out->duration_us = duration_us;
+    out->type = type;
+    out->phase = DS_GESTURE_PHASE_END;
+    out->x = finger.x;
+    out->y = finger.y;
+    out->delta_x = dx;
+    out->delta_y = dy;
+    out->velocity_x = velocity_x;
+    out->velocity_y = velocity_y;
+    out->scale = 1.0f;
+    return true;
+}
+
+void GestureRecognizer::TwoFingerGesture(DSGesturePhase phase, uint64_t now_us, DSGestureEvent* out) {
+    const Finger& a = fingers_[0];
+    const Finger& b = fingers_[1];
+    float a_vx, a_vy, b_vx, b_vy;
+    VelocityAt(a, now_us, &a_vx, &a_vy);
+    VelocityAt(b, now_us, &b_vx, &b_vy);
+
+    const float mid_x = (a.x + b.x) * 0.5f;
+    const float mid_y = (a.y + b.y) * 0.5f;
+    const float dx = b.x - a.x;
+    const float dy = b.y - a.y;
+    const float distance = std::hypot(dx, dy);
+    const float base_distance = std::max(base_distance_, 1.0f);
+
+    *out = DSGestureEvent{};
+    out->duration_us = DurationUs(two_finger_start_us_, now_us);
+    out->type = (two_finger_ == TwoFinger::Pinch) ? DS_GESTURE_PINCH : DS_GESTURE_SCROLL;
+    out->phase = static_cast<uint8_t>(phase);
+    out->x = mid_x;
+    out->y = mid_y;
+    out->delta_x = mid_x - last_x_;
+    out->delta_y = mid_y - last_y_;
+    out->velocity_x = (a_vx + b_vx) * 0.5f;
+    out->velocity_y = (a_vy + b_vy) * 0.5f;
+    out->scale = distance / base_distance;
+    // Rate of change of the distance: relative velocity along the line between the fingers
+    if (distance > 0.0f) {
+        out->scale_velocity = (dx * (b_vx - a_vx) + dy * (b_vy - a_vy)) / distance / base_distance;
+    }
+
+    last_x_ = mid_x;
+    last_y_ = mid_y;
+}
+
+} // namespace protocol
+} // namespace dualsense
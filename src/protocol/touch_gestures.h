@@ -0,0 +1,76 @@
+// Touchpad Gesture Recognition
+// Incremental state machine fed with every published input state: follows
+// the two touch slots, measures finger velocities on the device sensor clock
+// and emits tap, double-tap, swipe, pinch and two-finger scroll gestures.
+// Fixed size, no allocations.
+
+#pragma once
+
+#include "../../include/dualsense.h"
+#include <stddef.h>
+#include <stdint.h>
+
+namespace dualsense {
+namespace protocol {
+
+// Upper bound of gestures produced by a single report
+// (two-finger END + tap/swipe + two-finger BEGIN/UPDATE)
+constexpr size_t MAX_GESTURES_PER_REPORT = 3;
+
+// One instance per device, fed from the input path only
+class GestureRecognizer {
+public:
+    // Forget fingers, the pending tap and any gesture in progress (new connection)
+    void Reset();
+
+    // Advance by one published state; writes up to MAX_GESTURES_PER_REPORT
+    // gestures to out and returns how many
+    size_t Process(const DSInputState& state, uint32_t sequence, DSGestureEvent* out);
+
+private:
+    struct Finger {
+        bool active;
+        uint8_t id;
+        float x, y;                 // Latest position
+        float start_x, start_y;
+        uint64_t start_us;
+        uint64_t moved_us;          // When the position last changed
+        float travel_sq;            // Largest squared distance from the start
+        bool has_velocity;
+        float velocity_x, velocity_y;
+    };
+
+    enum class TwoFinger : uint8_t {
+        None,       // Fewer than two fingers so far
+        Pending,    // Two fingers down, not moved enough to tell pinch from scroll
+        Pinch,
+        Scroll,
+        Finished    // Gesture over; waits until the touchpad is clear
+    };
+
+    static void Begin(Finger& finger, const DSTouchPoint& point, uint64_t now_us);
+    static bool Move(Finger& finger, const DSTouchPoint& point, uint64_t now_us);
+    static void VelocityAt(const Finger& finger, uint64_t now_us, float* out_x, float* out_y);
+
+    bool LiftGesture(const Finger& finger, uint64_t now_us, DSGestureEvent* out);
+    void TwoFingerGesture(DSGesturePhase phase, uint64_t now_us, DSGestureEvent* out);
+
+    Finger fingers_[2] = {};
+    uint8_t session_fingers_ = 0;   // Most fingers down at once since the touchpad was clear
+
+    TwoFinger two_finger_ = TwoFinger::None;
+    uint64_t two_finger_start_us_ = 0;
+    float base_distance_ = 0.0f;    // Finger distance when the second finger touched
+    float base_x_ = 0.0f;           // Midpoint then
+    float base_y_ = 0.0f;
+    float last_x_ = 0.0f;           // Midpoint at the previous two-finger event
+    float last_y_ = 0.0f;
+
+    bool has_tap_ = false;          // A tap that a second tap would make a double tap
+    uint64_t tap_us_ = 0;
+    float tap_x_ = 0.0f;
+    float tap_y_ = 0.0f;
+};
+
+} // namespace protocol
+} // namespace dualsense